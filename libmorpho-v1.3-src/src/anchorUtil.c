@@ -0,0 +1,580 @@
+/* LIBMORPHO
+ *
+ * anchorUtil.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file anchorUtil.c
+ */ 
+
+#include "anchorUtil.h"
+#include "dispatch.h"
+#include <math.h>
+
+/* Copies nbrColumns adjacent columns of an image, starting at *image, into
+ * a buffer where each column is stored contiguously (imageHeight pixels per
+ * column). The image is read row by row; its rows are stride pixels apart. */
+void anchor_gather_columns(uint8_t *image, int stride, int imageHeight, int nbrColumns, uint8_t *columns)
+{
+  morpho_isa->transpose(image, stride, columns, imageHeight, nbrColumns, imageHeight);
+}
+
+/* Inverse of anchor_gather_columns: writes nbrColumns contiguous columns
+ * back into the image, row by row. */
+void anchor_scatter_columns(uint8_t *columns, int stride, int imageHeight, int nbrColumns, uint8_t *image)
+{
+  morpho_isa->transpose(columns, imageHeight, image, stride, imageHeight, nbrColumns);
+}
+
+/* Vertical pass of van Herk/Gil-Werman on a stream of rows.
+ *
+ * The rows are pushed one at a time into a ring of size rows, and grouped
+ * into blocks of size rows: the suffix extrema of the previous block are 
+ * combined with the running prefix extremum of the current block, so that
+ * each output row costs one comparison per pixel whatever size. The buffer
+ * holds ANCHOR_RING_SIZE(width, size) bytes. */
+void anchor_ring_init(struct anchor_ring *ring, uint8_t *buffer, int width, int size, int dilation)
+{
+  ring->current = buffer;
+  ring->suffix = ring->current+size*width;
+  ring->prefix = ring->suffix+size*width;
+  ring->width = width;
+  ring->size = size;
+  ring->combine = (dilation) ? morpho_isa->rows_max : morpho_isa->rows_min;
+}
+
+/* Where the caller writes row u of the stream, before pushing it */
+uint8_t *anchor_ring_row(struct anchor_ring *ring, int u)
+{
+  return ring->current+(u%ring->size)*ring->width;
+}
+
+/* Pushes row u; once u >= size-1, the extremum of the rows u-size+1 to u
+ * is written into out */
+void anchor_ring_push(struct anchor_ring *ring, int u, uint8_t *out)
+{
+  uint8_t *row,*aux;
+  int 	i,j,width;
+
+  width = ring->width;
+  j = u%ring->size;
+  row = ring->current+j*width;
+
+  /* Running extremum from the beginning of the block */
+  if (0 == j)
+    memcpy(ring->prefix, row, width);
+  else
+    ring->combine(ring->prefix, row, ring->prefix, width);
+
+  if (u >= ring->size-1)
+    {
+      if (j == ring->size-1)
+	memcpy(out, ring->prefix, width);
+      else
+	ring->combine(ring->suffix+(j+1)*width, ring->prefix, out, width);
+    }
+
+  /* The block is complete: turn it into suffix extrema */
+  if (j == ring->size-1)
+    {
+      for (i=ring->size-2; i>=0; i--)
+	ring->combine(ring->current+i*width, ring->current+(i+1)*width, ring->current+i*width, width);
+      aux = ring->suffix; ring->suffix = ring->current; ring->current = aux;
+    }
+}
+
+/* Two-dimensional erosion (dilation=0) or dilation (dilation=1) by a 
+ * seWidth x seHeight rectangle, computed in a single sweep over the rows.
+ *
+ * Each input row goes through the horizontal line kernel and is pushed 
+ * into an anchor_ring of seHeight rows, which produces the output rows as
+ * soon as enough rows are available. Rows outside the image are replaced 
+ * by the neutral value, which gives the same border handling as the 
+ * separable anchor operators.
+ *
+ * Without kernel (NULL), the rows are taken as they are and only the 
+ * vertical pass is performed.
+ *
+ * The extra memory is (2*seHeight+1)*imageWidth bytes. Output row y is 
+ * written once input row y+seHeight/2 has been read, hence imageIn and 
+ * imageOut may be the same buffer (with the same stride). */
+int anchor_fused_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, anchor_line_kernel kernel, int dilation, struct morpho_ctx *ctx)
+{
+  uint8_t *buffer,*row;
+  struct anchor_ring ring;
+  int 	*histo;
+  struct morpho_histogram h;
+  int 	u,y,t,half,nbrRows;
+
+  histo = (int *)morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int));
+  buffer = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, ANCHOR_RING_SIZE(imageWidth, seHeight)*sizeof(uint8_t));
+  if ( (histo == NULL) || (buffer == NULL) ) {
+    perror("Malloc");
+    morpho_scratch_release(ctx, histo); morpho_scratch_release(ctx, buffer);
+    return MORPHO_ERROR;
+  }
+  histo_init(&h, histo, 0, morpho_ctx_histogram(ctx));
+  anchor_ring_init(&ring, buffer, imageWidth, seHeight, dilation);
+
+  half = seHeight/2;
+  nbrRows = imageHeight+seHeight-1;
+
+  /* Virtual row u holds the horizontal pass of image row u-half */
+  for (u=0; u<nbrRows; u++)
+    {
+      row = anchor_ring_row(&ring, u);
+      t = u-half;
+      if ( (t>=0) && (t<imageHeight) && (kernel == NULL) )
+	memcpy(row, imageIn+t*inStride, imageWidth);
+      else if ( (t>=0) && (t<imageHeight) )
+	kernel(imageIn+t*inStride, row, imageWidth, seWidth, &h);
+      else
+	memset(row, (dilation) ? 0 : 255, imageWidth);
+
+      /* Output row y covers the virtual rows y to u */
+      y = u-seHeight+1;
+      anchor_ring_push(&ring, u, imageOut+((y >= 0) ? y : 0)*outStride);
+    }
+
+  morpho_scratch_release(ctx, buffer);
+  morpho_scratch_release(ctx, histo);
+  return MORPHO_SUCCESS;
+}
+
+/* Prefix and suffix extrema of line[0..length-1], by blocks of size 
+ * values starting at 0 (van Herk/Gil-Werman) */
+static void blocks_min(uint8_t *line, uint8_t *prefix, uint8_t *suffix, int length, int size)
+{
+  int b,e,p;
+
+  for (b=0; b<length; b+=size)
+    {
+      e = (b+size < length) ? b+size : length;
+      prefix[b] = line[b];
+      for (p=b+1; p<e; p++)
+	prefix[p] = (line[p] < prefix[p-1]) ? line[p] : prefix[p-1];
+      suffix[e-1] = line[e-1];
+      for (p=e-2; p>=b; p--)
+	suffix[p] = (line[p] < suffix[p+1]) ? line[p] : suffix[p+1];
+    }
+}
+
+static void blocks_max(uint8_t *line, uint8_t *prefix, uint8_t *suffix, int length, int size)
+{
+  int b,e,p;
+
+  for (b=0; b<length; b+=size)
+    {
+      e = (b+size < length) ? b+size : length;
+      prefix[b] = line[b];
+      for (p=b+1; p<e; p++)
+	prefix[p] = (line[p] > prefix[p-1]) ? line[p] : prefix[p-1];
+      suffix[e-1] = line[e-1];
+      for (p=e-2; p>=b; p--)
+	suffix[p] = (line[p] > suffix[p+1]) ? line[p] : suffix[p+1];
+    }
+}
+
+/* Erosion (dilation=0) or dilation (dilation=1) of the row in by an 
+ * horizontal segment of size (odd) pixels, into out. line, prefix and 
+ * suffix hold imageWidth+2*(size/2) values each; the size/2 first and last
+ * values of line must be the neutral value. */
+static void vhgw_row(uint8_t *in, uint8_t *out, uint8_t *line, uint8_t *prefix, uint8_t *suffix, int imageWidth, int size, int dilation)
+{
+  int	half,length;
+
+  half = size/2;
+  length = imageWidth+2*half;
+  memcpy(line+half, in, imageWidth);
+  if (dilation)
+    {
+      blocks_max(line, prefix, suffix, length, size);
+      morpho_isa->rows_max(suffix, prefix+2*half, out, imageWidth);
+    }
+  else
+    {
+      blocks_min(line, prefix, suffix, length, size);
+      morpho_isa->rows_min(suffix, prefix+2*half, out, imageWidth);
+    }
+}
+
+/* Erosion (dilation=0) or dilation (dilation=1) by an horizontal segment
+ * of size (odd) pixels, with the van Herk/Gil-Werman algorithm.
+ *
+ * Each row is copied between size/2 neutral values; output pixel x covers
+ * the values x to x+size-1 of this padded line, that is the suffix extremum
+ * of x and the prefix extremum of x+size-1 in the blocks of size values. 
+ * The cost is three comparisons per pixel whatever the content of the 
+ * image, and the rows are read before being written, so that imageIn and
+ * imageOut may be the same buffer. */
+int anchor_vhgw_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, int dilation, struct morpho_ctx *ctx)
+{
+  uint8_t *line;
+  int	length,j;
+
+  length = imageWidth+2*(size/2);
+  if ((line=(uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, 3*length*sizeof(uint8_t))) == NULL) {
+    perror("Malloc");
+    return MORPHO_ERROR;
+  }
+
+  memset(line, (dilation) ? 0 : 255, length);
+  for (j=0; j<imageHeight; j++)
+    vhgw_row(imageIn+j*inStride, imageOut+j*outStride, line, line+length, line+2*length, imageWidth, size, dilation);
+
+  morpho_scratch_release(ctx, line);
+  return MORPHO_SUCCESS;
+}
+
+/* Last pass of a top-hat: the erosion (dilation=0) or dilation 
+ * (dilation=1) of imageIn by an horizontal segment of size (odd) pixels, 
+ * subtracted row by row from imageRef (dilation=1, white top-hat) or from 
+ * which imageRef is subtracted (dilation=0, black top-hat). The engine is
+ * chosen by anchor_use_vhgw, as for the erosions and dilations. Each row 
+ * goes through a scratch row, so that imageOut may be imageRef (with the 
+ * same stride), and no intermediate image is needed. */
+int anchor_residue_horizontal(uint8_t *imageIn, uint8_t *imageRef, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int refStride, int outStride, int size, int dilation, struct morpho_ctx *ctx)
+{
+  uint8_t *row,*line;
+  int	*histo;
+  struct morpho_histogram h;
+  int	length,j,useVhgw;
+
+  useVhgw = anchor_use_vhgw(imageIn, imageWidth, imageHeight, inStride, size, 0, ctx);
+  length = imageWidth+2*(size/2);
+  histo = (int *)morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int));
+  row = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, (imageWidth+((useVhgw) ? 3*length : 0))*sizeof(uint8_t));
+  if ( (histo == NULL) || (row == NULL) ) {
+    perror("Malloc");
+    morpho_scratch_release(ctx, histo); morpho_scratch_release(ctx, row);
+    return MORPHO_ERROR;
+  }
+  histo_init(&h, histo, 0, morpho_ctx_histogram(ctx));
+  line = row+imageWidth;
+  if (useVhgw) { memset(line, (dilation) ? 0 : 255, length); }
+
+  for (j=0; j<imageHeight; j++)
+    {
+      if (useVhgw)
+	vhgw_row(imageIn+j*inStride, row, line, line+length, line+2*length, imageWidth, size, dilation);
+      else if (dilation)
+	dilationByAnchor_line(imageIn+j*inStride, row, imageWidth, size, &h);
+      else
+	erosionByAnchor_line(imageIn+j*inStride, row, imageWidth, size, &h);
+      if (dilation)
+	morpho_isa->rows_sub(imageRef+j*refStride, row, imageOut+j*outStride, imageWidth);
+      else
+	morpho_isa->rows_sub(row, imageRef+j*refStride, imageOut+j*outStride, imageWidth);
+    }
+
+  morpho_scratch_release(ctx, row);
+  morpho_scratch_release(ctx, histo);
+  return MORPHO_SUCCESS;
+}
+
+/* Same as anchor_vhgw_horizontal, with a vertical segment: the vertical
+ * pass of anchor_fused_2D, applied to the rows of the input image */
+int anchor_vhgw_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, int dilation, struct morpho_ctx *ctx)
+{
+  return anchor_fused_2D(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, 0, size, NULL, dilation, ctx);
+}
+
+/* Number of rows sampled by anchor_use_vhgw */
+#define	ENGINE_SAMPLE_ROWS	8
+
+/* Tells if the erosion or dilation of image by an horizontal (vertical=0)
+ * or vertical (vertical=1) segment of size pixels should use the van 
+ * Herk/Gil-Werman engine rather than the anchors.
+ *
+ * The vertical engine works on whole rows at once and has always been 
+ * found faster. The horizontal one pads each row with size-1 values; it is
+ * kept as long as the padding is less than the row itself. For larger 
+ * segments, the anchors are preferred unless a sample of rows shows that 
+ * the image is mostly flat, where their border handling dominates. */
+int anchor_use_vhgw(uint8_t *image, int imageWidth, int imageHeight, int stride, int size, int vertical, struct morpho_ctx *ctx)
+{
+  uint8_t *row;
+  int	i,j,step,flat,nbrSamples;
+
+  switch (morpho_ctx_engine(ctx))
+    {
+    case MORPHO_ENGINE_ANCHOR: return 0;
+    case MORPHO_ENGINE_VHGW: return 1;
+    }
+  if ( vertical || (2*size <= imageWidth) ) { return 1; }
+
+  /* Proportion of pixels equal to their left neighbour */
+  step = (imageHeight > ENGINE_SAMPLE_ROWS) ? imageHeight/ENGINE_SAMPLE_ROWS : 1;
+  flat = 0; nbrSamples = 0;
+  for (j=step/2; j<imageHeight; j+=step)
+    {
+      row = image+j*stride;
+      for (i=1; i<imageWidth; i++) { flat += (row[i] == row[i-1]); }
+      nbrSamples += imageWidth-1;
+    }
+  return (2*flat > nbrSamples);
+}
+
+/* Oriented lines.
+ *
+ * A line of angle degrees (counterclockwise from the horizontal axis) is 
+ * traced along its major axis, x if it is closer to the horizontal and y 
+ * otherwise: the pixel of position i along the major axis is shifted by
+ * offset[i] = round(i*slope) along the minor axis. The translations of 
+ * this discrete line along the minor axis partition the image into 
+ * profiles, and each pixel belongs to exactly one of them. */
+
+/* Slope of a line of angle degrees with respect to its major axis, which
+ * is x (1 returned) or y (0 returned); y points downwards */
+static int oriented_slope(double angle, double *slope)
+{
+  double a,c,s;
+
+  a = angle*3.14159265358979323846/180.0;
+  c = cos(a); s = sin(a);
+  if (fabs(c) >= fabs(s))
+    {
+      *slope = -s/c;
+      return 1;
+    }
+  *slope = -c/s;
+  return 0;
+}
+
+/* Tells if the discrete lines of angle degrees are the rows 
+ * (ANCHOR_LINE_HORIZONTAL) or the columns (ANCHOR_LINE_VERTICAL) of an
+ * imageWidth x imageHeight image, or neither (ANCHOR_LINE_OBLIQUE) */
+int anchor_oriented_axis(double angle, int imageWidth, int imageHeight)
+{
+  double slope;
+  int	majorX,length;
+
+  majorX = oriented_slope(angle, &slope);
+  length = (majorX) ? imageWidth : imageHeight;
+  if (0 != (int)floor((length-1)*fabs(slope)+0.5)) { return ANCHOR_LINE_OBLIQUE; }
+  return (majorX) ? ANCHOR_LINE_HORIZONTAL : ANCHOR_LINE_VERTICAL;
+}
+
+/* Erosion (dilation=0) or dilation (dilation=1) of a profile of length 
+ * pixels, not longer than the segment of size (odd) pixels, clipped at 
+ * both ends. Each window then reaches an end of the profile: it is the 
+ * running extremum from the left or from the right. */
+static void oriented_short(uint8_t *in, uint8_t *out, int length, int size, int dilation)
+{
+  int	x,i,first,half;
+  uint8_t v;
+
+  half = size/2;
+
+  /* Windows that reach the left end only */
+  out[0] = in[0];
+  for (i=1; i<length; i++)
+    out[i] = ( (dilation) ? (in[i] > out[i-1]) : (in[i] < out[i-1]) ) ? in[i] : out[i-1];
+  for (x=0; x+half<length-1; x++) { out[x] = out[x+half]; }
+
+  /* Windows that reach the right end */
+  v = in[length-1]; i = length-1;
+  for (x=length-1; (x>=0) && (x+half>=length-1); x--)
+    {
+      first = (x-half < 0) ? 0 : x-half;
+      while (i > first)
+	{
+	  i--;
+	  if ( (dilation) ? (in[i] > v) : (in[i] < v) ) { v = in[i]; }
+	}
+      out[x] = v;
+    }
+}
+
+/* Profiles of the lines of an angle, shared by the bands of profiles */
+struct	oriented_job
+	{
+	uint8_t	*imageIn,*imageOut;
+	uint8_t	*label;		/* index of the best angle, or NULL */
+	int	inMajor,inMinor,outMajor,outMinor;
+	int	nbrMajor,nbrMinor;
+	int	*offset;	/* along the minor axis, for each position */
+	int	firstProfile,nbrBlocks;
+	int	size;
+	anchor_line_kernel kernel;
+	anchor_filter_kernel filter;
+	int	dilation;
+	int	fold;		/* keep the extremum with imageOut (1) or overwrite it (0) */
+	int	angleIndex;
+	int	histogram;
+	uint8_t	*buffer;	/* ANCHOR_ORIENTED_BAND_SIZE bytes per band */
+	};
+
+/* Bytes of scratch memory of a band of profiles */
+#define	ANCHOR_ORIENTED_BAND_SIZE(nbrMajor)	((256+ANCHOR_COLUMN_BLOCK)*sizeof(int)+2*ANCHOR_COLUMN_BLOCK*(size_t)(nbrMajor))
+
+/* Processes the blocks of ANCHOR_COLUMN_BLOCK adjacent profiles of a band.
+ *
+ * At a given position along the major axis, the pixels of a block are 
+ * adjacent along the minor axis: they are gathered a row at a time for the
+ * lines closer to the vertical, and as the columns of the vertical 
+ * operators otherwise. Each profile is processed as a line of the image, 
+ * so that the cost per pixel is that of the 1D operators and does not 
+ * depend on the length of the segment. All the profiles of a block are 
+ * read before any is written. */
+static int oriented_band(void *arg, int band, int nbrBands)
+{
+  struct oriented_job *job = (struct oriented_job *)arg;
+  struct morpho_histogram h;
+  uint8_t *profilesIn,*profilesOut,*result,*p,*q;
+  int	*histo,*length;
+  int	i,k,b,o,minor,first,last,nbrMajor;
+  uint8_t v;
+
+  nbrMajor = job->nbrMajor;
+  histo = (int *)(job->buffer+band*ANCHOR_ORIENTED_BAND_SIZE(nbrMajor));
+  length = histo+256;
+  profilesIn = (uint8_t *)(length+ANCHOR_COLUMN_BLOCK);
+  profilesOut = profilesIn+ANCHOR_COLUMN_BLOCK*nbrMajor;
+  result = (job->kernel != NULL) ? profilesOut : profilesIn;
+  histo_init(&h, histo, 0, job->histogram);
+
+  /* Profile o holds the pixels (i, o+offset[i]) inside the image */
+  for (b=morpho_band_first(job->nbrBlocks, band, nbrBands); b<morpho_band_first(job->nbrBlocks, band+1, nbrBands); b++)
+    {
+      o = job->firstProfile+b*ANCHOR_COLUMN_BLOCK;
+      memset(length, 0, ANCHOR_COLUMN_BLOCK*sizeof(int));
+      for (i=0; i<nbrMajor; i++)
+	{
+	  minor = o+job->offset[i];
+	  first = (minor < 0) ? -minor : 0;
+	  last = (job->nbrMinor-minor < ANCHOR_COLUMN_BLOCK) ? job->nbrMinor-minor : ANCHOR_COLUMN_BLOCK;
+	  p = job->imageIn+i*job->inMajor+(minor+first)*job->inMinor;
+	  for (k=first; k<last; k++, p+=job->inMinor)
+	    profilesIn[k*nbrMajor+length[k]++] = *p;
+	}
+
+      for (k=0; k<ANCHOR_COLUMN_BLOCK; k++)
+	{
+	  if (0 == length[k]) { continue; }
+	  p = profilesIn+k*nbrMajor;
+	  if (job->kernel == NULL)
+	    job->filter(p, length[k], job->size, &h);
+	  else if (length[k] > job->size)
+	    job->kernel(p, profilesOut+k*nbrMajor, length[k], job->size, &h);
+	  else
+	    oriented_short(p, profilesOut+k*nbrMajor, length[k], job->size, job->dilation);
+	}
+
+      memset(length, 0, ANCHOR_COLUMN_BLOCK*sizeof(int));
+      for (i=0; i<nbrMajor; i++)
+	{
+	  minor = o+job->offset[i];
+	  first = (minor < 0) ? -minor : 0;
+	  last = (job->nbrMinor-minor < ANCHOR_COLUMN_BLOCK) ? job->nbrMinor-minor : ANCHOR_COLUMN_BLOCK;
+	  p = job->imageOut+i*job->outMajor+(minor+first)*job->outMinor;
+	  for (k=first; k<last; k++, p+=job->outMinor)
+	    {
+	      v = result[k*nbrMajor+length[k]++];
+	      if (!job->fold)
+		*p = v;
+	      else if ( (job->dilation) ? (v < *p) : (v > *p) )
+		{
+		  *p = v;
+		  if (job->label != NULL)
+		    {
+		      q = job->label+(p-job->imageOut);
+		      *q = job->angleIndex;
+		    }
+		}
+	    }
+	}
+    }
+  return MORPHO_SUCCESS;
+}
+
+/* Applies a line kernel (erosion or dilation, the other one being NULL) 
+ * or an in place filter (opening or closing) by a segment of size pixels
+ * to the profiles of the lines of each of the nbrAngles angles.
+ *
+ * The result of the first angle is written into imageOut; those of the 
+ * next angles are folded into it by their maximum, or their minimum when
+ * dilation is set (closings). label, when not NULL, receives the index of
+ * the first angle that gave the value of each pixel; its rows are 
+ * outStride pixels apart. Only one angle is computed at a time, by as many
+ * bands of profiles as threads of the context, and no intermediate image 
+ * is used: with one angle, imageIn and imageOut may be the same buffer, 
+ * with the same stride; with more angles, they must not overlap. */
+int anchor_oriented_bank(uint8_t *imageIn, uint8_t *imageOut, uint8_t *label, int imageWidth, int imageHeight, int inStride, int outStride, int size, double *angles, int nbrAngles, anchor_line_kernel kernel, anchor_filter_kernel filter, int dilation, struct morpho_ctx *ctx)
+{
+  struct oriented_job job;
+  double slope;
+  int	a,i,j,majorX,nbrBands,offsetMin,offsetMax,maxMajor,err;
+
+  maxMajor = (imageWidth > imageHeight) ? imageWidth : imageHeight;
+  nbrBands = morpho_resolve_threads(morpho_ctx_threads(ctx), (maxMajor+2*ANCHOR_COLUMN_BLOCK-1)/ANCHOR_COLUMN_BLOCK);
+  job.offset = (int *)morpho_scratch(ctx, MORPHO_SLOT_LINES, maxMajor*sizeof(int)+nbrBands*ANCHOR_ORIENTED_BAND_SIZE(maxMajor));
+  if (job.offset == NULL) {
+    perror("Malloc");
+    return MORPHO_ERROR;
+  }
+  job.buffer = (uint8_t *)(job.offset+maxMajor);
+  job.imageIn = imageIn;
+  job.imageOut = imageOut;
+  job.label = label;
+  job.size = size;
+  job.kernel = kernel;
+  job.filter = filter;
+  job.dilation = dilation;
+  job.histogram = morpho_ctx_histogram(ctx);
+
+  if (label != NULL)
+    {
+      for (j=0; j<imageHeight; j++) { memset(label+j*outStride, 0, imageWidth); }
+    }
+
+  err = MORPHO_SUCCESS;
+  for (a=0; (a<nbrAngles) && (MORPHO_SUCCESS == err); a++)
+    {
+      majorX = oriented_slope(angles[a], &slope);
+      job.nbrMajor = (majorX) ? imageWidth : imageHeight;
+      job.nbrMinor = (majorX) ? imageHeight : imageWidth;
+      job.inMajor = (majorX) ? 1 : inStride;
+      job.inMinor = (majorX) ? inStride : 1;
+      job.outMajor = (majorX) ? 1 : outStride;
+      job.outMinor = (majorX) ? outStride : 1;
+
+      offsetMin = 0; offsetMax = 0;
+      for (i=0; i<job.nbrMajor; i++)
+	{
+	  job.offset[i] = (int)floor(i*slope+0.5);
+	  if (job.offset[i] < offsetMin) { offsetMin = job.offset[i]; }
+	  if (job.offset[i] > offsetMax) { offsetMax = job.offset[i]; }
+	}
+      job.firstProfile = -offsetMax;
+      job.nbrBlocks = (job.nbrMinor-offsetMin+offsetMax+ANCHOR_COLUMN_BLOCK-1)/ANCHOR_COLUMN_BLOCK;
+      job.fold = (a > 0);
+      job.angleIndex = a;
+
+      err = morpho_run_bands(oriented_band, &job, nbrBands);
+    }
+
+  morpho_scratch_release(ctx, job.offset);
+  return err;
+}
+
+/* Same as anchor_oriented_bank, for a single angle */
+int anchor_oriented(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, double angle, anchor_line_kernel kernel, anchor_filter_kernel filter, int dilation, struct morpho_ctx *ctx)
+{
+  return anchor_oriented_bank(imageIn, imageOut, NULL, imageWidth, imageHeight, inStride, outStride, size, &angle, 1, kernel, filter, dilation, ctx);
+}
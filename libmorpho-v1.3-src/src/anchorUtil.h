@@ -0,0 +1,88 @@
+/* LIBMORPHO
+ *
+ * anchorUtil.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "libmorpho.h"
+#include "threadPool.h"
+#include "workspace.h"
+#include "histogram.h"
+
+#ifndef __ANCHORUTIL__
+#define __ANCHORUTIL__
+
+/* Parameters shared by the bands of a multithreaded anchor operation */
+struct	anchor_job
+	{
+	uint8_t	*imageIn,*imageOut;
+	int	imageWidth,imageHeight;
+	int	inStride,outStride;
+	int	size;
+	int	histogram;	/* MORPHO_HISTOGRAM_LINEAR or MORPHO_HISTOGRAM_BITMAP */
+	};
+
+/* Number of adjacent columns processed together by the vertical operators.
+   Rows of the input are read ANCHOR_COLUMN_BLOCK bytes at a time, which
+   fills whole cache lines instead of touching one byte per line. */
+#define	ANCHOR_COLUMN_BLOCK	64
+
+/* Line kernel of an erosion or a dilation: processes imageWidth pixels
+   with a segment of size pixels and a scratch histogram of 256 values */
+typedef void (*anchor_line_kernel)(uint8_t *in, uint8_t *out, int imageWidth, int size, struct morpho_histogram *h);
+
+/* Line kernel of an opening or a closing, computed in place */
+typedef void (*anchor_filter_kernel)(uint8_t *out, int imageWidth, int size, struct morpho_histogram *h);
+
+/* Discrete lines of a given angle, as classified by anchor_oriented_axis */
+#define	ANCHOR_LINE_HORIZONTAL	0
+#define	ANCHOR_LINE_VERTICAL	1
+#define	ANCHOR_LINE_OBLIQUE	2
+
+/* Vertical pass of van Herk/Gil-Werman fed with one row at a time */
+struct	anchor_ring
+	{
+	uint8_t	*current,*suffix,*prefix;
+	int	width,size;
+	void	(*combine)(uint8_t *a, uint8_t *b, uint8_t *out, int n);
+	};
+
+/* Bytes of the buffer of an anchor_ring */
+#define	ANCHOR_RING_SIZE(width,size)	((size_t)(2*(size)+1)*(width))
+
+/* anchorUtil.c */
+void anchor_gather_columns(uint8_t *image, int stride, int imageHeight, int nbrColumns, uint8_t *columns);
+void anchor_scatter_columns(uint8_t *columns, int stride, int imageHeight, int nbrColumns, uint8_t *image);
+void anchor_ring_init(struct anchor_ring *ring, uint8_t *buffer, int width, int size, int dilation);
+uint8_t *anchor_ring_row(struct anchor_ring *ring, int u);
+void anchor_ring_push(struct anchor_ring *ring, int u, uint8_t *out);
+int anchor_fused_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, anchor_line_kernel kernel, int dilation, struct morpho_ctx *ctx);
+int anchor_vhgw_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, int dilation, struct morpho_ctx *ctx);
+int anchor_vhgw_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, int dilation, struct morpho_ctx *ctx);
+int anchor_residue_horizontal(uint8_t *imageIn, uint8_t *imageRef, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int refStride, int outStride, int size, int dilation, struct morpho_ctx *ctx);
+int anchor_use_vhgw(uint8_t *image, int imageWidth, int imageHeight, int stride, int size, int vertical, struct morpho_ctx *ctx);
+int anchor_oriented_axis(double angle, int imageWidth, int imageHeight);
+int anchor_oriented_bank(uint8_t *imageIn, uint8_t *imageOut, uint8_t *label, int imageWidth, int imageHeight, int inStride, int outStride, int size, double *angles, int nbrAngles, anchor_line_kernel kernel, anchor_filter_kernel filter, int dilation, struct morpho_ctx *ctx);
+int anchor_oriented(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, double angle, anchor_line_kernel kernel, anchor_filter_kernel filter, int dilation, struct morpho_ctx *ctx);
+
+/* erosionByAnchor.c */
+void erosionByAnchor_line(uint8_t *in, uint8_t *out, int imageWidth, int size, struct morpho_histogram *h);
+
+/* dilationByAnchor.c */
+void dilationByAnchor_line(uint8_t *in, uint8_t *out, int imageWidth, int size, struct morpho_histogram *h);
+
+#endif
@@ -19,13 +19,37 @@
  */
 
 #include "arbitraryUtil.h"
+#include "dispatch.h"
+
+/*******************************************************************/
+/* Number of bytes needed by the fronts of a seWidth*seHeight structuring
+   element or function: at most 8 fronts of seWidth*seHeight points, each 
+   point having 3 coordinates and 2 grey-levels, plus some alignment */
+size_t fronts_size(int seWidth, int seHeight)
+{
+return (size_t)8*seWidth*seHeight*(3*sizeof(int)+2*sizeof(uint8_t)) + 32*sizeof(double);
+}
+
+/*******************************************************************/
+/* Takes size bytes from the buffer of a store; the arrays of the fronts 
+   are all taken from a single buffer that is released at once */
+void *front_store_alloc(struct front_store *store, size_t size)
+{
+void	*p;
+
+size = (size+sizeof(double)-1) & ~(sizeof(double)-1);
+if (store->next+size > store->end) return NULL;
+p = store->next;
+store->next += size;
+return p;
+}
 
 /*******************************************************************/
 /* Analyse the fronts of the structuring element 
    and compute the origin 	*/
 int analyse_b( 	uint8_t *se, int seWidth, int seHeight, 
 		struct front *lf, struct front *rf, struct front *uf, struct front *df,
-		int ox, int oy)
+		int ox, int oy, struct front_store *store)
 {
 int	i,j,n;
 int	*x,*y;
@@ -60,8 +84,8 @@ n = 0;
 	/* Parameter entry and memory allocation */
 	lf->size = n;  
 	lf->pos = (int *)NULL;  
-	lf->x = (int *)malloc(n*sizeof(int));		x=lf->x;
-	lf->y = (int *)malloc(n*sizeof(int));		y=lf->y;
+	lf->x = (int *)front_store_alloc(store, n*sizeof(int));		x=lf->x;
+	lf->y = (int *)front_store_alloc(store, n*sizeof(int));		y=lf->y;
 	lf->value = NULL;
 	/* Coordinate entry */
 	n = 0;
@@ -94,8 +118,8 @@ n = 0;
 	/* Parameter entry and memory allocation */
 	rf->size = n;  
 	rf->pos = (int *)NULL;  
-	rf->x = (int *)malloc(n*sizeof(int));		x=rf->x;
-	rf->y = (int *)malloc(n*sizeof(int));		y=rf->y;
+	rf->x = (int *)front_store_alloc(store, n*sizeof(int));		x=rf->x;
+	rf->y = (int *)front_store_alloc(store, n*sizeof(int));		y=rf->y;
 	rf->value = NULL;
 	/* Coordinate entry */
 	n = 0;
@@ -128,8 +152,8 @@ n = 0;
 	/* Parameter entry and memory allocation */
 	uf->size = n;  
 	uf->pos = (int *)NULL;  
-	uf->x = (int *)malloc(n*sizeof(int));		x=uf->x;
-	uf->y = (int *)malloc(n*sizeof(int));		y=uf->y;
+	uf->x = (int *)front_store_alloc(store, n*sizeof(int));		x=uf->x;
+	uf->y = (int *)front_store_alloc(store, n*sizeof(int));		y=uf->y;
 	uf->value = NULL;
 	/* Coordinate entry */
 	n = 0;
@@ -162,8 +186,8 @@ n = 0;
 	/* Parameter entry and memory allocation */
 	df->size = n;  
 	df->pos = (int *)NULL;  
-	df->x = (int *)malloc(n*sizeof(int));		x=df->x;
-	df->y = (int *)malloc(n*sizeof(int));		y=df->y;
+	df->x = (int *)front_store_alloc(store, n*sizeof(int));		x=df->x;
+	df->y = (int *)front_store_alloc(store, n*sizeof(int));		y=df->y;
 	df->value = NULL;
 	/* Coordinate entry */
 	n = 0;
@@ -192,7 +216,7 @@ return MORPHO_SUCCESS;
 int analyse_b_gray( 	uint8_t *se, int seWidth, int seHeight, 
 		struct front *lf, struct front *rf, struct front *uf, struct front *df,
 		struct gfront *glf, struct gfront *grf, struct gfront *guf, struct gfront *gdf,
-		int ox, int oy)
+		int ox, int oy, struct front_store *store)
 {
 int	i,j,n;
 int	*x,*y;
@@ -227,9 +251,9 @@ n = 0;
 	/* Parameter entry and memory allocation */
 	lf->size = n;  
 	lf->pos = (int *)NULL;  
-	lf->x = (int *)malloc(n*sizeof(int));		x=lf->x;
-	lf->y = (int *)malloc(n*sizeof(int));		y=lf->y;
-	lf->value = (uint8_t *)malloc(n*sizeof(uint8_t));	value=lf->value;
+	lf->x = (int *)front_store_alloc(store, n*sizeof(int));		x=lf->x;
+	lf->y = (int *)front_store_alloc(store, n*sizeof(int));		y=lf->y;
+	lf->value = (uint8_t *)front_store_alloc(store, n*sizeof(uint8_t));	value=lf->value;
 	/* Coordinate entry */
 	n = 0;
 	   /* First column */
@@ -261,9 +285,9 @@ n = 0;
 	/* Parameter entry and memory allocation */
 	rf->size = n;  
 	rf->pos = (int *)NULL;  
-	rf->x = (int *)malloc(n*sizeof(int));		x=rf->x;
-	rf->y = (int *)malloc(n*sizeof(int));		y=rf->y;
-	rf->value = (uint8_t *)malloc(n*sizeof(uint8_t));	value=rf->value;
+	rf->x = (int *)front_store_alloc(store, n*sizeof(int));		x=rf->x;
+	rf->y = (int *)front_store_alloc(store, n*sizeof(int));		y=rf->y;
+	rf->value = (uint8_t *)front_store_alloc(store, n*sizeof(uint8_t));	value=rf->value;
 	/* Coordinate entry */
 	n = 0;
 	   /* Last column */
@@ -296,9 +320,9 @@ n = 0;
 	/* Parameter entry and memory allocation */
 	uf->size = n;  
 	uf->pos = (int *)NULL;  
-	uf->x = (int *)malloc(n*sizeof(int));		x=uf->x;
-	uf->y = (int *)malloc(n*sizeof(int));		y=uf->y;
-	uf->value = (uint8_t *)malloc(n*sizeof(uint8_t));	value=uf->value;
+	uf->x = (int *)front_store_alloc(store, n*sizeof(int));		x=uf->x;
+	uf->y = (int *)front_store_alloc(store, n*sizeof(int));		y=uf->y;
+	uf->value = (uint8_t *)front_store_alloc(store, n*sizeof(uint8_t));	value=uf->value;
 	/* Coordinate entry */
 	n = 0;
 	   /* First raw */
@@ -330,9 +354,9 @@ n = 0;
 	/* Parameter entry and memory allocation */
 	df->size = n;  
 	df->pos = (int *)NULL;  
-	df->x = (int *)malloc(n*sizeof(int));		x=df->x;
-	df->y = (int *)malloc(n*sizeof(int));		y=df->y;
-	df->value = (uint8_t *)malloc(n*sizeof(uint8_t));	value=df->value;
+	df->x = (int *)front_store_alloc(store, n*sizeof(int));		x=df->x;
+	df->y = (int *)front_store_alloc(store, n*sizeof(int));		y=df->y;
+	df->value = (uint8_t *)front_store_alloc(store, n*sizeof(uint8_t));	value=df->value;
 	/* Coordinate entry */
 	n = 0;
 	   /* Last raw */
@@ -364,10 +388,10 @@ n = 0;
 	/* Parameter entry and memory allocation */
 	glf->size = n;  
 	glf->pos = (int *)NULL;  
-	glf->x = (int *)malloc(n*sizeof(int));	x=glf->x;
-	glf->y = (int *)malloc(n*sizeof(int));	y=glf->y;
-	glf->av = (uint8_t *)malloc(n*sizeof(uint8_t));	av=glf->av;
-	glf->ap = (uint8_t *)malloc(n*sizeof(uint8_t));	ap=glf->ap;
+	glf->x = (int *)front_store_alloc(store, n*sizeof(int));	x=glf->x;
+	glf->y = (int *)front_store_alloc(store, n*sizeof(int));	y=glf->y;
+	glf->av = (uint8_t *)front_store_alloc(store, n*sizeof(uint8_t));	av=glf->av;
+	glf->ap = (uint8_t *)front_store_alloc(store, n*sizeof(uint8_t));	ap=glf->ap;
 	/* Coordinate entry */
 	n = 0;
 	/* All columns without the first one */
@@ -393,10 +417,10 @@ n = 0;
 	/* Parameter entry and memory allocation */
 	grf->size = n;  
 	grf->pos = (int *)NULL;  
-	grf->x = (int *)malloc(n*sizeof(int));	x=grf->x;
-	grf->y = (int *)malloc(n*sizeof(int));	y=grf->y;
-	grf->av = (uint8_t *)malloc(n*sizeof(uint8_t));	av=grf->av;
-	grf->ap = (uint8_t *)malloc(n*sizeof(uint8_t));	ap=grf->ap;
+	grf->x = (int *)front_store_alloc(store, n*sizeof(int));	x=grf->x;
+	grf->y = (int *)front_store_alloc(store, n*sizeof(int));	y=grf->y;
+	grf->av = (uint8_t *)front_store_alloc(store, n*sizeof(uint8_t));	av=grf->av;
+	grf->ap = (uint8_t *)front_store_alloc(store, n*sizeof(uint8_t));	ap=grf->ap;
 	/* Coordinate entry */
 	n = 0;
 	/* All columns without the first one */
@@ -422,10 +446,10 @@ n = 0;
 	/* Parameter entry and memory allocation */
 	guf->size = n;  
 	guf->pos = (int *)NULL;  
-	guf->x = (int *)malloc(n*sizeof(int));	x=guf->x;
-	guf->y = (int *)malloc(n*sizeof(int));	y=guf->y;
-	guf->av = (uint8_t *)malloc(n*sizeof(uint8_t));	av=guf->av;
-	guf->ap = (uint8_t *)malloc(n*sizeof(uint8_t));	ap=guf->ap;
+	guf->x = (int *)front_store_alloc(store, n*sizeof(int));	x=guf->x;
+	guf->y = (int *)front_store_alloc(store, n*sizeof(int));	y=guf->y;
+	guf->av = (uint8_t *)front_store_alloc(store, n*sizeof(uint8_t));	av=guf->av;
+	guf->ap = (uint8_t *)front_store_alloc(store, n*sizeof(uint8_t));	ap=guf->ap;
 	/* Coordinate entry */
 	n = 0;
 	/* All raws without the last one */
@@ -451,10 +475,10 @@ n = 0;
 	/* Parameter entry and memory allocation */
 	gdf->size = n;  
 	gdf->pos = (int *)NULL;  
-	gdf->x = (int *)malloc(n*sizeof(int));	x=gdf->x;
-	gdf->y = (int *)malloc(n*sizeof(int));	y=gdf->y;
-	gdf->av = (uint8_t *)malloc(n*sizeof(uint8_t));	av=gdf->av;
-	gdf->ap = (uint8_t *)malloc(n*sizeof(uint8_t));	ap=gdf->ap;
+	gdf->x = (int *)front_store_alloc(store, n*sizeof(int));	x=gdf->x;
+	gdf->y = (int *)front_store_alloc(store, n*sizeof(int));	y=gdf->y;
+	gdf->av = (uint8_t *)front_store_alloc(store, n*sizeof(uint8_t));	av=gdf->av;
+	gdf->ap = (uint8_t *)front_store_alloc(store, n*sizeof(uint8_t));	ap=gdf->ap;
 	/* Coordinate entry */
 	n = 0;
 	/* All raws without the first one */
@@ -475,32 +499,32 @@ return MORPHO_SUCCESS;
 /****************************************************************/
 /* Modify the front structures to speed up the access operations 
    and look for an origin */ 
-int transform_b(int seWidth, struct front *l, struct front *r, struct front *u, struct front *d)
+int transform_b(int seWidth, struct front *l, struct front *r, struct front *u, struct front *d, struct front_store *store)
 {
 int 	i,size,*pos;
 int	*x,*y;
 
 /* Left front */
 size=(int)l->size; x=(int *)l->x; y=(int *)l->y;
-l->pos=(int *)malloc(size*sizeof(int)); pos=(int *)l->pos;
+l->pos=(int *)front_store_alloc(store, size*sizeof(int)); pos=(int *)l->pos;
 for (i=size-1; i>=0; i--)
 	pos[i] = (int)(x[i]+y[i]*seWidth);
 
 /* Right front */
 size=(int)r->size; x=(int *)r->x; y=(int *)r->y;
-r->pos=(int *)malloc(size*sizeof(int)); pos=(int *)r->pos;
+r->pos=(int *)front_store_alloc(store, size*sizeof(int)); pos=(int *)r->pos;
 for (i=size-1; i>=0; i--)
 	pos[i] = (int)(x[i]+y[i]*seWidth);
 
 /* Upper front */
 size=(int)u->size; x=(int *)u->x; y=(int *)u->y;
-u->pos=(int *)malloc(size*sizeof(int)); pos=(int *)u->pos;
+u->pos=(int *)front_store_alloc(store, size*sizeof(int)); pos=(int *)u->pos;
 for (i=size-1; i>=0; i--)
 	pos[i] = (int)(x[i]+y[i]*seWidth);
 
 /* Down front */
 size=(int)d->size; x=(int *)d->x; y=(int *)d->y;
-d->pos=(int *)malloc(size*sizeof(int)); pos=(int *)d->pos;
+d->pos=(int *)front_store_alloc(store, size*sizeof(int)); pos=(int *)d->pos;
 for (i=size-1; i>=0; i--)
 	pos[i] = (int)(x[i]+y[i]*seWidth);
 
@@ -512,56 +536,57 @@ return MORPHO_SUCCESS;
    and look for an origin */ 
 int transform_b_gray(int seWidth,
 		struct front *l, struct front *r, struct front *u, struct front *d,
-		struct gfront *gl, struct gfront *gr, struct gfront *gu, struct gfront *gd)
+		struct gfront *gl, struct gfront *gr, struct gfront *gu, struct gfront *gd,
+		struct front_store *store)
 {
 int 	i,size,*pos;
 int	*x,*y;
 
 /* Left front */
 size=(int)l->size; x=(int *)l->x; y=(int *)l->y;
-l->pos=(int *)malloc(size*sizeof(int)); pos=(int *)l->pos;
+l->pos=(int *)front_store_alloc(store, size*sizeof(int)); pos=(int *)l->pos;
 for (i=size-1; i>=0; i--)
 	pos[i] = (int)(x[i]+y[i]*seWidth);
 
 /* Right front */
 size=(int)r->size; x=(int *)r->x; y=(int *)r->y;
-r->pos=(int *)malloc(size*sizeof(int)); pos=(int *)r->pos;
+r->pos=(int *)front_store_alloc(store, size*sizeof(int)); pos=(int *)r->pos;
 for (i=size-1; i>=0; i--)
 	pos[i] = (int)(x[i]+y[i]*seWidth);
 
 /* Upper front */
 size=(int)u->size; x=(int *)u->x; y=(int *)u->y;
-u->pos=(int *)malloc(size*sizeof(int)); pos=(int *)u->pos;
+u->pos=(int *)front_store_alloc(store, size*sizeof(int)); pos=(int *)u->pos;
 for (i=size-1; i>=0; i--)
 	pos[i] = (int)(x[i]+y[i]*seWidth);
 
 /* Down front */
 size=(int)d->size; x=(int *)d->x; y=(int *)d->y;
-d->pos=(int *)malloc(size*sizeof(int)); pos=(int *)d->pos;
+d->pos=(int *)front_store_alloc(store, size*sizeof(int)); pos=(int *)d->pos;
 for (i=size-1; i>=0; i--)
 	pos[i] = (int)(x[i]+y[i]*seWidth);
 
 /* Grey-level left front */
 size=(int)gl->size; x=(int *)gl->x; y=(int *)gl->y;
-gl->pos=(int *)malloc(size*sizeof(int)); pos=(int *)gl->pos;
+gl->pos=(int *)front_store_alloc(store, size*sizeof(int)); pos=(int *)gl->pos;
 for (i=size-1; i>=0; i--)
 	pos[i] = (int)(x[i]+y[i]*seWidth);
 
 /* Grey-level right front */
 size=(int)gr->size; x=(int *)gr->x; y=(int *)gr->y;
-gr->pos=(int *)malloc(size*sizeof(int)); pos=(int *)gr->pos;
+gr->pos=(int *)front_store_alloc(store, size*sizeof(int)); pos=(int *)gr->pos;
 for (i=size-1; i>=0; i--)
 	pos[i] = (int)(x[i]+y[i]*seWidth);
 
 /* Grey-level upper front */
 size=(int)gu->size; x=(int *)gu->x; y=(int *)gu->y;
-gu->pos=(int *)malloc(size*sizeof(int)); pos=(int *)gu->pos;
+gu->pos=(int *)front_store_alloc(store, size*sizeof(int)); pos=(int *)gu->pos;
 for (i=size-1; i>=0; i--)
 	pos[i] = (int)(x[i]+y[i]*seWidth);
 
 /* Grey-level down front */
 size=(int)gd->size; x=(int *)gd->x; y=(int *)gd->y;
-gd->pos=(int *)malloc(size*sizeof(int)); pos=(int *)gd->pos;
+gd->pos=(int *)front_store_alloc(store, size*sizeof(int)); pos=(int *)gd->pos;
 for (i=size-1; i>=0; i--)
 	pos[i] = (int)(x[i]+y[i]*seWidth);
 
@@ -581,26 +606,527 @@ return MORPHO_SUCCESS;
 }
 
 /****************************************************************/
-void free_front(struct front *p)
+/* Columns of line "line" of the bordered image, grouped by the region
+   they are read in. Even lines are scanned from left to right on
+   columns 0..imageWidth+bh-1, odd lines from right to left on columns
+   imageWidth+bh..1. Returns the number of segments. */
+int scan_segments(struct volume_src *src, int line, struct scan_segment *seg)
 {
-if (p != NULL) 
-	{ 
-	if (p->x != NULL) free(p->x); 
-	if (p->y != NULL) free(p->y); 
-	if (p->pos != NULL) free(p->pos); 
-	if (p->value != NULL) free(p->value); 
+int	bh = src->bh, w = src->imageWidth;
+int	n,s;
+struct	scan_region *region[3];
+int	bound[4];
+
+if ( (line < src->bv) || (line > src->imageHeight) )
+	{
+	/* The window crosses the top or the bottom border */
+	region[0] = (line < src->bv) ? &src->top : &src->bottom;
+	n = 1;
+	if (line%2 == 0) { bound[0] = 0; bound[1] = w+bh; }
+	else { bound[0] = w+bh; bound[1] = 0; }
+	}
+else if (line%2 == 0)
+	{
+	region[0] = &src->left; region[1] = &src->image; region[2] = &src->right;
+	n = 3;
+	bound[0] = 0; bound[1] = bh; bound[2] = w; bound[3] = w+bh;
+	}
+else
+	{
+	region[0] = &src->right; region[1] = &src->image; region[2] = &src->left;
+	n = 3;
+	bound[0] = w+bh; bound[1] = w; bound[2] = bh; bound[3] = 0;
 	}
+
+for (s=0; s<n; s++)
+	{
+	seg[s].region = region[s];
+	seg[s].first = bound[s];
+	seg[s].last = bound[s+1];
+	seg[s].lx = (line-region[s]->y0)*region[s]->width-region[s]->x0;
+	}
+return n;
 }
 
-void free_gfront(struct gfront *p)
+/* Copy the part of the bordered image covered by a strip */
+static void fill_strip(struct scan_region *region, int rows, struct volume_src *src, 
+		void *in, int inStride, int gray, int border)
 {
-if (p != NULL) 
-	{ 
-	if (p->x != NULL) free(p->x); 
-	if (p->y != NULL) free(p->y); 
-	if (p->pos != NULL) free(p->pos); 
-	if (p->av != NULL) free(p->av); 
-	if (p->ap != NULL) free(p->ap); 
+int	i,j,x,y,inside;
+
+for (j=0; j<rows; j++)
+  for (i=0; i<region->width; i++)
+	{
+	x = region->x0+i-src->bh;
+	y = region->y0+j-src->bv;
+	inside = (x >= 0) && (x < src->imageWidth) && (y >= 0) && (y < src->imageHeight);
+	if (gray)
+		((int16_t *)region->data)[i+j*region->width] = (inside) ? ((int16_t *)in)[x+y*inStride] : (int16_t)border;
+	else
+		((uint8_t *)region->data)[i+j*region->width] = (inside) ? ((uint8_t *)in)[x+y*inStride] : (uint8_t)border;
 	}
 }
 
+/* Offsets of the points of a front for rows of the given width */
+static int *front_offsets(int *pos, int size, int *x, int *y, int width)
+{
+int	i;
+
+for (i=0; i<size; i++)
+	pos[i] = x[i]+y[i]*width;
+return pos+size;
+}
+
+/****************************************************************/
+/* Parameters shared by the bands of a scan */
+struct	volume_job
+	{
+	struct	volume_src *src;
+	void	*out;
+	int	imageWidth,imageHeight,outStride;
+	int	seWidth,seHeight;
+	int	gray,dilation;
+	int	histogram;		/* MORPHO_HISTOGRAM_LINEAR or MORPHO_HISTOGRAM_BITMAP */
+	struct	se_fronts *f;
+	int	lineFirst,nbrLines;
+	};
+
+/* Scans one band of lines with a histogram of its own */
+static int volume_band(void *arg, int band, int nbrBands)
+{
+struct	volume_job *job = (struct volume_job *)arg;
+struct	se_fronts *f = job->f;
+int	first,last;
+
+first = job->lineFirst+morpho_band_first(job->nbrLines, band, nbrBands);
+last = job->lineFirst+morpho_band_first(job->nbrLines, band+1, nbrBands);
+if (job->gray)
+	{
+	if (job->dilation)
+		return dilation_volume_gray(job->src,
+			(int16_t *)job->out, job->imageWidth, job->imageHeight, job->outStride,
+			f->se, job->seWidth, job->seHeight, &f->l,&f->r,&f->u,&f->d, &f->gl,&f->gr,&f->gu,&f->gd, 
+			f->ox, f->oy, first, last, job->histogram);
+	return erosion_volume_gray(job->src,
+			(int16_t *)job->out, job->imageWidth, job->imageHeight, job->outStride,
+			f->se, job->seWidth, job->seHeight, &f->l,&f->r,&f->u,&f->d, &f->gl,&f->gr,&f->gu,&f->gd, 
+			f->ox, f->oy, first, last, job->histogram);
+	}
+if (job->dilation)
+	return dilation_volume(job->src,
+			(uint8_t *)job->out, job->imageWidth, job->imageHeight, job->outStride,
+			f->se, job->seWidth, job->seHeight, &f->l,&f->r,&f->u,&f->d, f->ox, f->oy, first, last, job->histogram);
+return erosion_volume(job->src,
+			(uint8_t *)job->out, job->imageWidth, job->imageHeight, job->outStride,
+			f->se, job->seWidth, job->seHeight, &f->l,&f->r,&f->u,&f->d, f->ox, f->oy, first, last, job->histogram);
+}
+
+/****************************************************************/
+/* Largest scratch memory used by volume_run: structuring function,
+   output overlapping the input */
+size_t volume_scratch_size(int imageWidth, int imageHeight, int seWidth, int seHeight)
+{
+size_t	pos,strips;
+
+pos = (size_t)2*4*seWidth*seHeight*sizeof(int);
+strips = ((size_t)(4*seHeight-3)*(imageWidth+2*seWidth)+(size_t)4*seWidth*imageHeight)*sizeof(int16_t);
+return pos+strips+(size_t)imageWidth*imageHeight*sizeof(int16_t);
+}
+
+/****************************************************************/
+/* Scratch memory used by volume_src_init for the fronts f of a plan: the
+   offsets of the fronts and the strips along the four sides of the image */
+static size_t volume_src_size(struct morpho_se_plan *plan, struct se_fronts *f, int imageWidth, int imageHeight)
+{
+int	bh,bv,nbrPos;
+size_t	elem;
+
+bh = plan->seWidth;
+bv = plan->seHeight;
+elem = (plan->gray) ? sizeof(int16_t) : sizeof(uint8_t);
+nbrPos = f->l.size+f->r.size;
+if (plan->gray) nbrPos += f->gl.size+f->gr.size;
+
+/* Lines 0..bv-1 read the rows 0..2bv-2 of the bordered image, lines
+   imageHeight+1..imageHeight+bv-1 the rows imageHeight+1..imageHeight+2bv-2,
+   the side strips span the columns read near both ends of the other lines */
+return 2*nbrPos*sizeof(int)+(size_t)(2*bv-1+2*bv-2)*(imageWidth+2*bh)*elem+(size_t)2*imageHeight*2*bh*elem;
+}
+
+/* Bordered image seen by the fronts f, for the image in (read in place)
+   surrounded by the value border. memory holds volume_src_size() bytes */
+static void volume_src_init(struct volume_src *src, struct morpho_se_plan *plan, struct se_fronts *f, int border,
+		void *in, int inStride, int imageWidth, int imageHeight, char *memory)
+{
+int	bh,bv,blocWidth,topRows,bottomRows,sideRows;
+int	*pos;
+size_t	elem;
+char	*strip;
+
+bh = plan->seWidth;
+bv = plan->seHeight;
+blocWidth = imageWidth+2*bh;
+elem = (plan->gray) ? sizeof(int16_t) : sizeof(uint8_t);
+topRows = 2*bv-1;
+bottomRows = 2*bv-2;
+sideRows = imageHeight;
+
+src->bh = bh;
+src->bv = bv;
+src->imageWidth = imageWidth;
+src->imageHeight = imageHeight;
+
+/* The strips have the width of the bordered image the plan was computed for */
+src->top.width = blocWidth; src->top.x0 = 0; src->top.y0 = 0;
+src->bottom.width = blocWidth; src->bottom.x0 = 0; src->bottom.y0 = imageHeight+1;
+src->top.lpos = src->bottom.lpos = f->l.pos;
+src->top.rpos = src->bottom.rpos = f->r.pos;
+src->top.glpos = src->bottom.glpos = (plan->gray) ? f->gl.pos : NULL;
+src->top.grpos = src->bottom.grpos = (plan->gray) ? f->gr.pos : NULL;
+
+src->left.width = 2*bh; src->left.x0 = 0; src->left.y0 = bv;
+src->right.width = 2*bh; src->right.x0 = imageWidth; src->right.y0 = bv;
+src->image.data = in; src->image.width = inStride; src->image.x0 = bh; src->image.y0 = bv;
+
+pos = (int *)memory;
+src->left.lpos = pos; pos = front_offsets(pos, f->l.size, f->l.x, f->l.y, 2*bh);
+src->left.rpos = pos; pos = front_offsets(pos, f->r.size, f->r.x, f->r.y, 2*bh);
+src->image.lpos = pos; pos = front_offsets(pos, f->l.size, f->l.x, f->l.y, inStride);
+src->image.rpos = pos; pos = front_offsets(pos, f->r.size, f->r.x, f->r.y, inStride);
+src->left.glpos = src->left.grpos = src->image.glpos = src->image.grpos = NULL;
+if (plan->gray)
+	{
+	src->left.glpos = pos; pos = front_offsets(pos, f->gl.size, f->gl.x, f->gl.y, 2*bh);
+	src->left.grpos = pos; pos = front_offsets(pos, f->gr.size, f->gr.x, f->gr.y, 2*bh);
+	src->image.glpos = pos; pos = front_offsets(pos, f->gl.size, f->gl.x, f->gl.y, inStride);
+	src->image.grpos = pos; pos = front_offsets(pos, f->gr.size, f->gr.x, f->gr.y, inStride);
+	}
+src->right.lpos = src->left.lpos; src->right.rpos = src->left.rpos;
+src->right.glpos = src->left.glpos; src->right.grpos = src->left.grpos;
+
+strip = (char *)pos;
+src->top.data = strip; strip += topRows*blocWidth*elem;
+src->bottom.data = strip; strip += bottomRows*blocWidth*elem;
+src->left.data = strip; strip += sideRows*2*bh*elem;
+src->right.data = strip;
+fill_strip(&src->top, topRows, src, in, inStride, plan->gray, border);
+fill_strip(&src->bottom, bottomRows, src, in, inStride, plan->gray, border);
+fill_strip(&src->left, sideRows, src, in, inStride, plan->gray, border);
+fill_strip(&src->right, sideRows, src, in, inStride, plan->gray, border);
+}
+
+/* Tells if the output, written while the input is still being read, 
+   overlaps the input; the input is then copied by volume_copy */
+static int volume_overlap(void *in, int inStride, void *out, int outStride, int imageWidth, int imageHeight, size_t elem)
+{
+size_t	inSize,outSize;
+
+inSize = ((size_t)(imageHeight-1)*inStride+imageWidth)*elem;
+outSize = ((size_t)(imageHeight-1)*outStride+imageWidth)*elem;
+return ((char *)out < (char *)in+inSize) && ((char *)in < (char *)out+outSize);
+}
+
+static void volume_copy(void *in, int inStride, int imageWidth, int imageHeight, size_t elem, char *memory)
+{
+int	j;
+
+for (j=0; j<imageHeight; j++)
+	memcpy(memory+(size_t)j*imageWidth*elem, (char *)in+(size_t)j*inStride*elem, imageWidth*elem);
+}
+
+/****************************************************************/
+/* Erosion (or dilation) of an image by the fronts of a plan.
+   The image is read in place: only the strips of the bordered image
+   along its four sides are copied, with the border value, in the 
+   MORPHO_SLOT_BORDER slot of ctx (the whole image is copied there too 
+   when the output overlaps the input). Only the lines that produce an output 
+   row are scanned; they are split into bands that are processed by the 
+   threads of ctx. */
+int volume_run(void *in, int inStride, void *out, int imageWidth, int imageHeight, int outStride, 
+		struct morpho_se_plan *plan, int dilation, struct morpho_ctx *ctx)
+{
+struct	volume_job job;
+struct	volume_src src;
+struct	se_fronts *f;
+int	border,ret,inPlace;
+size_t	elem,size;
+char	*memory;
+
+f = (dilation) ? &plan->dilation : &plan->erosion;
+elem = (plan->gray) ? sizeof(int16_t) : sizeof(uint8_t);
+if (plan->gray)
+	border = (dilation) ? SMALLEST_VAL : LARGEST_VAL;
+else
+	border = (dilation) ? SMALLEST_UINT8 : LARGEST_UINT8;
+
+size = volume_src_size(plan, f, imageWidth, imageHeight);
+inPlace = volume_overlap(in, inStride, out, outStride, imageWidth, imageHeight, elem);
+if ( (memory = (char *)morpho_scratch(ctx, MORPHO_SLOT_BORDER, size+((inPlace) ? (size_t)imageWidth*imageHeight*elem : 0))) == NULL)
+	{ perror("Malloc"); return MORPHO_ERROR; }
+if (inPlace)
+	{
+	volume_copy(in, inStride, imageWidth, imageHeight, elem, memory+size);
+	in = memory+size;
+	inStride = imageWidth;
+	}
+volume_src_init(&src, plan, f, border, in, inStride, imageWidth, imageHeight, memory);
+
+job.src = &src;
+job.out = out;
+job.imageWidth = imageWidth;
+job.imageHeight = imageHeight;
+job.outStride = outStride;
+job.seWidth = plan->seWidth;
+job.seHeight = plan->seHeight;
+job.gray = plan->gray;
+job.dilation = dilation;
+job.histogram = morpho_ctx_histogram(ctx);
+job.f = f;
+
+/* Line "line" writes the output row line-seHeight+oy */
+job.lineFirst = plan->seHeight-f->oy;
+job.nbrLines = imageHeight;
+
+ret = morpho_run_bands(volume_band, &job, morpho_resolve_threads(morpho_ctx_threads(ctx), job.nbrLines));
+morpho_scratch_release(ctx, memory);
+return ret;
+}
+
+/****************************************************************/
+/* Parameters shared by the bands of gradient_run */
+struct	gradient_job
+	{
+	struct	volume_src *ero,*dil;
+	uint8_t	*in,*out,*rows;
+	int	inStride,outStride;
+	int	imageWidth,imageHeight;
+	int	type,histogram;
+	int	*sat;			/* NULL unless the histogram is shared */
+	struct	morpho_se_plan *plan;
+	};
+
+/* Produces the output rows of one band. With a shared histogram, the 
+   lines are scanned by gradient_volume. Otherwise, the erosion and the 
+   dilation of each row are scanned into two rows of the band, and 
+   combined */
+static int gradient_band(void *arg, int band, int nbrBands)
+{
+struct	gradient_job *job = (struct gradient_job *)arg;
+struct	se_fronts *fe = &job->plan->erosion, *fd = &job->plan->dilation;
+int	bh = job->plan->seWidth, bv = job->plan->seHeight, w = job->imageWidth;
+int	y,first,last;
+uint8_t	*rowMin,*rowMax,*in,*out;
+
+first = morpho_band_first(job->imageHeight, band, nbrBands);
+last = morpho_band_first(job->imageHeight, band+1, nbrBands);
+if (job->sat)
+	return gradient_volume(job->ero, job->out, w, job->imageHeight, job->outStride, fe->se, bh, bv, job->sat,
+			&fe->l,&fe->r, fe->ox, fe->oy, first+bv-fe->oy, last+bv-fe->oy, job->histogram);
+
+rowMin = job->rows+(size_t)2*band*w;
+rowMax = rowMin+w;
+for (y=first; y<last; y++)
+	{
+	/* Line y+bv-oy writes the output row y, at column x of a row of 
+	   stride 0 */
+	if (job->type != MORPHO_GRADIENT_EXTERNAL)
+		erosion_volume(job->ero, rowMin, w, job->imageHeight, 0, fe->se, bh, bv, 
+			&fe->l,&fe->r,&fe->u,&fe->d, fe->ox, fe->oy, y+bv-fe->oy, y+bv-fe->oy+1, job->histogram);
+	if (job->type != MORPHO_GRADIENT_INTERNAL)
+		dilation_volume(job->dil, rowMax, w, job->imageHeight, 0, fd->se, bh, bv, 
+			&fd->l,&fd->r,&fd->u,&fd->d, fd->ox, fd->oy, y+bv-fd->oy, y+bv-fd->oy+1, job->histogram);
+	in = job->in+(size_t)y*job->inStride;
+	out = job->out+(size_t)y*job->outStride;
+	switch (job->type)
+		{
+		case MORPHO_GRADIENT_INTERNAL: morpho_isa->rows_sub(in, rowMin, out, w); break;
+		case MORPHO_GRADIENT_EXTERNAL: morpho_isa->rows_sub(rowMax, in, out, w); break;
+		default: morpho_isa->rows_sub(rowMax, rowMin, out, w);
+		}
+	}
+return MORPHO_SUCCESS;
+}
+
+/* Tells if the structuring element of the erosion is symmetric with 
+   respect to its origin, that is if the erosion and the dilation read 
+   the same window */
+static int se_symmetric(struct se_fronts *f, int seWidth, int seHeight)
+{
+int	i,j,si,sj;
+
+for (j=0; j<seHeight; j++)
+  for (i=0; i<seWidth; i++)
+	if (f->se[i+j*seWidth] != 0)
+		{
+		si = 2*f->ox-i; sj = 2*f->oy-j;
+		if ( (si < 0) || (si >= seWidth) || (sj < 0) || (sj >= seHeight) || (f->se[si+sj*seWidth] == 0) ) return 0;
+		}
+return 1;
+}
+
+/* Summed area table of se: sat[i+j*(bh+1)] is the number of points of se
+   in the columns 0..i-1 and the rows 0..j-1, (bh+1)*(bv+1) values */
+static void se_sat(uint8_t *se, int bh, int bv, int *sat)
+{
+int	i,j;
+
+for (j=0; j<=bv; j++)
+  for (i=0; i<=bh; i++)
+	sat[i+j*(bh+1)] = ( (i == 0) || (j == 0) ) ? 0 :
+		(se[i-1+(j-1)*bh] != 0)+sat[i-1+j*(bh+1)]+sat[i+(j-1)*(bh+1)]-sat[i-1+(j-1)*(bh+1)];
+}
+
+/****************************************************************/
+/* Gradient of an image by the fronts of a plan (see gradient_arbitrary_SE).
+   The image is read in place, in a single pass, and each output row is 
+   written once, without any intermediate image:
+   - when the structuring element is symmetric with respect to its origin,
+     the Beucher gradient is scanned by gradient_volume, with a single 
+     histogram for both extrema;
+   - otherwise, the erosion and the dilation are scanned line by line, 
+     each through the strips of its own border value, and their rows 
+     (taken from the MORPHO_SLOT_LINES slot of ctx) are combined as soon 
+     as they are complete.
+   The strips are taken from MORPHO_SLOT_BORDER as in volume_run. */
+int gradient_run(uint8_t *in, int inStride, uint8_t *out, int imageWidth, int imageHeight, int outStride, 
+		struct morpho_se_plan *plan, int type, struct morpho_ctx *ctx)
+{
+struct	gradient_job job;
+struct	volume_src ero,dil;
+int	nbrBands,inPlace,shared,ret,bh,bv,*sat;
+size_t	sizeEro,sizeDil,sizeSat;
+char	*memory;
+uint8_t	*rows;
+
+bh = plan->seWidth;
+bv = plan->seHeight;
+shared = (type == MORPHO_GRADIENT_BEUCHER) && se_symmetric(&plan->erosion, bh, bv);
+sizeEro = (type != MORPHO_GRADIENT_EXTERNAL) ? volume_src_size(plan, &plan->erosion, imageWidth, imageHeight) : 0;
+sizeDil = ( (type != MORPHO_GRADIENT_INTERNAL) && !shared ) ? volume_src_size(plan, &plan->dilation, imageWidth, imageHeight) : 0;
+sizeSat = (shared) ? (size_t)(bh+1)*(bv+1)*sizeof(int) : 0;
+inPlace = volume_overlap(in, inStride, out, outStride, imageWidth, imageHeight, sizeof(uint8_t));
+nbrBands = morpho_resolve_threads(morpho_ctx_threads(ctx), imageHeight);
+memory = (char *)morpho_scratch(ctx, MORPHO_SLOT_BORDER, sizeSat+sizeEro+sizeDil+((inPlace) ? (size_t)imageWidth*imageHeight : 0));
+rows = (shared) ? NULL : (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, (size_t)2*nbrBands*imageWidth);
+if ( (memory == NULL) || ( !shared && (rows == NULL) ) )
+	{
+	perror("Malloc");
+	morpho_scratch_release(ctx, memory); morpho_scratch_release(ctx, rows);
+	return MORPHO_ERROR;
+	}
+sat = (int *)memory;
+memory += sizeSat;
+if (inPlace)
+	{
+	volume_copy(in, inStride, imageWidth, imageHeight, sizeof(uint8_t), memory+sizeEro+sizeDil);
+	in = (uint8_t *)memory+sizeEro+sizeDil;
+	inStride = imageWidth;
+	}
+if (type != MORPHO_GRADIENT_EXTERNAL)
+	volume_src_init(&ero, plan, &plan->erosion, LARGEST_UINT8, in, inStride, imageWidth, imageHeight, memory);
+if (sizeDil > 0)
+	volume_src_init(&dil, plan, &plan->dilation, SMALLEST_UINT8, in, inStride, imageWidth, imageHeight, memory+sizeEro);
+
+if (shared)
+	se_sat(plan->erosion.se, bh, bv, sat);
+
+job.ero = &ero;
+job.dil = &dil;
+job.in = in;
+job.inStride = inStride;
+job.out = out;
+job.outStride = outStride;
+job.rows = rows;
+job.imageWidth = imageWidth;
+job.imageHeight = imageHeight;
+job.type = type;
+job.histogram = morpho_ctx_histogram(ctx);
+job.sat = (shared) ? sat : NULL;
+job.plan = plan;
+
+ret = morpho_run_bands(gradient_band, &job, nbrBands);
+morpho_scratch_release(ctx, rows);
+morpho_scratch_release(ctx, sat);
+return ret;
+}
+
+/****************************************************************/
+/* Parameters shared by the bands of rank_run */
+struct	rank_job
+	{
+	struct	volume_src *src;
+	void	*out;
+	int	imageWidth,imageHeight,outStride;
+	int	histogram;
+	int	rank,outOf;
+	int	*sat;
+	struct	morpho_se_plan *plan;
+	};
+
+/* Scans one band of lines with a histogram of its own */
+static int rank_band(void *arg, int band, int nbrBands)
+{
+struct	rank_job *job = (struct rank_job *)arg;
+struct	se_fronts *f = &job->plan->erosion;
+int	bh = job->plan->seWidth, bv = job->plan->seHeight;
+int	first,last;
+
+first = morpho_band_first(job->imageHeight, band, nbrBands)+bv-f->oy;
+last = morpho_band_first(job->imageHeight, band+1, nbrBands)+bv-f->oy;
+if (job->plan->gray)
+	return rank_volume_gray(job->src, (int16_t *)job->out, job->imageWidth, job->imageHeight, job->outStride,
+			f->se, bh, bv, job->sat, &f->l,&f->r, &f->gl,&f->gr, f->ox, f->oy, first, last, job->rank, job->outOf);
+return rank_volume(job->src, (uint8_t *)job->out, job->imageWidth, job->imageHeight, job->outStride,
+			f->se, bh, bv, job->sat, &f->l,&f->r, f->ox, f->oy, first, last, job->histogram, job->rank, job->outOf);
+}
+
+/****************************************************************/
+/* Rank filter of an image by the erosion fronts of a plan (see 
+   rank_arbitrary_SE). The scan is that of the erosion, whose border
+   values are larger than those of the image: the value of rank k of 
+   the points of the window inside the image is then the value of rank
+   k of the whole window. The strips are taken from MORPHO_SLOT_BORDER
+   as in volume_run. */
+int rank_run(void *in, int inStride, void *out, int imageWidth, int imageHeight, int outStride, 
+		struct morpho_se_plan *plan, int rank, int outOf, struct morpho_ctx *ctx)
+{
+struct	rank_job job;
+struct	volume_src src;
+int	inPlace,ret,bh,bv,*sat;
+size_t	elem,size,sizeSat;
+char	*memory;
+
+bh = plan->seWidth;
+bv = plan->seHeight;
+elem = (plan->gray) ? sizeof(int16_t) : sizeof(uint8_t);
+size = volume_src_size(plan, &plan->erosion, imageWidth, imageHeight);
+sizeSat = (size_t)(bh+1)*(bv+1)*sizeof(int);
+inPlace = volume_overlap(in, inStride, out, outStride, imageWidth, imageHeight, elem);
+if ( (memory = (char *)morpho_scratch(ctx, MORPHO_SLOT_BORDER, sizeSat+size+((inPlace) ? (size_t)imageWidth*imageHeight*elem : 0))) == NULL)
+	{ perror("Malloc"); return MORPHO_ERROR; }
+sat = (int *)memory;
+se_sat(plan->erosion.se, bh, bv, sat);
+memory += sizeSat;
+if (inPlace)
+	{
+	volume_copy(in, inStride, imageWidth, imageHeight, elem, memory+size);
+	in = memory+size;
+	inStride = imageWidth;
+	}
+volume_src_init(&src, plan, &plan->erosion, (plan->gray) ? RANK_BORDER_VAL : LARGEST_UINT8, in, inStride, imageWidth, imageHeight, memory);
+
+job.src = &src;
+job.out = out;
+job.imageWidth = imageWidth;
+job.imageHeight = imageHeight;
+job.outStride = outStride;
+job.histogram = morpho_ctx_histogram(ctx);
+job.rank = rank;
+job.outOf = outOf;
+job.sat = sat;
+job.plan = plan;
+
+ret = morpho_run_bands(rank_band, &job, morpho_resolve_threads(morpho_ctx_threads(ctx), imageHeight));
+morpho_scratch_release(ctx, sat);
+return ret;
+}
@@ -19,6 +19,9 @@
  */
 
 #include "libmorpho.h"
+#include "workspace.h"
+#include "threadPool.h"
+#include "histogram.h"
 
 #ifndef __ARBITRARYUTIL__
 #define __ARBITRARYUTIL__
@@ -42,6 +45,75 @@ struct	gfront
 	uint8_t	*av,*ap;
 	};
 
+/* Memory holding the arrays of the fronts, see fronts_size() */
+struct	front_store
+	{
+	char	*next,*end;
+	};
+
+/* Fronts of a structuring element (or function), transformed for the
+   bordered image used by the erosion and the dilation */
+struct	se_fronts
+	{
+	uint8_t	*se;		/* NULL if the fronts were not computed */
+	int	ox,oy;
+	struct	front l,r,u,d;
+	struct	gfront gl,gr,gu,gd;
+	};
+
+/* Plan of a structuring element, see morpho_se_plan_create() */
+struct	morpho_se_plan
+	{
+	int	gray;			/* 1 for a structuring function */
+	int	seWidth,seHeight;
+	int	imageWidth;		/* width of the images the fronts are valid for */
+	struct	se_fronts erosion;	/* fronts of the structuring element */
+	struct	se_fronts dilation;	/* fronts of the inverted one */
+	void	*memory;		/* memory owned by the plan, or NULL */
+	};
+
+/* Part of the bordered image read by the scan: either the caller's image
+   itself, or a strip of the bordered image copied with its border */
+struct	scan_region
+	{
+	void	*data;
+	int	width;			/* distance between two rows of data */
+	int	x0,y0;			/* position of data[0] in the bordered image */
+	int	*lpos,*rpos;		/* offsets of the fronts for this width */
+	int	*glpos,*grpos;
+	};
+
+/* Bordered image seen by the volume functions. Lines that cross the
+   top or the bottom border are read in the top and bottom strips; the
+   other lines are read in the image, except for the columns that cross
+   the left or the right border, which are read in the side strips. */
+struct	volume_src
+	{
+	int	bh,bv;
+	int	imageWidth,imageHeight;
+	struct	scan_region top,bottom,left,right,image;
+	};
+
+/* Columns of a line that are read in the same region */
+struct	scan_segment
+	{
+	struct	scan_region *region;
+	int	first,last;		/* in the order of the scan, last excluded */
+	int	lx;			/* the corner of column col is data[col+lx] */
+	};
+
+/* One pass of the binary algorithm: the point (i,j) of se reads the pixel
+   (x+i-ox,y+j-oy), the pixels are combined by AND (erosion) or OR (dilation) */
+struct	binary_pass
+	{
+	uint8_t	*se;
+	int	ox,oy;
+	int	dilation;
+	};
+
+#define	 PLAN_EROSION		1
+#define	 PLAN_DILATION		2
+
 /* For the erosion and the dilation */
 #define	 SMALLEST_VAL		-255
 #define	 LARGEST_VAL		511
@@ -50,43 +122,83 @@ struct	gfront
 
 #define	 GREY_OFFSET		1
 
+/* For the rank filters by a structuring function: the border is larger 
+   than the values of the image minus the structuring function */
+#define	 RANK_SMALLEST_VAL	(SMALLEST_VAL-LARGEST_UINT8)
+#define	 RANK_BORDER_VAL	(LARGEST_VAL+LARGEST_UINT8)
+
 /* arbritraryUtil.c */
-int analyse_b(uint8_t *se, int seWidth, int seHeight, struct front *lf, struct front *rf, struct front *uf, struct front *df, int ox,int oy);
-int analyse_b_gray(uint8_t *se, int seWidth, int seHeight, struct front *lf, struct front *rf, struct front *uf, struct front *df, struct gfront *glf, struct gfront *grf, struct gfront *guf, struct gfront *gdf, int ox,int oy);
-int transform_b(int seWidth, struct front *l, struct front *r, struct front *u, struct front *d);
-int transform_b_gray(int seWidth, struct front *l, struct front *r, struct front *u, struct front *d, struct gfront *gl, struct gfront *gr, struct gfront *gu, struct gfront *gd);
+size_t fronts_size(int seWidth, int seHeight);
+void *front_store_alloc(struct front_store *store, size_t size);
+int analyse_b(uint8_t *se, int seWidth, int seHeight, struct front *lf, struct front *rf, struct front *uf, struct front *df, int ox,int oy, struct front_store *store);
+int analyse_b_gray(uint8_t *se, int seWidth, int seHeight, struct front *lf, struct front *rf, struct front *uf, struct front *df, struct gfront *glf, struct gfront *grf, struct gfront *guf, struct gfront *gdf, int ox,int oy, struct front_store *store);
+int transform_b(int seWidth, struct front *l, struct front *r, struct front *u, struct front *d, struct front_store *store);
+int transform_b_gray(int seWidth, struct front *l, struct front *r, struct front *u, struct front *d, struct gfront *gl, struct gfront *gr, struct gfront *gu, struct gfront *gd, struct front_store *store);
 int invert_SE(uint8_t *seIn, uint8_t *seOut, int width, int height);
-void free_front(struct front *p);
-void free_gfront(struct gfront *p);
+int scan_segments(struct volume_src *src, int line, struct scan_segment *seg);
+size_t volume_scratch_size(int imageWidth, int imageHeight, int seWidth, int seHeight);
+int volume_run(void *in, int inStride, void *out, int imageWidth, int imageHeight, int outStride, struct morpho_se_plan *plan, int dilation, struct morpho_ctx *ctx);
+int gradient_run(uint8_t *in, int inStride, uint8_t *out, int imageWidth, int imageHeight, int outStride, struct morpho_se_plan *plan, int type, struct morpho_ctx *ctx);
+int rank_run(void *in, int inStride, void *out, int imageWidth, int imageHeight, int outStride, struct morpho_se_plan *plan, int rank, int outOf, struct morpho_ctx *ctx);
+
+/* sePlan.c */
+size_t se_plan_size(int seWidth, int seHeight, int which);
+int se_plan_init(struct morpho_se_plan *plan, uint8_t *se, int seWidth, int seHeight, int ox, int oy, int imageWidth, int gray, int which, struct front_store *store);
+int is_plan_valid(struct morpho_se_plan *plan, int gray, int imageWidth, int which, char *func);
+
+/* binaryArbitrarySE.c */
+int binary_values(uint8_t *imageIn, int imageWidth, int imageHeight, int inStride, uint8_t *lo, uint8_t *hi);
+int binary_SE_passes(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t lo, uint8_t hi, int seWidth, int seHeight, struct binary_pass *pass, int nbrPasses, struct morpho_ctx *ctx);
 
 /* erosionArbitrarySE.c */
-int erosion_volume(	uint8_t *in, int blocWidth, int blocHeight,
-		uint8_t *out, int imageWidth, int imageHeight,
+int erosion_volume(	struct volume_src *src,
+		uint8_t *out, int imageWidth, int imageHeight, int outStride,
 		uint8_t *se, int bh, int bv,
 		struct front *l, struct front *r, struct front *u, struct front *d,
-		int ox,int oy);
+		int ox,int oy, int lineFirst, int lineLast, int histogram);
 
 /* dilationArbitrarySE.c */
-int dilation_volume(	uint8_t *in, int blocWidth, int blocHeight,
-		uint8_t *out, int imageWidth, int imageHeight,
+int dilation_volume(	struct volume_src *src,
+		uint8_t *out, int imageWidth, int imageHeight, int outStride,
 		uint8_t *se, int bh, int bv,
 		struct front *l, struct front *r, struct front *u, struct front *d,
-		int ox,int oy);
+		int ox,int oy, int lineFirst, int lineLast, int histogram);
+
+/* gradientArbitrarySE.c */
+int gradient_volume(	struct volume_src *src,
+		uint8_t *out, int imageWidth, int imageHeight, int outStride,
+		uint8_t *se, int bh, int bv, int *sat,
+		struct front *l, struct front *r, 
+		int ox,int oy, int lineFirst, int lineLast, int histogram);
+
+/* rankArbitrarySE.c */
+int rank_volume(	struct volume_src *src,
+		uint8_t *out, int imageWidth, int imageHeight, int outStride,
+		uint8_t *se, int bh, int bv, int *sat,
+		struct front *l, struct front *r, 
+		int ox,int oy, int lineFirst, int lineLast, int histogram, int rank, int outOf);
 
 /* erosionArbitrarySF.c */
-int erosion_volume_gray( int16_t *bloc, int blocWidth, int blocHeight,
-		int16_t *out, int imageWidth, int imageHeight,
+int erosion_volume_gray( struct volume_src *src,
+		int16_t *out, int imageWidth, int imageHeight, int outStride,
 		uint8_t *sf, int bh, int bv,
 		struct front *l, struct front *r, struct front *u, struct front *d,
 		struct gfront *gl,struct gfront *gr,struct gfront *gu,struct gfront *gd,
-		int ox,int oy);
+		int ox,int oy, int lineFirst, int lineLast, int histogram);
 
 /* dilationArbitrarySF.c */
-int dilation_volume_gray( int16_t *bloc, int blocWidth, int blocHeight,
-		int16_t *out, int imageWidth, int imageHeight,
+int dilation_volume_gray( struct volume_src *src,
+		int16_t *out, int imageWidth, int imageHeight, int outStride,
 		uint8_t *sf, int bh, int bv,
 		struct front *l, struct front *r, struct front *u, struct front *d,
 		struct gfront *gl,struct gfront *gr,struct gfront *gu,struct gfront *gd,
-		int ox,int oy);
+		int ox,int oy, int lineFirst, int lineLast, int histogram);
+
+/* rankArbitrarySF.c */
+int rank_volume_gray( struct volume_src *src,
+		int16_t *out, int imageWidth, int imageHeight, int outStride,
+		uint8_t *sf, int bh, int bv, int *sat,
+		struct front *l, struct front *r, struct gfront *gl, struct gfront *gr,
+		int ox,int oy, int lineFirst, int lineLast, int rank, int outOf);
 
 #endif
@@ -0,0 +1,455 @@
+/* LIBMORPHO
+ *
+ * areaOpening.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file areaOpening.c
+ */
+
+#include "libmorpho.h"
+#include "workspace.h"
+
+/* Max-tree (or min-tree) of an image, as a parent array over the pixels.
+ * The pixels are addressed by y*imageWidth+x and sorted by increasing
+ * value, so that a parent always comes before its children in sorted[].
+ * The canonical pixel of a node is the one whose parent has another value
+ * (or the root); its area is that of the node. The values of a min-tree
+ * are complemented, so that both trees are processed in the same way. */
+struct	morpho_maxtree
+	{
+	int	imageWidth, imageHeight;
+	uint8_t	inv;		/* 0 for a max-tree, 255 for a min-tree */
+	uint8_t	*value;		/* complemented for a min-tree */
+	int	*parent;
+	int	*sorted;
+	int	*area;
+	};
+
+/* Root of the set of p, with path halving */
+static int maxtree_find(int *zpar, int p)
+{
+  while (zpar[p] != p)
+    {
+      zpar[p] = zpar[zpar[p]];
+      p = zpar[p];
+    }
+  return p;
+}
+
+/* Links the set of the neighbour n to p, if n has already been processed */
+static void maxtree_union(struct morpho_maxtree *tree, int *zpar, int p, int n)
+{
+  int	r;
+
+  if (zpar[n] < 0) { return; }
+  r = maxtree_find(zpar, n);
+  if (r != p)
+    {
+      tree->parent[r] = p;
+      zpar[r] = p;
+      tree->area[p] += tree->area[r];
+    }
+}
+
+/* Checks the arguments of a tree */
+static int maxtree_check(uint8_t *imageIn, int imageWidth, int imageHeight, int inStride, int connectivity, int type, char *func)
+{
+  char	st[200];
+
+  if ( (imageIn == NULL) || (imageWidth < 1) || (imageHeight < 1) 
+       || ( (connectivity != 4) && (connectivity != 8) )
+       || ( (type != MORPHO_TREE_MAX) && (type != MORPHO_TREE_MIN) ) ) {
+    snprintf(st, 200, "ERROR(%s): invalid image, connectivity (=%d) or type (=%d).", func, connectivity, type);
+    perror(st);
+    return MORPHO_ERROR;
+  }
+  return is_stride_valid(inStride, imageWidth, imageWidth, func);
+}
+
+/* Builds the tree of imageIn into the buffers of tree (imageWidth*imageHeight
+ * values, parents, sorted pixels and areas); zpar holds imageWidth*imageHeight
+ * integers */
+static void maxtree_build(struct morpho_maxtree *tree, int *zpar, uint8_t *imageIn, int imageWidth, int imageHeight, int inStride, int connectivity, int type)
+{
+  int	histo[256];
+  int	i,x,y,p,n,w,sum,count;
+
+  w = imageWidth;
+  n = imageWidth*imageHeight;
+  tree->imageWidth = imageWidth;
+  tree->imageHeight = imageHeight;
+  tree->inv = (type == MORPHO_TREE_MIN) ? 255 : 0;
+
+  /* Counting sort of the pixels by increasing value */
+  memset(histo, 0, sizeof(histo));
+  for (y=0; y<imageHeight; y++)
+    for (x=0; x<imageWidth; x++)
+      {
+	tree->value[y*w+x] = imageIn[y*inStride+x]^tree->inv;
+	histo[tree->value[y*w+x]]++;
+      }
+  for (i=0, sum=0; i<256; i++)
+    {
+      count = histo[i];
+      histo[i] = sum;
+      sum += count;
+    }
+  for (p=0; p<n; p++) { tree->sorted[histo[tree->value[p]]++] = p; }
+
+  /* Union-find, from the highest pixels to the lowest ones */
+  for (p=0; p<n; p++) { zpar[p] = -1; }
+  for (i=n-1; i>=0; i--)
+    {
+      p = tree->sorted[i];
+      tree->parent[p] = p;
+      zpar[p] = p;
+      tree->area[p] = 1;
+      x = p%w; y = p/w;
+      if (x > 0) { maxtree_union(tree, zpar, p, p-1); }
+      if (x < w-1) { maxtree_union(tree, zpar, p, p+1); }
+      if (y > 0)
+	{
+	  maxtree_union(tree, zpar, p, p-w);
+	  if (connectivity == 8)
+	    {
+	      if (x > 0) { maxtree_union(tree, zpar, p, p-w-1); }
+	      if (x < w-1) { maxtree_union(tree, zpar, p, p-w+1); }
+	    }
+	}
+      if (y < imageHeight-1)
+	{
+	  maxtree_union(tree, zpar, p, p+w);
+	  if (connectivity == 8)
+	    {
+	      if (x > 0) { maxtree_union(tree, zpar, p, p+w-1); }
+	      if (x < w-1) { maxtree_union(tree, zpar, p, p+w+1); }
+	    }
+	}
+    }
+
+  /* Each pixel points to the canonical pixel of its parent node */
+  for (i=0; i<n; i++)
+    {
+      p = tree->sorted[i];
+      x = tree->parent[p];
+      if (tree->value[tree->parent[x]] == tree->value[x]) { tree->parent[p] = tree->parent[x]; }
+    }
+}
+
+/*!
+ * \fn struct morpho_maxtree *morpho_maxtree_create(uint8_t *imageIn, int imageWidth, int imageHeight, int inStride, int connectivity, int type)
+ * \param[in]  *imageIn Input buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  connectivity 4 or 8
+ * \param[in]  type MORPHO_TREE_MAX (for openings) or MORPHO_TREE_MIN (for closings)
+ * \return Returns a new tree, or NULL upon error.
+ *
+ * \brief Builds the max-tree (or min-tree) of an image
+ *
+ * \ingroup libmorpho
+ *
+ * The nodes of the max-tree are the connected components of the upper 
+ * level sets of the image; those of the min-tree are the components of 
+ * the lower level sets. The pixels are sorted by a counting sort and the
+ * tree is built by union-find, in a time almost linear in the number of 
+ * pixels, as in
+ * - C. Berger, T. Géraud, R. Levillain, N. Widynski, A. Baillard and 
+ * E. Bertin. <b>Effective component tree computation with application to
+ * pattern recognition in astronomical imaging</b>. In <em>IEEE International
+ * Conference on Image Processing</em>, volume 4, pages 41-44, 2007.
+ *
+ * The tree keeps its own copy of the image and the area of each node;
+ * \ref morpho_maxtree_area_filter applies any number of area thresholds 
+ * to it. It is not modified by the filters and can be shared by several
+ * threads.
+ */
+struct morpho_maxtree *morpho_maxtree_create(uint8_t *imageIn, int imageWidth, int imageHeight, int inStride, int connectivity, int type)
+{
+  struct morpho_maxtree *tree;
+  int	*zpar;
+  int	n;
+
+  if ( MORPHO_ERROR == maxtree_check(imageIn, imageWidth, imageHeight, inStride, connectivity, type, "morpho_maxtree_create") ) return NULL;
+
+  n = imageWidth*imageHeight;
+  tree = (struct morpho_maxtree *)malloc(sizeof(struct morpho_maxtree));
+  if (tree == NULL) {
+    perror("Malloc");
+    return NULL;
+  }
+  tree->value = (uint8_t *)malloc(n*sizeof(uint8_t));
+  tree->parent = (int *)malloc(n*sizeof(int));
+  tree->sorted = (int *)malloc(n*sizeof(int));
+  tree->area = (int *)malloc(n*sizeof(int));
+  zpar = (int *)malloc(n*sizeof(int));
+  if ( (tree->value == NULL) || (tree->parent == NULL) || (tree->sorted == NULL) 
+       || (tree->area == NULL) || (zpar == NULL) ) {
+    perror("Malloc");
+    free(zpar);
+    morpho_maxtree_free(tree);
+    return NULL;
+  }
+
+  maxtree_build(tree, zpar, imageIn, imageWidth, imageHeight, inStride, connectivity, type);
+  free(zpar);
+
+  if(DEBUG) printf(" finished.\n");
+  return tree;
+}
+
+/*!
+ * \fn void morpho_maxtree_free(struct morpho_maxtree *tree)
+ * \param[in] tree Tree created by \ref morpho_maxtree_create (may be NULL)
+ * \brief Frees a tree
+ * \ingroup libmorpho
+ */
+void morpho_maxtree_free(struct morpho_maxtree *tree)
+{
+  if (tree == NULL) return;
+  free(tree->value);
+  free(tree->parent);
+  free(tree->sorted);
+  free(tree->area);
+  free(tree);
+}
+
+/*!
+ * \fn int morpho_maxtree_area_filter(struct morpho_maxtree *tree, uint8_t *imageOut, int outStride, int area)
+ * \param[in]  tree Tree created by \ref morpho_maxtree_create
+ * \param[out]  *imageOut Output buffer, of the size of the image of the tree
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  area Smallest area (in pixels) of the components that are kept
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Area opening (max-tree) or area closing (min-tree) of the image of a tree
+ *
+ * \ingroup libmorpho
+ *
+ * Every node whose area is smaller than area takes the value of its 
+ * closest ancestor that is large enough: the bright (dark) components of
+ * less than area pixels are removed, whatever their shape. The nodes are
+ * visited from the root, so that a single pass over the pixels is needed.
+ */
+int morpho_maxtree_area_filter(struct morpho_maxtree *tree, uint8_t *imageOut, int outStride, int area)
+{
+  uint8_t *row;
+  int	i,p,q,op,oq,x,y,w,n;
+
+  /* Tests */
+  if ( (tree == NULL) || (imageOut == NULL) ) {
+    perror("ERROR(morpho_maxtree_area_filter): invalid tree or output buffer");
+    return MORPHO_ERROR;
+  }
+  w = tree->imageWidth;
+  n = tree->imageWidth*tree->imageHeight;
+  if ( MORPHO_ERROR == is_stride_valid(w, outStride, w, "morpho_maxtree_area_filter") ) return MORPHO_ERROR;
+
+  /* The root comes first, and each node after its parent; pixel p of the
+     tree is at (p/w)*outStride+p%w in the output */
+  for (i=0; i<n; i++)
+    {
+      p = tree->sorted[i];
+      q = tree->parent[p];
+      op = p; oq = q;
+      if (outStride != w)
+	{
+	  op = (p/w)*outStride+p%w;
+	  oq = (q/w)*outStride+q%w;
+	}
+      if ( (q == p) || ( (tree->value[q] != tree->value[p]) && (tree->area[p] >= area) ) )
+	imageOut[op] = tree->value[p];
+      else
+	imageOut[op] = imageOut[oq];
+    }
+  if (tree->inv)
+    for (y=0; y<tree->imageHeight; y++)
+      {
+	row = imageOut+y*outStride;
+	for (x=0; x<w; x++) { row[x] ^= tree->inv; }
+      }
+  return MORPHO_SUCCESS;
+}
+
+/* Area opening or closing through a tree built in the scratch memory of
+ * the context */
+static int area_filter(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity, int type, struct morpho_ctx *ctx, char *func)
+{
+  struct morpho_maxtree tree;
+  int	*memory;
+  int	n,err;
+
+  if ( MORPHO_ERROR == maxtree_check(imageIn, imageWidth, imageHeight, inStride, connectivity, type, func) ) return MORPHO_ERROR;
+
+  /* Parents, sorted pixels, areas, union-find and values */
+  n = imageWidth*imageHeight;
+  if ((memory=(int *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, (size_t)4*n*sizeof(int)+n*sizeof(uint8_t))) == NULL) {
+    perror("Malloc");
+    return MORPHO_ERROR;
+  }
+  tree.parent = memory;
+  tree.sorted = memory+n;
+  tree.area = memory+2*(size_t)n;
+  tree.value = (uint8_t *)(memory+4*(size_t)n);
+  maxtree_build(&tree, memory+3*(size_t)n, imageIn, imageWidth, imageHeight, inStride, connectivity, type);
+  err = morpho_maxtree_area_filter(&tree, imageOut, outStride, area);
+
+  morpho_scratch_release(ctx, memory);
+  if(DEBUG) printf(" finished.\n");
+  return err;
+}
+
+/*!
+ * \fn int areaOpening(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int area, int connectivity)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be imageIn)
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  area Smallest area (in pixels) of the bright components that are kept
+ * \param[in]  connectivity 4 or 8
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Area opening
+ *
+ * \ingroup libmorpho
+ *
+ * Removes the bright components of less than area pixels, for every 
+ * threshold of the image; this is the supremum of the openings by all the
+ * connected structuring elements of area pixels. See \ref morpho_maxtree_create
+ * to apply several areas to the same image.
+ */
+int areaOpening(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int area, int connectivity)
+{
+  return area_filter(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, area, connectivity, MORPHO_TREE_MAX, NULL, "areaOpening");
+}
+
+/*!
+ * \fn int areaOpening_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be imageIn)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  area Smallest area (in pixels) of the bright components that are kept
+ * \param[in]  connectivity 4 or 8
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref areaOpening, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ */
+int areaOpening_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity)
+{
+  return area_filter(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, area, connectivity, MORPHO_TREE_MAX, NULL, "areaOpening");
+}
+
+/*!
+ * \fn int areaOpening_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be imageIn)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  area Smallest area (in pixels) of the bright components that are kept
+ * \param[in]  connectivity 4 or 8
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref areaOpening_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. The tree of the image, about 17 bytes per
+ * pixel, is built in the context.
+ */
+int areaOpening_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity, struct morpho_ctx *ctx)
+{
+  return area_filter(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, area, connectivity, MORPHO_TREE_MAX, ctx, "areaOpening");
+}
+
+/*!
+ * \fn int areaClosing(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int area, int connectivity)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be imageIn)
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  area Smallest area (in pixels) of the dark components that are kept
+ * \param[in]  connectivity 4 or 8
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Area closing
+ *
+ * \ingroup libmorpho
+ *
+ * Dual of \ref areaOpening: fills the dark components of less than area 
+ * pixels.
+ */
+int areaClosing(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int area, int connectivity)
+{
+  return area_filter(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, area, connectivity, MORPHO_TREE_MIN, NULL, "areaClosing");
+}
+
+/*!
+ * \fn int areaClosing_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be imageIn)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  area Smallest area (in pixels) of the dark components that are kept
+ * \param[in]  connectivity 4 or 8
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref areaClosing, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ */
+int areaClosing_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity)
+{
+  return area_filter(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, area, connectivity, MORPHO_TREE_MIN, NULL, "areaClosing");
+}
+
+/*!
+ * \fn int areaClosing_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be imageIn)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  area Smallest area (in pixels) of the dark components that are kept
+ * \param[in]  connectivity 4 or 8
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref areaClosing_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. The tree of the image, about 17 bytes per
+ * pixel, is built in the context.
+ */
+int areaClosing_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity, struct morpho_ctx *ctx)
+{
+  return area_filter(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, area, connectivity, MORPHO_TREE_MIN, ctx, "areaClosing");
+}
@@ -0,0 +1,105 @@
+/* LIBMORPHO
+ *
+ * asfArbitrarySE.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file asfArbitrarySE.c
+ */
+
+#include "arbitraryUtil.h"
+
+/*!
+ * \fn int asf_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan **plan, int nbrSteps, int order, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  **plan Plans of the structuring elements of the steps, built by \ref morpho_se_plan_create
+ * \param[in]  nbrSteps Number of steps (and of plans)
+ * \param[in]  order MORPHO_ASF_OPEN_CLOSE or MORPHO_ASF_CLOSE_OPEN
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Alternating sequential filter by precomputed structuring elements
+ *
+ * \ingroup libmorpho
+ *
+ * Step k applies \ref opening_arbitrary_SE_plan and then
+ * \ref closing_arbitrary_SE_plan (MORPHO_ASF_OPEN_CLOSE), or the closing
+ * and then the opening (MORPHO_ASF_CLOSE_OPEN), with plan[k]; the plans are
+ * usually those of increasing structuring elements. The erosions and
+ * dilations alternate between imageOut and the intermediate image of the
+ * context, so that no other image is allocated or copied. imageIn and
+ * imageOut may be the same buffer, with the same stride.
+ */
+int asf_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan **plan, int nbrSteps, int order, struct morpho_ctx *ctx)
+{
+char	st[200];
+uint8_t	*bloc,*cur,*dest;
+int	curStride,destStride;
+int	k,p,dilation,ret;
+
+if (DEBUG) printf("Running asf_arbitrary_SE_plan\n");
+
+/* Test the compatibility */
+if ( (nbrSteps < 1) || ( (order != MORPHO_ASF_OPEN_CLOSE) && (order != MORPHO_ASF_CLOSE_OPEN) ) )
+	{
+	snprintf(st, 200, "ERROR(%s): invalid number of steps (=%d) or order (=%d).", "asf_arbitrary_SE", nbrSteps, order);
+	perror(st);
+	return MORPHO_ERROR;
+	}
+for (k=0;k<nbrSteps;k++)
+	if ( MORPHO_ERROR == is_plan_valid(plan[k], 0, imageWidth, PLAN_EROSION|PLAN_DILATION, "asf_arbitrary_SE") ) return MORPHO_ERROR;
+
+if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "asf_arbitrary_SE") ) return MORPHO_ERROR;
+
+/* Allocates a new picture */
+if ( (bloc = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, imageWidth*imageHeight*sizeof(uint8_t))) == NULL)
+	{
+	perror("Malloc");
+	return MORPHO_ERROR;
+	}
+
+/* Pass p (p < 4*nbrSteps) writes imageOut if there is an even number of
+   passes after it, the intermediate image otherwise: the first pass never
+   writes the buffer it reads, and the last one writes imageOut */
+ret = MORPHO_SUCCESS;
+cur = imageIn; curStride = inStride;
+for (p=0; (p<4*nbrSteps) && (MORPHO_SUCCESS == ret); p++)
+	{
+	k = p/4;
+	/* Opening: erosion and dilation; closing: dilation and erosion */
+	dilation = (p%4 == 1) || (p%4 == 2);
+	if (order == MORPHO_ASF_CLOSE_OPEN) dilation = !dilation;
+	if ( (4*nbrSteps-1-p)%2 == 0 )
+		{ dest = imageOut; destStride = outStride; }
+	else	{ dest = bloc; destStride = imageWidth; }
+	if (dilation)
+		ret = dilation_arbitrary_SE_plan(cur, dest, imageWidth, imageHeight, curStride, destStride, plan[k], ctx);
+	else	ret = erosion_arbitrary_SE_plan(cur, dest, imageWidth, imageHeight, curStride, destStride, plan[k], ctx);
+	cur = dest; curStride = destStride;
+	}
+
+/* Free the data */
+morpho_scratch_release(ctx, bloc);
+
+return ret;
+}
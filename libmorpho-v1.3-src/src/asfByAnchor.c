@@ -0,0 +1,201 @@
+/* LIBMORPHO
+ *
+ * asfByAnchor.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file asfByAnchor.c
+ */
+
+#include "anchorUtil.h"
+
+/* One pass of an alternating sequential filter: horizontal erosion or
+ * dilation, or vertical opening or closing, by a segment of size pixels */
+struct	asf_pass
+	{
+	int	vertical;
+	int	dilation;		/* dilation, or closing if vertical */
+	int	size;
+	};
+
+/* Builds the passes of the filter in pass[] and returns their number.
+ *
+ * The opening by a rectangle is an horizontal erosion, a vertical opening
+ * and an horizontal dilation, and the closing is the dual sequence. When
+ * an opening is followed by a closing (or the converse), the horizontal
+ * dilations (erosions) by segments of sizes a and b are merged into one
+ * by a segment of size a+b-1, as long as it is smaller than the image.
+ * The first possible merge is skipped if skipMerge is set. */
+static int asf_passes(struct asf_pass *pass, int imageWidth, int seWidth, int seHeight, int nbrSteps, int order, int skipMerge)
+{
+  struct asf_pass p;
+  int	k,f,n,width,height,merge;
+
+  n = 0;
+  for (k=1; k<=nbrSteps; k++)
+    {
+      width = k*(seWidth-1)+1;
+      height = k*(seHeight-1)+1;
+      for (f=0; f<2; f++)
+	{
+	  /* Opening (dilation=0) or closing (dilation=1) */
+	  p.dilation = (f == 0) ? (order == MORPHO_ASF_CLOSE_OPEN) : (order == MORPHO_ASF_OPEN_CLOSE);
+	  p.vertical = 0; p.size = width;
+	  merge = (n > 0) && (!pass[n-1].vertical) && (pass[n-1].dilation == p.dilation)
+	    && (pass[n-1].size+width-1 < imageWidth);
+	  if (merge && !skipMerge)
+	    { pass[n-1].size += width-1; }
+	  else
+	    {
+	      if (merge) { skipMerge = 0; }
+	      pass[n++] = p;
+	    }
+	  p.vertical = 1; p.size = height;
+	  pass[n++] = p;
+	  p.vertical = 0; p.size = width; p.dilation = !p.dilation;
+	  pass[n++] = p;
+	}
+    }
+  return n;
+}
+
+/*!
+ * \fn int asfByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight, int nbrSteps, int order)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangle of the first step (odd)
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangle of the first step
+ * \param[in]  nbrSteps Number of steps of the filter
+ * \param[in]  order MORPHO_ASF_OPEN_CLOSE or MORPHO_ASF_CLOSE_OPEN
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Alternating sequential filter by rectangles
+ *
+ * \ingroup libmorpho
+ *
+ * Step k (k = 1..nbrSteps) applies \ref openingByAnchor_2D and then
+ * \ref closingByAnchor_2D (MORPHO_ASF_OPEN_CLOSE), or the closing and then
+ * the opening (MORPHO_ASF_CLOSE_OPEN), by the rectangle kB of
+ * (k*(seWidth-1)+1) * (k*(seHeight-1)+1) pixels. The result is that of the
+ * sequence of openings and closings, which is computed with two buffers
+ * only: the output and one intermediate image. The horizontal dilation
+ * (erosion) that ends an opening (a closing) is merged with the one that
+ * starts the next filter.
+ */
+int asfByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight, int nbrSteps, int order)
+{
+  return asfByAnchor_2D_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, seWidth, seHeight, nbrSteps, order, NULL);
+}
+
+/*!
+ * \fn int asfByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, int nbrSteps, int order, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangle of the first step (odd)
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangle of the first step
+ * \param[in]  nbrSteps Number of steps of the filter
+ * \param[in]  order MORPHO_ASF_OPEN_CLOSE or MORPHO_ASF_CLOSE_OPEN
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref asfByAnchor_2D, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. imageIn and imageOut may be the same buffer,
+ * with the same stride. The passes alternate between imageOut and the
+ * intermediate image of the context, in an order chosen so that the last
+ * one writes imageOut.
+ */
+int asfByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, int nbrSteps, int order, struct morpho_ctx *ctx)
+{
+  struct asf_pass *pass;
+  uint8_t *bloc,*cur,*dest;
+  size_t size;
+  char	st[200];
+  int	curStride,destStride;
+  int	i,n,nbrHorizontal,h,err;
+
+  /* Tests */
+  if ( (nbrSteps < 1) || ( (order != MORPHO_ASF_OPEN_CLOSE) && (order != MORPHO_ASF_CLOSE_OPEN) ) ) {
+    snprintf(st, 200, "ERROR(asfByAnchor_2D): invalid number of steps (=%d) or order (=%d).", nbrSteps, order);
+    perror(st);
+    return MORPHO_ERROR;
+  }
+  if ( MORPHO_ERROR == is_size_valid_1D(seWidth, imageWidth, "asfByAnchor_2D", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(seHeight, imageHeight, "asfByAnchor_2D", 0) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(nbrSteps*(seWidth-1)+1, imageWidth, "asfByAnchor_2D", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(nbrSteps*(seHeight-1)+1, imageHeight, "asfByAnchor_2D", 0) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "asfByAnchor_2D") ) return MORPHO_ERROR;
+
+  /* The intermediate image and the passes share the slot of the context */
+  size = (imageWidth*imageHeight+sizeof(struct asf_pass)-1)/sizeof(struct asf_pass)*sizeof(struct asf_pass);
+  if ((bloc=(uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, size+6*nbrSteps*sizeof(struct asf_pass))) == NULL) {
+    perror("Malloc");
+    return MORPHO_ERROR;
+  }
+  pass = (struct asf_pass *)(bloc+size);
+
+  /* The horizontal passes alternate between the buffers and the last one
+   * writes imageOut. When the first one also writes imageOut, it can not
+   * read the same buffer: one merge less changes the parity. */
+  n = asf_passes(pass, imageWidth, seWidth, seHeight, nbrSteps, order, 0);
+  for (i=0, nbrHorizontal=0; i<n; i++) { if (!pass[i].vertical) nbrHorizontal++; }
+  if ( (imageIn == imageOut) && (nbrHorizontal%2 == 1) )
+    {
+      n = asf_passes(pass, imageWidth, seWidth, seHeight, nbrSteps, order, 1);
+      nbrHorizontal++;
+    }
+
+  /* Computation */
+  err = MORPHO_SUCCESS;
+  cur = imageIn; curStride = inStride;
+  for (i=0, h=0; (i<n) && (MORPHO_SUCCESS == err); i++)
+    {
+      if (pass[i].vertical)
+	{
+	  /* In place, on the buffer written by the previous pass */
+	  if (pass[i].dilation)
+	    err = closingByAnchor_1D_vertical_ctx(cur, cur, imageWidth, imageHeight, curStride, curStride, pass[i].size, ctx);
+	  else
+	    err = openingByAnchor_1D_vertical_ctx(cur, cur, imageWidth, imageHeight, curStride, curStride, pass[i].size, ctx);
+	  continue;
+	}
+      if ((nbrHorizontal-1-h)%2 == 0)
+	{ dest = imageOut; destStride = outStride; }
+      else
+	{ dest = bloc; destStride = imageWidth; }
+      if (pass[i].dilation)
+	err = dilationByAnchor_1D_horizontal_ctx(cur, dest, imageWidth, imageHeight, curStride, destStride, pass[i].size, ctx);
+      else
+	err = erosionByAnchor_1D_horizontal_ctx(cur, dest, imageWidth, imageHeight, curStride, destStride, pass[i].size, ctx);
+      cur = dest; curStride = destStride;
+      h++;
+    }
+
+  /* Free memory */
+  morpho_scratch_release(ctx, bloc);
+  if(DEBUG) printf(" finished.\n");
+  return err;
+}
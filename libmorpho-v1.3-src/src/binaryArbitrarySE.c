@@ -0,0 +1,464 @@
+/* LIBMORPHO
+ *
+ * binaryArbitrarySE.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file binaryArbitrarySE.c
+ */
+
+#include "arbitraryUtil.h"
+#include "dispatch.h"
+
+/* An image with two values lo < hi is stored with one bit per pixel (1 for
+   hi), 64 pixels per word, pixel x of a row being bit x%64 of word x/64.
+   Each row has BINARY_GUARD(seWidth) guard words on both sides, filled
+   with the value of the border, so that the shifted reads of a row never
+   need to know where the image ends.
+
+   With the structuring element read as in the erosion (the point (i,j) of
+   se reads the pixel (x+i-ox,y+j-oy)), an erosion is the AND of the rows
+   shifted by i-ox, and a dilation the OR of the same shifts for the
+   inverted structuring element. Each run of L consecutive points of a row
+   of se is handled with log2(L) doublings of the source row followed by
+   two shifted reads. */
+
+typedef	unsigned long long bword;
+
+#define	BINARY_BITS		64
+#define	BINARY_GUARD(seWidth)	(((seWidth)+BINARY_BITS-1)/BINARY_BITS+1)
+
+/* acc[k] = acc[k] op (row shifted by s)[k], for k in first..last-1, where
+   bit b of the shifted row is bit b+s of the row (op is AND for an 
+   erosion, OR for a dilation). Words outside of the row read as the
+   neutral element of op */
+static void combine_shifted(bword *acc, bword *row, int total, int first, int last, int s, int dilation)
+{
+int	k,q,qs,r,inFirst,inLast;
+bword	fill,low,high,v;
+
+fill = (dilation) ? 0ULL : ~0ULL;
+qs = (s >= 0) ? s/BINARY_BITS : -((-s+BINARY_BITS-1)/BINARY_BITS);
+r = s-qs*BINARY_BITS;
+
+/* Words k whose sources q=k+qs and q+1 are both in the row */
+inFirst = (first > -qs) ? first : -qs;
+inLast = (last < total-1-qs) ? last : total-1-qs;
+if (inLast < inFirst) inLast = inFirst = last;
+if (inLast > inFirst)
+	{
+	if (dilation) morpho_isa->shifted_or(acc+inFirst, row+inFirst+qs, inLast-inFirst, r);
+	else morpho_isa->shifted_and(acc+inFirst, row+inFirst+qs, inLast-inFirst, r);
+	}
+
+/* Words near the ends of the row */
+for (k=first;k<last;k++)
+	{
+	if (k == inFirst) k = inLast;
+	if (k >= last) break;
+	q = k+qs;
+	low = ( (q >= 0) && (q < total) ) ? row[q] : fill;
+	if (r == 0) 
+		v = low;
+	else
+		{
+		high = ( (q+1 >= 0) && (q+1 < total) ) ? row[q+1] : fill;
+		v = (low >> r) | (high << (BINARY_BITS-r));
+		}
+	if (dilation) acc[k] |= v;
+	else acc[k] &= v;
+	}
+}
+
+/* One erosion (or dilation) of the packed image in into out */
+static void binary_pass(bword *in, bword *out, int total, int nbrWords, int imageHeight,
+			struct binary_pass *pass, int seWidth, int seHeight, bword *doubled, bword *work)
+{
+int	y,j,i,k,run,len,src,guard;
+bword	fill,*row,*aux;
+
+guard = (total-nbrWords)/2;
+fill = (pass->dilation) ? 0ULL : ~0ULL;
+for (y=0;y<imageHeight;y++)
+	{
+	row = out+(size_t)y*total;
+	for (k=0;k<total;k++) row[k] = fill;
+	for (j=0;j<seHeight;j++)
+		{
+		/* Rows of the border are neutral */
+		src = y+j-pass->oy;
+		if ( (src < 0) || (src >= imageHeight) ) continue;
+		for (i=0;i<seWidth;i+=run)
+			{
+			for (run=0; (i+run<seWidth) && (pass->se[i+run+j*seWidth] != 0); run++) ;
+			if (run == 0) { run = 1; continue; }
+			if (run == 1)
+				{
+				combine_shifted(row, in+(size_t)src*total, total, guard, guard+nbrWords, i-pass->ox, pass->dilation);
+				continue;
+				}
+			/* doubled[x] combines the pixels x..x+len-1 of the source row */
+			memcpy(doubled, in+(size_t)src*total, total*sizeof(bword));
+			for (len=1; 2*len<=run; len*=2)
+				{
+				for (k=0;k<total;k++) work[k] = doubled[k];
+				combine_shifted(work, doubled, total, 0, total, len, pass->dilation);
+				aux = doubled; doubled = work; work = aux;
+				}
+			combine_shifted(row, doubled, total, guard, guard+nbrWords, i-pass->ox, pass->dilation);
+			combine_shifted(row, doubled, total, guard, guard+nbrWords, i+run-len-pass->ox, pass->dilation);
+			}
+		}
+	}
+}
+
+/* Sets the guard words, and the bits of the last word beyond the image,
+   to fill */
+static void binary_fill_guards(bword *image, int total, int nbrWords, int imageWidth, int imageHeight, bword fill)
+{
+int	y,k,guard,tail;
+bword	*row,mask;
+
+guard = (total-nbrWords)/2;
+tail = imageWidth%BINARY_BITS;
+mask = (tail == 0) ? 0ULL : (~0ULL << tail);
+for (y=0;y<imageHeight;y++)
+	{
+	row = image+(size_t)y*total;
+	for (k=0;k<guard;k++) row[k] = fill;
+	for (k=guard+nbrWords;k<total;k++) row[k] = fill;
+	row[guard+nbrWords-1] = (row[guard+nbrWords-1] & ~mask) | (fill & mask);
+	}
+}
+
+/****************************************************************/
+/* Returns 1 if the image has at most two values, which are then stored
+   in lo <= hi, 0 otherwise */
+int binary_values(uint8_t *imageIn, int imageWidth, int imageHeight, int inStride, uint8_t *lo, uint8_t *hi)
+{
+int	x,y;
+uint8_t	a,b,*row;
+
+a = b = imageIn[0];
+for (y=0;y<imageHeight;y++)
+	{
+	row = imageIn+(size_t)y*inStride;
+	for (x=0; (x += morpho_isa->find_other(row+x, imageWidth-x, a, b)) < imageWidth; x++)
+		{
+		if (a != b) return 0;
+		b = row[x];
+		}
+	}
+*lo = (a < b) ? a : b;
+*hi = (a < b) ? b : a;
+return 1;
+}
+
+/****************************************************************/
+/* Applies the passes to an image whose values are lo and hi; the bits
+   are unpacked into imageOut after the last pass. The packed images and
+   rows are taken from the MORPHO_SLOT_BORDER slot of ctx. */
+int binary_SE_passes(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride,
+		uint8_t lo, uint8_t hi, int seWidth, int seHeight, struct binary_pass *pass, int nbrPasses, struct morpho_ctx *ctx)
+{
+int	y,p,nbrWords,total,guard;
+size_t	size;
+bword	*memory,*image[2],*doubled,*work,*row;
+uint8_t	*line;
+
+nbrWords = (imageWidth+BINARY_BITS-1)/BINARY_BITS;
+guard = BINARY_GUARD(seWidth);
+total = nbrWords+2*guard;
+size = ((size_t)2*imageHeight+2)*total*sizeof(bword);
+if ( (memory = (bword *)morpho_scratch(ctx, MORPHO_SLOT_BORDER, size)) == NULL)
+	{ perror("Malloc"); return MORPHO_ERROR; }
+image[0] = memory;
+image[1] = image[0]+(size_t)imageHeight*total;
+doubled = image[1]+(size_t)imageHeight*total;
+work = doubled+total;
+
+/* Packing */
+for (y=0;y<imageHeight;y++)
+	{
+	row = image[0]+(size_t)y*total+guard;
+	line = imageIn+(size_t)y*inStride;
+	morpho_isa->pack_bits(line, imageWidth, hi, row);
+	}
+
+for (p=0;p<nbrPasses;p++)
+	{
+	binary_fill_guards(image[p%2], total, nbrWords, imageWidth, imageHeight, (pass[p].dilation) ? 0ULL : ~0ULL);
+	binary_pass(image[p%2], image[(p+1)%2], total, nbrWords, imageHeight, &pass[p], seWidth, seHeight, doubled, work);
+	}
+
+/* Unpacking */
+for (y=0;y<imageHeight;y++)
+	{
+	row = image[nbrPasses%2]+(size_t)y*total+guard;
+	line = imageOut+(size_t)y*outStride;
+	morpho_isa->unpack_bits(row, imageWidth, lo, hi, line);
+	}
+
+morpho_scratch_release(ctx, memory);
+return MORPHO_SUCCESS;
+}
+
+/****************************************************************/
+/* Erosion, dilation, opening or closing of a two-valued image by se */
+static int binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride,
+		uint8_t *se, int seWidth, int seHeight, int ox, int oy, int dilationFirst, int nbrPasses,
+		struct morpho_ctx *ctx, char *func)
+{
+char	st[200];
+struct	binary_pass pass[2];
+uint8_t	lo,hi,*inverted;
+int	p,ret;
+
+if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, func) ) return MORPHO_ERROR;
+if ( (seWidth <= 0) || (seHeight <= 0) || (ox < 0) || (ox >= seWidth) || (oy < 0) || (oy >= seHeight) || (se[ox+oy*seWidth] == 0) )
+	{
+	snprintf(st, 200, "ERROR(%s): the origin of the structuring element must be one of its points.", func);
+	perror(st);
+	return MORPHO_ERROR;
+	}
+if ( !binary_values(imageIn, imageWidth, imageHeight, inStride, &lo, &hi) )
+	{
+	snprintf(st, 200, "ERROR(%s): the image has more than two values.", func);
+	perror(st);
+	return MORPHO_ERROR;
+	}
+
+if ( (inverted = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_FRONTS, seWidth*seHeight*sizeof(uint8_t))) == NULL)
+	{ perror("Malloc"); return MORPHO_ERROR; }
+invert_SE(se, inverted, seWidth, seHeight);
+
+for (p=0;p<nbrPasses;p++)
+	{
+	pass[p].dilation = (p == 0) ? dilationFirst : !dilationFirst;
+	pass[p].se = (pass[p].dilation) ? inverted : se;
+	pass[p].ox = (pass[p].dilation) ? seWidth-1-ox : ox;
+	pass[p].oy = (pass[p].dilation) ? seHeight-1-oy : oy;
+	}
+ret = binary_SE_passes(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, lo, hi, seWidth, seHeight, pass, nbrPasses, ctx);
+
+morpho_scratch_release(ctx, inverted);
+return ret;
+}
+
+/*!
+ * \fn int erosion_binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+ * \param[in]  *imageIn Input buffer (with at most two values)
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *se Buffer containing the shape of a structuring element.
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element. se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element. se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise (in particular if the image has more than two values).
+ *
+ * \brief Erosion of a binary image by an arbitrary structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same result as \ref erosion_arbitrary_SE for an image with two values
+ * (for example a 0/255 mask). The image is packed with one bit per pixel
+ * and eroded 64 pixels at a time by AND operations on shifted words,
+ * instead of a histogram per pixel. \ref erosion_arbitrary_SE switches to
+ * this algorithm by itself when it detects a two-valued image.
+ */
+int erosion_binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+{
+return erosion_binary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, NULL);
+}
+
+/*!
+ * \fn int erosion_binary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer (with at most two values)
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element.
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosion_binary_SE, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ */
+int erosion_binary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+{
+return binary_SE(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, 0, 1, ctx, "erosion_binary_SE");
+}
+
+/*!
+ * \fn int dilation_binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+ * \param[in]  *imageIn Input buffer (with at most two values)
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *se Buffer containing the shape of a structuring element.
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element. se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element. se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise (in particular if the image has more than two values).
+ *
+ * \brief Dilation of a binary image by an arbitrary structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same result as \ref dilation_arbitrary_SE for an image with two values,
+ * computed on an image packed with one bit per pixel (see \ref erosion_binary_SE).
+ */
+int dilation_binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+{
+return dilation_binary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, NULL);
+}
+
+/*!
+ * \fn int dilation_binary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer (with at most two values)
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element.
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref dilation_binary_SE, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ */
+int dilation_binary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+{
+return binary_SE(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, 1, 1, ctx, "dilation_binary_SE");
+}
+
+/*!
+ * \fn int opening_binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+ * \param[in]  *imageIn Input buffer (with at most two values)
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *se Buffer containing the shape of a structuring element.
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element. se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element. se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise (in particular if the image has more than two values).
+ *
+ * \brief Opening of a binary image by an arbitrary structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same result as \ref opening_arbitrary_SE for an image with two values.
+ * The intermediate image stays packed between the erosion and the dilation.
+ */
+int opening_binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+{
+return opening_binary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, NULL);
+}
+
+/*!
+ * \fn int opening_binary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer (with at most two values)
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element.
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref opening_binary_SE, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ */
+int opening_binary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+{
+return binary_SE(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, 0, 2, ctx, "opening_binary_SE");
+}
+
+/*!
+ * \fn int closing_binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+ * \param[in]  *imageIn Input buffer (with at most two values)
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *se Buffer containing the shape of a structuring element.
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element. se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element. se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise (in particular if the image has more than two values).
+ *
+ * \brief Closing of a binary image by an arbitrary structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same result as \ref closing_arbitrary_SE for an image with two values.
+ * The intermediate image stays packed between the dilation and the erosion.
+ */
+int closing_binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+{
+return closing_binary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, NULL);
+}
+
+/*!
+ * \fn int closing_binary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer (with at most two values)
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element.
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref closing_binary_SE, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ */
+int closing_binary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+{
+return binary_SE(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, 1, 2, ctx, "closing_binary_SE");
+}
@@ -51,12 +51,66 @@
  */
 int closing_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
 {
+return closing_arbitrary_SE_stride(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin);
+}
+
+/*!
+ * \fn int closing_arbitrary_SE_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref closing_arbitrary_SE, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ *
+ * Rows of the input and output buffers need not be contiguous, so that
+ * a region of interest of a larger frame can be processed in place.
+ */
+int closing_arbitrary_SE_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+{
+return closing_arbitrary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, NULL);
+}
+
+/*!
+ * \fn int closing_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref closing_arbitrary_SE_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int closing_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+{
 uint8_t	*bloc;
 
 if (DEBUG) printf("Running closing_arbitrary_SE\n");
 
 /* Allocates a new picture */
-if ( (bloc = (uint8_t *)malloc(imageWidth*imageHeight*sizeof(uint8_t))) == NULL)
+if ( (bloc = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, imageWidth*imageHeight*sizeof(uint8_t))) == NULL)
 	{
 	perror("Malloc");
 	return MORPHO_ERROR;
@@ -64,12 +118,89 @@ if ( (bloc = (uint8_t *)malloc(imageWidth*imageHeight*sizeof(uint8_t))) == NULL)
 
 
 /* Steps include: erosion, invert SE, and dilation */
-if (MORPHO_ERROR == dilation_arbitrary_SE( imageIn, bloc, imageWidth, imageHeight, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin) ) return MORPHO_ERROR;
+if (MORPHO_ERROR == dilation_arbitrary_SE_ctx(imageIn, bloc, imageWidth, imageHeight, inStride, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, ctx) ) return MORPHO_ERROR;
+
+if (MORPHO_ERROR == erosion_arbitrary_SE_ctx(bloc, imageOut, imageWidth, imageHeight, imageWidth, outStride, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, ctx) ) return MORPHO_ERROR;
+
+/* Free the data */
+morpho_scratch_release(ctx, bloc); 
+
+return MORPHO_SUCCESS;
+}
+
+/*!
+ * \fn int closing_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image (must be the width the plan was created for)
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  plan Plan of the structuring element, created by \ref morpho_se_plan_create
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Closing by a precomputed structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref closing_arbitrary_SE_ctx, but the analysis of the structuring 
+ * element is read from the plan instead of being computed at each call.
+ */
+int closing_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx)
+{
+uint8_t	*bloc;
+
+if (DEBUG) printf("Running closing_arbitrary_SE_plan\n");
+
+/* Allocates a new picture */
+if ( (bloc = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, imageWidth*imageHeight*sizeof(uint8_t))) == NULL)
+	{
+	perror("Malloc");
+	return MORPHO_ERROR;
+	}
+
+/* Steps include: dilation and erosion */
+if (MORPHO_ERROR == dilation_arbitrary_SE_plan(imageIn, bloc, imageWidth, imageHeight, inStride, imageWidth, plan, ctx) ) return MORPHO_ERROR;
 
-if (MORPHO_ERROR == erosion_arbitrary_SE(bloc, imageOut, imageWidth, imageHeight, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin) ) return MORPHO_ERROR;
+if (MORPHO_ERROR == erosion_arbitrary_SE_plan(bloc, imageOut, imageWidth, imageHeight, imageWidth, outStride, plan, ctx) ) return MORPHO_ERROR;
 
 /* Free the data */
-free(bloc); 
+morpho_scratch_release(ctx, bloc); 
 
 return MORPHO_SUCCESS;
 }
+
+/*!
+ * \fn int closing_arbitrary_SE_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int nbrThreads)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \param[in]  nbrThreads Number of threads (<= 0 selects \ref morpho_get_num_threads)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Multithreaded closing by an arbitrary structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref closing_arbitrary_SE, but the rows are split into bands that are 
+ * scanned in parallel, each with a histogram of its own. The result is 
+ * identical to that of the single-threaded version.
+ */
+int closing_arbitrary_SE_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int nbrThreads)
+{
+struct	morpho_ctx *ctx;
+int	ret;
+
+if ( (ctx = morpho_ctx_create(0, 0, 0, 0)) == NULL) return MORPHO_ERROR;
+morpho_ctx_set_num_threads(ctx, nbrThreads);
+ret = closing_arbitrary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, ctx);
+morpho_ctx_free(ctx);
+return ret;
+}
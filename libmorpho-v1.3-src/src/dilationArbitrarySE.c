@@ -50,16 +50,120 @@
  */
 int dilation_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
 {
+return dilation_arbitrary_SE_stride(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin);
+}
+
+/*!
+ * \fn int dilation_arbitrary_SE_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref dilation_arbitrary_SE, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ *
+ * Rows of the input and output buffers need not be contiguous, so that
+ * a region of interest of a larger frame can be processed in place.
+ */
+int dilation_arbitrary_SE_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+{
+return dilation_arbitrary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, NULL);
+}
+
+/*!
+ * \fn int dilation_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref dilation_arbitrary_SE_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int dilation_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+{
+struct	morpho_se_plan plan;
+struct	front_store store;
+void	*planBuffer;
+size_t	size;
+int	ret;
+
+/* We proceed to the analysis of the structuring element */
+size = se_plan_size(seWidth, seHeight, PLAN_DILATION);
+if ( (planBuffer = morpho_scratch(ctx, MORPHO_SLOT_FRONTS, size)) == NULL)
+	{ perror("Malloc"); return MORPHO_ERROR; }
+store.next = (char *)planBuffer;
+store.end = store.next+size;
+if ( MORPHO_SUCCESS != se_plan_init(&plan, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, imageWidth, 0, PLAN_DILATION, &store) )
+	{
+	perror("ERROR(dilation_arbitrary_SE): analyse_b did not return a valid code");
+	morpho_scratch_release(ctx, planBuffer);
+	return MORPHO_ERROR;
+	}
+
+ret = dilation_arbitrary_SE_plan(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, &plan, ctx);
+
+morpho_scratch_release(ctx, planBuffer);
+return ret;
+}
+
+/*!
+ * \fn int dilation_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image (must be the width the plan was created for)
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  plan Plan of the structuring element, created by \ref morpho_se_plan_create
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Dilation by a precomputed structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref dilation_arbitrary_SE_ctx, but the analysis of the structuring 
+ * element is read from the plan instead of being computed at each call.
+ */
+int dilation_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx)
+{
 char st[200];
 
-uint8_t	*bloc;
-struct	front *l,*r,*u,*d;
-int	i,j,ret;
-int  	blocWidth, blocHeight;
-uint8_t	*se2;
-int	se2HorizontalOrigin, se2VerticalOrigin;
+int	ret;
+uint8_t	lo,hi;
+struct	binary_pass pass;
+int	seWidth, seHeight;
 
 /* Test the compatibility */
+if ( MORPHO_ERROR == is_plan_valid(plan, 0, imageWidth, PLAN_DILATION, "dilation_arbitrary_SE") ) return MORPHO_ERROR;
+seWidth = plan->seWidth;
+seHeight = plan->seHeight;
+
+if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "dilation_arbitrary_SE") ) return MORPHO_ERROR;
+
 if (imageWidth <= seWidth) 
 	{ 
 	snprintf(st, 200, "ERROR(%s): size(=%d) of the structuring elements should be larger than the image one(=%d).", "dilation_arbitrary_SE", seWidth, imageWidth);        
@@ -74,141 +178,160 @@ if (imageHeight <= seHeight)
         return MORPHO_ERROR;
         }
 
-/* First of all we invert the structuring function */
-if ( (se2 = (uint8_t *)malloc(seWidth*seHeight*sizeof(uint8_t))) == NULL)
-	{ perror("Malloc"); return MORPHO_ERROR; }
-invert_SE(se, se2, seWidth, seHeight);
-se2HorizontalOrigin = seWidth-1-seHorizontalOrigin;
-se2VerticalOrigin = seHeight-1-seVerticalOrigin;
-
-/* We proceed to the analysis of the structuring element 
-   and search for an origin */
-l = (struct front *)malloc(sizeof(struct front));
-r = (struct front *)malloc(sizeof(struct front));
-u = (struct front *)malloc(sizeof(struct front));
-d = (struct front *)malloc(sizeof(struct front));
-if ( MORPHO_SUCCESS != analyse_b(se2,seWidth,seHeight, l,r,u,d, se2HorizontalOrigin, se2VerticalOrigin) 
-   )
-	{
-	perror("ERROR(dilation_arbitrary_SE): analyse_b did not return a valid code");
-	return MORPHO_ERROR;
-	}
-
-/* Allocate a new picture with a border */
-blocWidth = imageWidth+seWidth*2;
-blocHeight = imageHeight+seHeight*2;
-bloc = (uint8_t *)malloc(blocWidth*blocHeight*sizeof(uint8_t));
-for (i=0; i<blocWidth*blocHeight; i++) bloc[i]=SMALLEST_UINT8;
-for (j=0;j<imageHeight;j++)
-  for (i=0;i<imageWidth;i++)  
-	bloc[i+seWidth+(j+seHeight)*blocWidth] = imageIn[i+j*imageWidth];
-
-/* Transforms the information contained in the front structures */
-if ( MORPHO_SUCCESS != transform_b(blocWidth,l,r,u,d) )
+/* A two-valued image (a mask) is processed with one bit per pixel */
+if ( binary_values(imageIn, imageWidth, imageHeight, inStride, &lo, &hi) )
 	{
-	perror("ERROR(dilation_arbitrary_SE): transform_b did not return a valid code");
-	return MORPHO_ERROR;
+	pass.se = plan->dilation.se;
+	pass.ox = plan->dilation.ox;
+	pass.oy = plan->dilation.oy;
+	pass.dilation = 1;
+	return binary_SE_passes(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, lo, hi, seWidth, seHeight, &pass, 1, ctx);
 	}
 
-/* Proceed to the dilation; 
-   ATTENTION: sizeof(im_inter->f...) != sizeof(im_out->f...) */
-ret = dilation_volume(bloc,blocWidth,blocHeight, imageOut,imageWidth,imageHeight, se,seWidth,seHeight, l,r,u,d, se2HorizontalOrigin,se2VerticalOrigin);
+/* Proceed directly on the input image; only the strips of the border 
+   are built by volume_run */
+ret = volume_run(imageIn,inStride, imageOut,imageWidth,imageHeight,outStride, plan, 1, ctx);
 
 if ( MORPHO_SUCCESS != ret)
 	{
-	perror("ERROR(dilation_arbitrary_SE): dilation_volume did not return a valid code");
+	perror("ERROR(dilation_arbitrary_SE): volume_run did not return a valid code");
 	return MORPHO_ERROR;
 	}
 
-/* Free the data */
-free(bloc); 
-free(se2);
-free_front(l); free_front(r); free_front(u); free_front(d);
-free(l); free(r); free(u); free(d);
 return MORPHO_SUCCESS;
 }
 
+/*!
+ * \fn int dilation_arbitrary_SE_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int nbrThreads)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \param[in]  nbrThreads Number of threads (<= 0 selects \ref morpho_get_num_threads)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Multithreaded dilation by an arbitrary structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref dilation_arbitrary_SE, but the rows are split into bands that are 
+ * scanned in parallel, each with a histogram of its own. The result is 
+ * identical to that of the single-threaded version.
+ */
+int dilation_arbitrary_SE_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int nbrThreads)
+{
+struct	morpho_ctx *ctx;
+int	ret;
+
+if ( (ctx = morpho_ctx_create(0, 0, 0, 0)) == NULL) return MORPHO_ERROR;
+morpho_ctx_set_num_threads(ctx, nbrThreads);
+ret = dilation_arbitrary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, ctx);
+morpho_ctx_free(ctx);
+return ret;
+}
+
 /*************************************************************/
 /* Dilation procedure		                             */
 /* ATTENTION: sizeof(in) != sizeof(out) 		     */
 /*************************************************************/
-int dilation_volume(	uint8_t *bloc, int blocWidth, int blocHeight,
-		uint8_t *out, int imageWidth, int imageHeight,
+int dilation_volume(	struct volume_src *src,
+		uint8_t *out, int imageWidth, int imageHeight, int outStride,
 		uint8_t *se, int bh, int bv,
 		struct front *l, struct front *r, struct front *u, struct front *d,
-		int ox,int oy)
+		int ox,int oy, int lineFirst, int lineLast, int histogram)
 {
 uint8_t	max,*corner,val;
-int	i,space[256],*histo,col,*pos,line,lx,n;
+int	i,space[256],col,*pos,line,lx,n;
+uint8_t	*data;
+int	*lpos,*rpos,s,nbrSegments;
+struct	scan_segment seg[3];
+struct	morpho_histogram h;
 
 
 /* Build the first histogram */
-for (i=0;i<=255;i++)  space[i]=0;
-histo = space;
+histo_init(&h, space, 0, histogram);
+histo_reset(&h, 256);
 for (i=0;i<bh*bv;i++)
    if (se[i] != 0)	
-	histo[0]++;
+	histo_add(&h, 0);
 max=SMALLEST_UINT8;
 
-/* Each line is scanned through */
-for (line=0;line<imageHeight+bv;line++)
+/* Each line is scanned through. At both ends of a line the window only
+   covers the border, so that the histogram is the same at the beginning 
+   of every line and the scan can start at any line */
+for (line=lineFirst;line<lineLast;line++)
   if (line%2 == 0)
     {
-    lx = line*blocWidth;
+    nbrSegments = scan_segments(src, line, seg);
     /* From left to right */
-    for (col=0;col<imageWidth+bh;col++)
+    for (s=0;s<nbrSegments;s++)
+      {
+      data = (uint8_t *)seg[s].region->data; lx = seg[s].lx;
+      lpos = seg[s].region->lpos; rpos = seg[s].region->rpos;
+      for (col=seg[s].first;col<seg[s].last;col++)
 	{
-	corner = &bloc[col+lx];
+	corner = &data[col+lx];
 	/* Updates the histogram */
 	/* 1. Adding "flat" pixels */
- 	   pos=r->pos; 
+ 	   pos=rpos; 
    	   for (n=0;n<r->size;n++)
 		{
 		val = *(corner+((*pos)+1));
-		histo[val]++;
+		histo_add(&h, val);
 		if (val > max) max=val;
 		pos++; 
 		}
 	/* 3. Removing "flat" pixels */
- 	   pos=l->pos; 
+ 	   pos=lpos; 
    	   for (n=0;n<l->size;n++)   
-		{ histo[*(corner+*pos)]--; pos++; }
+		{ histo_remove(&h, *(corner+*pos)); pos++; }
 	/* Recomputes the maximum if necessary */
-	while (histo[max] == 0) max--;
+	max = histo_last(&h, max);
 	/* Puts the value in the picture */
 	if ( (col+1+ox>=bh) && (col+1-bh+ox<imageWidth) && 
 	        (line-bv+oy>=0) && (line-bv+oy<imageHeight) )
-			out[col+1-bh+ox+(line-bv+oy)*imageWidth] = max;
+			out[col+1-bh+ox+(line-bv+oy)*outStride] = max;
 	}
+      }
     }
   else 
     {
-    lx = line*blocWidth;
+    nbrSegments = scan_segments(src, line, seg);
     /* From right to left */
-    for (col=imageWidth+bh;col>0;col--)
+    for (s=0;s<nbrSegments;s++)
+      {
+      data = (uint8_t *)seg[s].region->data; lx = seg[s].lx;
+      lpos = seg[s].region->lpos; rpos = seg[s].region->rpos;
+      for (col=seg[s].first;col>seg[s].last;col--)
 	{
-	corner = &bloc[col+lx];
+	corner = &data[col+lx];
 	/* Updates the histogram */
 	/* 1. Adding "flat" pixels */
- 	   pos=l->pos; 
+ 	   pos=lpos; 
    	   for (n=0;n<l->size;n++)
 		{
 		val = *(corner+((*pos)-1));
-		histo[val]++;
+		histo_add(&h, val);
 		if (val > max) max=val;
 		pos++; 
 		}
 	/* 3. Removing "flat" pixels */
- 	   pos=r->pos; 
+ 	   pos=rpos; 
    	   for (n=0;n<r->size;n++)   
-		{ histo[*(corner+*pos)]--; pos++;  }
+		{ histo_remove(&h, *(corner+*pos)); pos++;  }
 	/* Recomputes the maximum if necessary */
-	while (histo[max] == 0) max--;
+	max = histo_last(&h, max);
 	/* Put the value in the picture */
 	if ( (col-1+ox>=bh) && (col-1-bh+ox<imageWidth) && 
 	        (line-bv+oy>=0) && (line-bv+oy<imageHeight) )
-			out[col-1-bh+ox+(line-bv+oy)*imageWidth] = max;
+			out[col-1-bh+ox+(line-bv+oy)*outStride] = max;
 	}
+      }
     }
 
 return MORPHO_SUCCESS;
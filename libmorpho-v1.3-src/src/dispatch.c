@@ -0,0 +1,135 @@
+/* LIBMORPHO
+ *
+ * dispatch.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file dispatch.c
+ */ 
+
+#include "dispatch.h"
+
+/* Kernels used by all the operators. They are chosen once, when the
+   library is loaded, and may be changed by morpho_set_isa(). */
+const struct morpho_kernels *morpho_isa = &morpho_kernels_scalar;
+
+/* Kernels of each level of enum morpho_isa_level */
+static const struct morpho_kernels *isa_kernels(int level)
+{
+#if MORPHO_X86_DISPATCH
+  switch (level)
+    {
+    case MORPHO_ISA_SSE2: return &morpho_kernels_sse2;
+    case MORPHO_ISA_AVX2: return &morpho_kernels_avx2;
+    case MORPHO_ISA_AVX512: return &morpho_kernels_avx512;
+    }
+#endif
+  return &morpho_kernels_scalar;
+}
+
+/* Tells if the processor (and the operating system) support a level. The
+   features are read by cpuid, through the builtins of the compiler. */
+static int isa_supported(int level)
+{
+#if MORPHO_X86_DISPATCH
+  __builtin_cpu_init();
+  switch (level)
+    {
+    case MORPHO_ISA_SSE2: return __builtin_cpu_supports("sse2");
+    case MORPHO_ISA_AVX2: return __builtin_cpu_supports("avx2");
+    case MORPHO_ISA_AVX512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    }
+#endif
+  return (level == MORPHO_ISA_SCALAR);
+}
+
+/* Level whose name is isa, or -1 */
+static int isa_level(const char *isa)
+{
+  int level;
+
+  for (level=0; level<MORPHO_NBR_ISA; level++)
+    if (strcmp(isa, isa_kernels(level)->name) == 0) { return level; }
+  return -1;
+}
+
+/* Selects the most capable kernels supported by the processor, or those 
+   named by the LIBMORPHO_ISA environment variable if the processor 
+   supports them */
+#if defined(__GNUC__)
+__attribute__((constructor))
+#endif
+static void isa_select(void)
+{
+  char	*isa;
+  int	level,best;
+
+  for (best=MORPHO_NBR_ISA-1; !isa_supported(best); best--) ;
+  isa = getenv("LIBMORPHO_ISA");
+  if (isa != NULL)
+    {
+      level = isa_level(isa);
+      if ( (level >= 0) && (level < best) ) { best = level; }
+    }
+  morpho_isa = isa_kernels(best);
+}
+
+/*!
+ * \fn const char *morpho_get_isa(void)
+ * \return Returns the name of the instruction set used by the library.
+ * \brief Tells which instruction set is used by the library
+ * \ingroup libmorpho
+ *
+ * The innermost loops of the library (pixelwise minima and maxima of rows,
+ * transpositions, packing of binary images, ...) are compiled for several
+ * instruction sets: "scalar", "sse2", "avx2" and "avx512" (AVX-512 F and 
+ * BW) on x86 processors, "scalar" elsewhere. When the library is loaded, 
+ * the most capable set supported by the processor is selected, unless the
+ * environment variable LIBMORPHO_ISA names a less capable one. 
+ */
+const char *morpho_get_isa(void)
+{
+  return morpho_isa->name;
+}
+
+/*!
+ * \fn int morpho_set_isa(const char *isa)
+ * \param[in]  isa Name of an instruction set: "scalar", "sse2", "avx2" or "avx512"
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR if the instruction set is unknown or not supported by the processor.
+ * \brief Selects the instruction set used by the library
+ * \ingroup libmorpho
+ *
+ * Overrides the choice made when the library was loaded (see 
+ * \ref morpho_get_isa), for instance to compare the instruction sets. It
+ * must not be called while an operator is running. The results do not 
+ * depend on the instruction set.
+ */
+int morpho_set_isa(const char *isa)
+{
+  char	st[200];
+  int	level;
+
+  level = (isa == NULL) ? -1 : isa_level(isa);
+  if ( (level < 0) || !isa_supported(level) ) {
+    snprintf(st, 200, "ERROR(morpho_set_isa): instruction set %s is not available", (isa == NULL) ? "(null)" : isa);
+    perror(st);
+    return MORPHO_ERROR;
+  }
+  morpho_isa = isa_kernels(level);
+  return MORPHO_SUCCESS;
+}
@@ -0,0 +1,98 @@
+/* LIBMORPHO
+ *
+ * dispatch.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "libmorpho.h"
+
+#ifndef __DISPATCH__
+#define __DISPATCH__
+
+/* The SIMD variants of the kernels are compiled with the target attributes
+   of GCC and clang, whatever the flags of the build, and selected at run
+   time. Other compilers and processors only get the scalar kernels. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define	MORPHO_X86_DISPATCH	1
+#else
+#define	MORPHO_X86_DISPATCH	0
+#endif
+
+/* Instruction sets, from the least to the most capable */
+enum	morpho_isa_level
+	{
+	MORPHO_ISA_SCALAR,
+	MORPHO_ISA_SSE2,
+	MORPHO_ISA_AVX2,
+	MORPHO_ISA_AVX512,
+	MORPHO_NBR_ISA
+	};
+
+/* Hot loops of the library, implemented once per instruction set */
+struct	morpho_kernels
+	{
+	const char *name;
+	/* out[x] = min (max) of a[x] and b[x], x < n; out may be a or b */
+	void	(*rows_min)(uint8_t *a, uint8_t *b, uint8_t *out, int n);
+	void	(*rows_max)(uint8_t *a, uint8_t *b, uint8_t *out, int n);
+	/* out[x] = a[x] - b[x], clipped to 0, x < n; out may be a or b */
+	void	(*rows_sub)(uint8_t *a, uint8_t *b, uint8_t *out, int n);
+	/* out[x*outStride+y] = in[y*inStride+x], for a width x height input */
+	void	(*transpose)(uint8_t *in, int inStride, uint8_t *out, int outStride, int width, int height);
+	/* Index of the first of the n pixels of line that is neither a nor b (n if none) */
+	int	(*find_other)(uint8_t *line, int n, uint8_t a, uint8_t b);
+	/* Bit x%64 of words[x/64] = (line[x] == hi); the bits beyond n are 0 */
+	void	(*pack_bits)(uint8_t *line, int n, uint8_t hi, unsigned long long *words);
+	/* line[x] = hi if bit x%64 of words[x/64] is set, lo otherwise */
+	void	(*unpack_bits)(unsigned long long *words, int n, uint8_t lo, uint8_t hi, uint8_t *line);
+	/* acc[k] &= (|=) (row[k] >> r) | (row[k+1] << (64-r)), for k < n and
+	   0 <= r < 64; row[n] must be readable */
+	void	(*shifted_and)(unsigned long long *acc, unsigned long long *row, int n, int r);
+	void	(*shifted_or)(unsigned long long *acc, unsigned long long *row, int n, int r);
+	};
+
+/* Side of the tiles of the transpositions */
+#define	TRANSPOSE_TILE	16
+
+/* Kernels selected for the processor (see dispatch.c) */
+extern const struct morpho_kernels *morpho_isa;
+
+/* Kernels of each instruction set (kernelsScalar.c, kernelsSSE2.c, ...) */
+extern const struct morpho_kernels morpho_kernels_scalar;
+#if MORPHO_X86_DISPATCH
+extern const struct morpho_kernels morpho_kernels_sse2;
+extern const struct morpho_kernels morpho_kernels_avx2;
+extern const struct morpho_kernels morpho_kernels_avx512;
+#endif
+
+/* kernelsScalar.c; the SIMD kernels use them for the last pixels of a line */
+void kernel_rows_min(uint8_t *a, uint8_t *b, uint8_t *out, int n);
+void kernel_rows_max(uint8_t *a, uint8_t *b, uint8_t *out, int n);
+void kernel_rows_sub(uint8_t *a, uint8_t *b, uint8_t *out, int n);
+void kernel_transpose(uint8_t *in, int inStride, uint8_t *out, int outStride, int width, int height);
+int kernel_find_other(uint8_t *line, int n, uint8_t a, uint8_t b);
+void kernel_pack_bits(uint8_t *line, int n, uint8_t hi, unsigned long long *words);
+void kernel_unpack_bits(unsigned long long *words, int n, uint8_t lo, uint8_t hi, uint8_t *line);
+void kernel_shifted_and(unsigned long long *acc, unsigned long long *row, int n, int r);
+void kernel_shifted_or(unsigned long long *acc, unsigned long long *row, int n, int r);
+
+#if MORPHO_X86_DISPATCH
+/* kernelsSSE2.c; also used by the more capable instruction sets */
+void kernel_transpose_sse2(uint8_t *in, int inStride, uint8_t *out, int outStride, int width, int height);
+#endif
+
+#endif
@@ -50,14 +50,120 @@
  */
 int erosion_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
 {
+return erosion_arbitrary_SE_stride(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin);
+}
+
+/*!
+ * \fn int erosion_arbitrary_SE_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosion_arbitrary_SE, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ *
+ * Rows of the input and output buffers need not be contiguous, so that
+ * a region of interest of a larger frame can be processed in place.
+ */
+int erosion_arbitrary_SE_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+{
+return erosion_arbitrary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, NULL);
+}
+
+/*!
+ * \fn int erosion_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosion_arbitrary_SE_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int erosion_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx)
+{
+struct	morpho_se_plan plan;
+struct	front_store store;
+void	*planBuffer;
+size_t	size;
+int	ret;
+
+/* We proceed to the analysis of the structuring element */
+size = se_plan_size(seWidth, seHeight, PLAN_EROSION);
+if ( (planBuffer = morpho_scratch(ctx, MORPHO_SLOT_FRONTS, size)) == NULL)
+	{ perror("Malloc"); return MORPHO_ERROR; }
+store.next = (char *)planBuffer;
+store.end = store.next+size;
+if ( MORPHO_SUCCESS != se_plan_init(&plan, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, imageWidth, 0, PLAN_EROSION, &store) )
+	{
+	perror("ERROR(erosion_arbitrary_SE): analyse_b did not return a valid code");
+	morpho_scratch_release(ctx, planBuffer);
+	return MORPHO_ERROR;
+	}
+
+ret = erosion_arbitrary_SE_plan(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, &plan, ctx);
+
+morpho_scratch_release(ctx, planBuffer);
+return ret;
+}
+
+/*!
+ * \fn int erosion_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image (must be the width the plan was created for)
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  plan Plan of the structuring element, created by \ref morpho_se_plan_create
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Erosion by a precomputed structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref erosion_arbitrary_SE_ctx, but the analysis of the structuring 
+ * element is read from the plan instead of being computed at each call.
+ */
+int erosion_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx)
+{
 char st[200];
 
-uint8_t	*bloc;
-struct	front *l,*r,*u,*d;
-int	i,j,ret;
-int  	blocWidth, blocHeight;
+int	ret;
+uint8_t	lo,hi;
+struct	binary_pass pass;
+int	seWidth, seHeight;
 
 /* Test the compatibility */
+if ( MORPHO_ERROR == is_plan_valid(plan, 0, imageWidth, PLAN_EROSION, "erosion_arbitrary_SE") ) return MORPHO_ERROR;
+seWidth = plan->seWidth;
+seHeight = plan->seHeight;
+
+if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "erosion_arbitrary_SE") ) return MORPHO_ERROR;
+
 if (imageWidth <= seWidth) 
 	{ 
 	snprintf(st, 200, "ERROR(%s): size(=%d) of the structuring elements should be larger than the image one(=%d).", "erosion_arbitrary_SE", seWidth, imageWidth);        
@@ -72,134 +178,160 @@ if (imageHeight <= seHeight)
         return MORPHO_ERROR;
         }
 
-/* First, we proceed to the analysis of the structuring element 
-   and search for an origin */
-l = (struct front *)malloc(sizeof(struct front));
-r = (struct front *)malloc(sizeof(struct front));
-u = (struct front *)malloc(sizeof(struct front));
-d = (struct front *)malloc(sizeof(struct front));
-if ( MORPHO_SUCCESS != analyse_b(se,seWidth,seHeight, l,r,u,d, seHorizontalOrigin, seVerticalOrigin) 
-   )
+/* A two-valued image (a mask) is processed with one bit per pixel */
+if ( binary_values(imageIn, imageWidth, imageHeight, inStride, &lo, &hi) )
 	{
-	perror("ERROR(erosion_arbitrary_SE): analyse_b did not return a valid code");
-	return MORPHO_ERROR;
-	}
-
-/* Allocate a new picture with a border */
-blocWidth = imageWidth+seWidth*2;
-blocHeight = imageHeight+seHeight*2;
-bloc = (uint8_t *)malloc(blocWidth*blocHeight*sizeof(uint8_t));
-for (i=0; i<blocWidth*blocHeight; i++) bloc[i]=LARGEST_UINT8;
-for (j=0;j<imageHeight;j++)
-  for (i=0;i<imageWidth;i++)  
-	bloc[i+seWidth+(j+seHeight)*blocWidth] = imageIn[i+j*imageWidth];
-
-/* Transforms the information contained in the front structures */
-if ( MORPHO_SUCCESS != transform_b(blocWidth,l,r,u,d) )
-	{
-	perror("ERROR(erosion_arbitrary_SE): transform_b did not return a valid code");
-	return MORPHO_ERROR;
+	pass.se = plan->erosion.se;
+	pass.ox = plan->erosion.ox;
+	pass.oy = plan->erosion.oy;
+	pass.dilation = 0;
+	return binary_SE_passes(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, lo, hi, seWidth, seHeight, &pass, 1, ctx);
 	}
 
-/* Proceed to the erosion; 
-   ATTENTION: sizeof(im_inter->f...) != sizeof(im_out->f...) */
-ret = erosion_volume(bloc,blocWidth,blocHeight, imageOut,imageWidth,imageHeight, se,seWidth,seHeight,
-		l,r,u,d, seHorizontalOrigin,seVerticalOrigin);
+/* Proceed directly on the input image; only the strips of the border 
+   are built by volume_run */
+ret = volume_run(imageIn,inStride, imageOut,imageWidth,imageHeight,outStride, plan, 0, ctx);
 
 if ( MORPHO_SUCCESS != ret)
 	{
-	perror("ERROR(erosion_arbitrary_SE): erosion_volume did not return a valid code");
+	perror("ERROR(erosion_arbitrary_SE): volume_run did not return a valid code");
 	return MORPHO_ERROR;
 	}
 
-/* Free the data */
-free(bloc); 
-free_front(l); free_front(r); free_front(u); free_front(d);
-free(l); free(r); free(u); free(d);
 return MORPHO_SUCCESS;
 }
 
+/*!
+ * \fn int erosion_arbitrary_SE_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int nbrThreads)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \param[in]  nbrThreads Number of threads (<= 0 selects \ref morpho_get_num_threads)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Multithreaded erosion by an arbitrary structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref erosion_arbitrary_SE, but the rows are split into bands that are 
+ * scanned in parallel, each with a histogram of its own. The result is 
+ * identical to that of the single-threaded version.
+ */
+int erosion_arbitrary_SE_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int nbrThreads)
+{
+struct	morpho_ctx *ctx;
+int	ret;
+
+if ( (ctx = morpho_ctx_create(0, 0, 0, 0)) == NULL) return MORPHO_ERROR;
+morpho_ctx_set_num_threads(ctx, nbrThreads);
+ret = erosion_arbitrary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, ctx);
+morpho_ctx_free(ctx);
+return ret;
+}
+
 /*************************************************************/
 /* Erosion procedure		                             */
 /* ATTENTION: sizeof(in) != sizeof(out) 		     */
 /*************************************************************/
-int erosion_volume(	uint8_t *bloc, int blocWidth, int blocHeight,
-		uint8_t *out, int imageWidth, int imageHeight,
+int erosion_volume(	struct volume_src *src,
+		uint8_t *out, int imageWidth, int imageHeight, int outStride,
 		uint8_t *se, int bh, int bv,
 		struct front *l, struct front *r, struct front *u, struct front *d,
-		int ox,int oy)
+		int ox,int oy, int lineFirst, int lineLast, int histogram)
 {
 uint8_t	min,*corner,val;
-int	i,space[256],*histo,col,*pos,line,lx,n;
+int	i,space[256],col,*pos,line,lx,n;
+uint8_t	*data;
+int	*lpos,*rpos,s,nbrSegments;
+struct	scan_segment seg[3];
+struct	morpho_histogram h;
 
 
 /* Build the first histogram */
-for (i=0;i<=255;i++)  space[i]=0;
-histo = space;
+histo_init(&h, space, 0, histogram);
+histo_reset(&h, 256);
 for (i=0;i<bh*bv;i++)
    if (se[i] != 0)	
-	histo[LARGEST_UINT8]++;
+	histo_add(&h, LARGEST_UINT8);
 min=LARGEST_UINT8;
 
-/* Each line is scanned through */
-for (line=0;line<imageHeight+bv;line++)
+/* Each line is scanned through. At both ends of a line the window only
+   covers the border, so that the histogram is the same at the beginning 
+   of every line and the scan can start at any line */
+for (line=lineFirst;line<lineLast;line++)
   if (line%2 == 0)
     {
-    lx = line*blocWidth;
+    nbrSegments = scan_segments(src, line, seg);
     /* From left to right */
-    for (col=0;col<imageWidth+bh;col++)
+    for (s=0;s<nbrSegments;s++)
+      {
+      data = (uint8_t *)seg[s].region->data; lx = seg[s].lx;
+      lpos = seg[s].region->lpos; rpos = seg[s].region->rpos;
+      for (col=seg[s].first;col<seg[s].last;col++)
 	{
-	corner = &bloc[col+lx];
+	corner = &data[col+lx];
 	/* Updates the histogram */
 	/* 1. Adding "flat" pixels */
- 	   pos=r->pos; 
+ 	   pos=rpos; 
    	   for (n=0;n<r->size;n++)
 		{
 		val = *(corner+((*pos)+1));
-		histo[val]++;
+		histo_add(&h, val);
 		if (val < min) min=val;
 		pos++; 
 		}
 	/* 3. Removing "flat" pixels */
- 	   pos=l->pos; 
+ 	   pos=lpos; 
    	   for (n=0;n<l->size;n++)   
-		{ histo[*(corner+*pos)]--; pos++; }
+		{ histo_remove(&h, *(corner+*pos)); pos++; }
 	/* Recomputes the minimum if necessary */
-	while (histo[min] == 0) min++;
+	min = histo_first(&h, min);
 	/* Puts the value in the picture */
 	if ( (col+1+ox>=bh) && (col+1-bh+ox<imageWidth) && 
 	        (line-bv+oy>=0) && (line-bv+oy<imageHeight) )
-			out[col+1-bh+ox+(line-bv+oy)*imageWidth] = min;
+			out[col+1-bh+ox+(line-bv+oy)*outStride] = min;
 	}
+      }
     }
   else 
     {
-    lx = line*blocWidth;
+    nbrSegments = scan_segments(src, line, seg);
     /* From right to left */
-    for (col=imageWidth+bh;col>0;col--)
+    for (s=0;s<nbrSegments;s++)
+      {
+      data = (uint8_t *)seg[s].region->data; lx = seg[s].lx;
+      lpos = seg[s].region->lpos; rpos = seg[s].region->rpos;
+      for (col=seg[s].first;col>seg[s].last;col--)
 	{
-	corner = &bloc[col+lx];
+	corner = &data[col+lx];
 	/* Updates the histogram */
 	/* 1. Adding "flat" pixels */
- 	   pos=l->pos; 
+ 	   pos=lpos; 
    	   for (n=0;n<l->size;n++)
 		{
 		val = *(corner+((*pos)-1));
-		histo[val]++;
+		histo_add(&h, val);
 		if (val < min) min=val;
 		pos++; 
 		}
 	/* 3. Removing "flat" pixels */
- 	   pos=r->pos; 
+ 	   pos=rpos; 
    	   for (n=0;n<r->size;n++)   
-		{ histo[*(corner+*pos)]--; pos++;  }
+		{ histo_remove(&h, *(corner+*pos)); pos++;  }
 	/* Recomputes the minimum if necessary */
-	while (histo[min] == 0) min++;
+	min = histo_first(&h, min);
 	/* Put the value in the picture */
 	if ( (col-1+ox>=bh) && (col-1-bh+ox<imageWidth) && 
 	        (line-bv+oy>=0) && (line-bv+oy<imageHeight) )
-			out[col-1-bh+ox+(line-bv+oy)*imageWidth] = min;
+			out[col-1-bh+ox+(line-bv+oy)*outStride] = min;
 	}
+      }
     }
 
 return MORPHO_SUCCESS;
@@ -54,15 +54,118 @@
  */
 int erosion_arbitrary_SF(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin)
 {
+return erosion_arbitrary_SF_stride(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, sf, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin);
+}
+
+/*!
+ * \fn int erosion_arbitrary_SF_stride(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *sf Buffer containing the shape of a structuring function. 
+ * \param[in] sfWidth Width of the stucturing function buffer
+ * \param[in] sfHeight Height of the stucturing function buffer
+ * \param[in] sfHorizontalOrigin Horizontal position of the origin in the structuring function
+ * \param[in] sfVerticalOrigin Vertical position of the origin in the structuring function
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosion_arbitrary_SF, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ *
+ * Rows of the input and output buffers need not be contiguous, so that
+ * a region of interest of a larger frame can be processed in place.
+ */
+int erosion_arbitrary_SF_stride(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin)
+{
+return erosion_arbitrary_SF_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, sf, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin, NULL);
+}
+
+/*!
+ * \fn int erosion_arbitrary_SF_ctx(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *sf Buffer containing the shape of a structuring function. 
+ * \param[in] sfWidth Width of the stucturing function buffer
+ * \param[in] sfHeight Height of the stucturing function buffer
+ * \param[in] sfHorizontalOrigin Horizontal position of the origin in the structuring function
+ * \param[in] sfVerticalOrigin Vertical position of the origin in the structuring function
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosion_arbitrary_SF_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int erosion_arbitrary_SF_ctx(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, struct morpho_ctx *ctx)
+{
+struct	morpho_se_plan plan;
+struct	front_store store;
+void	*planBuffer;
+size_t	size;
+int	ret;
+
+/* We proceed to the analysis of the structuring function */
+size = se_plan_size(sfWidth, sfHeight, PLAN_EROSION);
+if ( (planBuffer = morpho_scratch(ctx, MORPHO_SLOT_FRONTS, size)) == NULL)
+	{ perror("Malloc"); return MORPHO_ERROR; }
+store.next = (char *)planBuffer;
+store.end = store.next+size;
+if ( MORPHO_SUCCESS != se_plan_init(&plan, sf, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin, imageWidth, 1, PLAN_EROSION, &store) )
+	{
+	perror("ERROR(erosion_arbitrary_SF): analyse_b_gray did not return a valid code");
+	morpho_scratch_release(ctx, planBuffer);
+	return MORPHO_ERROR;
+	}
+
+ret = erosion_arbitrary_SF_plan(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, &plan, ctx);
+
+morpho_scratch_release(ctx, planBuffer);
+return ret;
+}
+
+/*!
+ * \fn int erosion_arbitrary_SF_plan(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image (must be the width the plan was created for)
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  plan Plan of the structuring function, created by \ref morpho_sf_plan_create
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Erosion by a precomputed structuring function
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref erosion_arbitrary_SF_ctx, but the analysis of the structuring 
+ * function is read from the plan instead of being computed at each call.
+ */
+int erosion_arbitrary_SF_plan(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx)
+{
 char st[200];
 
-int16_t	*bloc;
-struct	front *l,*r,*u,*d;
-struct	gfront *gl,*gr,*gu,*gd;
-int	i,j,ret;
-int  	blocWidth, blocHeight;
+int	ret;
+int	sfWidth, sfHeight;
 
 /* Test the compatibility */
+if ( MORPHO_ERROR == is_plan_valid(plan, 1, imageWidth, PLAN_EROSION, "erosion_arbitrary_SF") ) return MORPHO_ERROR;
+sfWidth = plan->seWidth;
+sfHeight = plan->seHeight;
+
+if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "erosion_arbitrary_SF") ) return MORPHO_ERROR;
+
 if (imageWidth <= sfWidth) 
 	{ 
 	snprintf(st, 200, "ERROR(%s): size(=%d) of the structuring function should be larger than the image one(=%d).", "erosion_arbitrary_SF", sfWidth, imageWidth);        
@@ -77,171 +180,182 @@ if (imageHeight <= sfHeight)
         return MORPHO_ERROR;
         }
 
-/* First, we proceed to the analysis of the structuring function 
-   and search for an origin */
-l = (struct front *)malloc(sizeof(struct front));
-r = (struct front *)malloc(sizeof(struct front));
-d = (struct front *)malloc(sizeof(struct front));
-u = (struct front *)malloc(sizeof(struct front));
-gl = (struct gfront *)malloc(sizeof(struct gfront));
-gr = (struct gfront *)malloc(sizeof(struct gfront));
-gd = (struct gfront *)malloc(sizeof(struct gfront));
-gu = (struct gfront *)malloc(sizeof(struct gfront));
-if ( MORPHO_SUCCESS != analyse_b_gray(sf,sfWidth,sfHeight, l,r,u,d, gl,gr,gu,gd,
-			sfHorizontalOrigin, sfVerticalOrigin) 
-   )
-	{
-	perror("ERROR(erosion_arbitrary_SF): analyse_b_gray did not return a valid code");
-	return MORPHO_ERROR;
-	}
-
-/* Allocate a new picture with a border */
-blocWidth = imageWidth+sfWidth*2;
-blocHeight = imageHeight+sfHeight*2;
-bloc = (int16_t *)malloc(blocWidth*blocHeight*sizeof(int16_t));
-for (i=0; i<blocWidth*blocHeight; i++) bloc[i]=LARGEST_VAL;
-for (j=0;j<imageHeight;j++)
-  for (i=0;i<imageWidth;i++)  
-	bloc[i+sfWidth+(j+sfHeight)*blocWidth] = imageIn[i+j*imageWidth];
-
-/* Transforms the information contained in the front structures */
-if ( MORPHO_SUCCESS != transform_b_gray(blocWidth, l,r,u,d, gl,gr,gu,gd) )
-	{
-	perror("ERROR(erosion_arbitrary_SF): transform_b_gray did not return a valid code");
-	return MORPHO_ERROR;
-	}
-
-/* Proceed to the erosion; 
-   ATTENTION: sizeof(im_inter->f...) != sizeof(im_out->f...) */
-ret = erosion_volume_gray(bloc,blocWidth,blocHeight,imageOut,imageWidth,imageHeight,sf,(int)sfWidth,(int)sfHeight,
-		l,r,u,d, gl,gr,gu,gd, sfHorizontalOrigin, sfVerticalOrigin);
+/* Proceed directly on the input image; only the strips of the border 
+   are built by volume_run */
+ret = volume_run(imageIn,inStride, imageOut,imageWidth,imageHeight,outStride, plan, 0, ctx);
 
 if ( MORPHO_SUCCESS != ret)
 	{
-	perror("ERROR(erosion_arbitrary_SF): erosion_volume_gray did not return a valid code");
+	perror("ERROR(erosion_arbitrary_SF): volume_run did not return a valid code");
 	return MORPHO_ERROR;
 	}
 
-/* Free the data */
-free(bloc); 
-free_front(l); free_front(r); free_front(u); free_front(d);
-free(l); free(r); free(u); free(d);
-free_gfront(gl); free_gfront(gr); free_gfront(gu); free_gfront(gd);
-free(gl); free(gr); free(gu); free(gd);
 return MORPHO_SUCCESS;
 }
 
+/*!
+ * \fn int erosion_arbitrary_SF_mt(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int nbrThreads)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *sf Buffer containing the shape of a structuring function. 
+ * \param[in] sfWidth Width of the stucturing function buffer
+ * \param[in] sfHeight Height of the stucturing function buffer
+ * \param[in] sfHorizontalOrigin Horizontal position of the origin in the structuring function
+ * \param[in] sfVerticalOrigin Vertical position of the origin in the structuring function
+ * \param[in]  nbrThreads Number of threads (<= 0 selects \ref morpho_get_num_threads)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Multithreaded erosion by an arbitrary structuring function
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref erosion_arbitrary_SF, but the rows are split into bands that are 
+ * scanned in parallel, each with a histogram of its own. The result is 
+ * identical to that of the single-threaded version.
+ */
+int erosion_arbitrary_SF_mt(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int nbrThreads)
+{
+struct	morpho_ctx *ctx;
+int	ret;
+
+if ( (ctx = morpho_ctx_create(0, 0, 0, 0)) == NULL) return MORPHO_ERROR;
+morpho_ctx_set_num_threads(ctx, nbrThreads);
+ret = erosion_arbitrary_SF_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, sf, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin, ctx);
+morpho_ctx_free(ctx);
+return ret;
+}
+
 /*************************************************************/
 /* Erosion procedure		                             */
 /* ATTENTION: sizeof(in) != sizeof(out) 		     */
 /*************************************************************/
-int erosion_volume_gray( int16_t *bloc, int blocWidth, int blocHeight,
-		int16_t *out, int imageWidth, int imageHeight,
+int erosion_volume_gray( struct volume_src *src,
+		int16_t *out, int imageWidth, int imageHeight, int outStride,
 		uint8_t *sf, int bh, int bv,
 		struct front *l, struct front *r, struct front *u, struct front *d,
 		struct gfront *gl,struct gfront *gr,struct gfront *gu,struct gfront *gd,
-		int ox,int oy)
+		int ox,int oy, int lineFirst, int lineLast, int histogram)
 {
 int16_t	min,*corner,val;
 uint8_t *value,*av,*ap;
-int	i,space[LARGEST_VAL+1-SMALLEST_VAL],*histo,col,*pos,line,lx,n;
+int	i,space[LARGEST_VAL+1-SMALLEST_VAL],col,*pos,line,lx,n;
+int16_t	*data;
+int	*lpos,*rpos,*glpos,*grpos,s,nbrSegments;
+struct	scan_segment seg[3];
+struct	morpho_histogram h;
 
 
 /* Build the first histogram */
-for (i=0;i<=LARGEST_VAL-SMALLEST_VAL;i++)  space[i]=0;
-histo = space-SMALLEST_VAL;
+histo_init(&h, space-SMALLEST_VAL, SMALLEST_VAL, histogram);
+histo_reset(&h, LARGEST_VAL+1-SMALLEST_VAL);
 for (i=0;i<bh*bv;i++)
    if (sf[i] != 0)	
-	histo[LARGEST_VAL-sf[i]+GREY_OFFSET]++;
-min=SMALLEST_VAL; 	while(histo[min] == 0) min++;
+	histo_add(&h, LARGEST_VAL-sf[i]+GREY_OFFSET);
+min=histo_first(&h, SMALLEST_VAL);
 
-/* Each line is scanned through */
-for (line=0;line<imageHeight+bv;line++)
+/* Each line is scanned through. At both ends of a line the window only
+   covers the border, so that the histogram is the same at the beginning 
+   of every line and the scan can start at any line */
+for (line=lineFirst;line<lineLast;line++)
   if (line%2 == 0)
     {
-    lx = line*blocWidth;
+    nbrSegments = scan_segments(src, line, seg);
     /* From left to right */
-    for (col=0;col<imageWidth+bh;col++)
+    for (s=0;s<nbrSegments;s++)
+      {
+      data = (int16_t *)seg[s].region->data; lx = seg[s].lx;
+      lpos = seg[s].region->lpos; rpos = seg[s].region->rpos;
+      glpos = seg[s].region->glpos; grpos = seg[s].region->grpos;
+      for (col=seg[s].first;col<seg[s].last;col++)
 	{
-	corner = &bloc[col+lx];
+	corner = &data[col+lx];
 	/* Updates the histogram */
 	/* 1. Adding "flat" pixels */
- 	   pos=r->pos; value=r->value;
+ 	   pos=rpos; value=r->value;
    	   for (n=0;n<r->size;n++)
 		{
 		val = *(corner+((*pos)+1)) - *value;
-		histo[val]++;
+		histo_add(&h, val);
 		if (val < min) min=val;
 		pos++; value++;
 		}
 	/* 2. Adding and removing "grey" pixels */
 	   /* Adding */
-	   pos=gr->pos; ap=gr->ap;	   
+	   pos=grpos; ap=gr->ap;	   
    	   for (n=0;n<gr->size;n++)
 		{
 		val = *(corner+*(pos)) - *ap;
-		histo[val]++;
+		histo_add(&h, val);
 		if (val < min) min=val;
 		pos++; ap++;
 		}
  	   /* Removing */
-	   pos=gr->pos; av=gr->av;
+	   pos=grpos; av=gr->av;
    	   for (n=0;n<gr->size;n++)
-		{ histo[*(corner+*pos) - *av]--; pos++; av++; }
+		{ histo_remove(&h, *(corner+*pos) - *av); pos++; av++; }
 	/* 3. Removing "flat" pixels */
- 	   pos=l->pos; value=l->value;
+ 	   pos=lpos; value=l->value;
    	   for (n=0;n<l->size;n++)   
-		{ histo[*(corner+*pos) - *value]--; pos++; value++; }
+		{ histo_remove(&h, *(corner+*pos) - *value); pos++; value++; }
 	/* Recomputes the minimum if necessary */
-	while (histo[min] == 0) min++;
+	min = histo_first(&h, min);
 	/* Puts the value in the picture */
 	if ( (col+1+ox>=bh) && (col+1-bh+ox<imageWidth) && 
 	        (line-bv+oy>=0) && (line-bv+oy<imageHeight) )
-			out[col+1-bh+ox+(line-bv+oy)*imageWidth] = min;
+			out[col+1-bh+ox+(line-bv+oy)*outStride] = min;
 	}
+      }
     }
   else 
     {
-    lx = line*blocWidth;
+    nbrSegments = scan_segments(src, line, seg);
     /* From right to left */
-    for (col=imageWidth+bh;col>0;col--)
+    for (s=0;s<nbrSegments;s++)
+      {
+      data = (int16_t *)seg[s].region->data; lx = seg[s].lx;
+      lpos = seg[s].region->lpos; rpos = seg[s].region->rpos;
+      glpos = seg[s].region->glpos; grpos = seg[s].region->grpos;
+      for (col=seg[s].first;col>seg[s].last;col--)
 	{
-	corner = &bloc[col+lx];
+	corner = &data[col+lx];
 	/* Updates the histogram */
 	/* 1. Adding "flat" pixels */
- 	   pos=l->pos; value=l->value;
+ 	   pos=lpos; value=l->value;
    	   for (n=0;n<l->size;n++)
 		{
 		val = *(corner+((*pos)-1)) - *value;
-		histo[val]++;
+		histo_add(&h, val);
 		if (val < min) min=val;
 		pos++; value++;
 		}
 	/* 2. Adding and removing "grey" pixels */
 	   /* Adding */
-	   pos=gl->pos; ap=gl->ap;	   
+	   pos=glpos; ap=gl->ap;	   
    	   for (n=0;n<gl->size;n++)
 		{
 		val = *(corner+(*pos)) - *ap;
-		histo[val]++;
+		histo_add(&h, val);
 		if (val < min) min=val;
 		pos++; ap++;
 		}
  	   /* Removing */
-	   pos=gl->pos; av=gl->av;
+	   pos=glpos; av=gl->av;
    	   for (n=0;n<gl->size;n++)
-		{ histo[*(corner+*pos) - *av]--; pos++; av++; }
+		{ histo_remove(&h, *(corner+*pos) - *av); pos++; av++; }
 	/* 3. Removing "flat" pixels */
- 	   pos=r->pos; value=r->value;
+ 	   pos=rpos; value=r->value;
    	   for (n=0;n<r->size;n++)   
-		{ histo[*(corner+*pos) - *value]--; pos++; value++; }
+		{ histo_remove(&h, *(corner+*pos) - *value); pos++; value++; }
 	/* Recomputes the minimum if necessary */
-	while (histo[min] == 0) min++;
+	min = histo_first(&h, min);
 	/* Put the value in the picture */
 	if ( (col-1+ox>=bh) && (col-1-bh+ox<imageWidth) && 
 	        (line-bv+oy>=0) && (line-bv+oy<imageHeight) )
-			out[col-1-bh+ox+(line-bv+oy)*imageWidth] = min;
+			out[col-1-bh+ox+(line-bv+oy)*outStride] = min;
 	}
+      }
     }
 
 return MORPHO_SUCCESS;
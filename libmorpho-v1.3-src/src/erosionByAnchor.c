@@ -22,7 +22,170 @@
  * \file erosionByAnchor.c
  */ 
 
-#include "libmorpho.h"
+#include "anchorUtil.h"
+
+/* Erosion of a single line of imageWidth pixels. The histogram (256 values)
+ * is provided by the caller so that each thread can own its copy. */
+void erosionByAnchor_line(uint8_t *in, uint8_t *out, int imageWidth, int size, struct morpho_histogram *h)
+{
+  uint8_t *aux;
+  uint8_t *inLeft,*inRight,*outLeft,*outRight,*current,*sentinel; 
+  uint8_t min;
+  int 	*histo;
+  int 	i,nbrBytes;
+  int	middle;
+
+  histo = h->count;
+  nbrBytes = 256*sizeof(int);
+  middle = size/2;
+
+  /* Initialisation of both extremities of a line */
+  inLeft = in;
+  outLeft = out;
+  inRight = inLeft+imageWidth-1;
+  outRight = outLeft+imageWidth-1;
+
+  /* Handles the left border */ 
+  /* First half of the structuring element */
+  memset(histo, 0, nbrBytes);
+  min = *inLeft; histo[min]++;
+  for (i=0; i<middle; i++) 
+    {
+      inLeft++; 
+      histo[*inLeft]++;
+      if (*inLeft < min) { min = *inLeft; }
+    }
+  *outLeft = min;
+
+  /* Second half of the structuring element */
+  for (i=0; i<size-middle-1; i++) 
+    {
+      inLeft++; outLeft++;
+      histo[*inLeft]++;
+      if (*inLeft < min) { min = *inLeft; }
+      *outLeft = min;
+    }
+
+  /* Use the histogram as long as we have not found a new minimum */
+  while ( (inLeft<inRight) && (min<=*(inLeft+1)))
+    {
+      inLeft++; outLeft++;
+      histo[*(inLeft-size)]--;
+      histo[*inLeft]++;
+      while (histo[min]<=0) { min++; }
+      *outLeft = min;
+    }
+
+  /* Enters in the loop */
+  min = *outLeft;
+
+startLine:
+  current = inLeft+1;
+  while ((current<inRight) && (*current<=min))
+    { min=*current; outLeft++; *outLeft=min; current++; }
+  inLeft = current-1;
+  sentinel = inLeft+size;
+  if (sentinel>inRight) { goto finishLine; }
+  outLeft++;
+  *outLeft = min;
+
+  /* We ran "size" pixels ahead */ 
+  current++; 
+  while (current<sentinel)
+    {
+      if (*current<=min) /* We have found a new minimum */
+	{
+	  min = *current;
+	  outLeft++; 
+	  *outLeft = min;
+	  inLeft = current;
+	  goto startLine; 
+	}
+      current++; 
+      outLeft++; 
+      *outLeft = min;
+    }
+
+  /* We did not find a smaller value in the segment in reach
+   * of inLeft; current is the first position outside the 
+   * reach of inLeft 
+   */
+  if (*current<=min)
+    {
+      min = *current;
+      outLeft++; 
+      *outLeft = min;
+      inLeft = current;
+      goto startLine; 
+    }
+  else	/* We can not avoid computing the histogram */
+    {
+      histo_reset(h, 256);
+      inLeft++; outLeft++; 
+      for (aux=inLeft; aux<=current; aux++) { histo_add(h, *aux); }
+      min = histo_first(h, min+1);
+      *outLeft = min;
+    }
+
+  /* We just follow the pixels, update the histogram and look for
+   * the minimum */
+  while (current < inRight)  
+    { 
+      current++; 
+      if (*current <= min)
+	{
+	  /* We have found a new mimum */
+	  min = *current;
+	  outLeft++; 
+	  *outLeft = min;
+	  inLeft = current;
+	  goto startLine; 
+	}
+      else 
+	{
+	  /* Update the histogram */
+	  histo_add(h, *current);
+	  histo_remove(h, *inLeft);
+	  /* Recompute the minimum */
+	  min = histo_first(h, min);
+	  inLeft++; outLeft++; 
+	  *outLeft=min; 
+	}
+    }
+
+finishLine:
+  /* Handles the right border */ 
+  /* First half of the structuring element */
+  memset(histo, 0, nbrBytes);
+  min = *inRight; histo[min]++;
+  for (i=0; i<middle; i++) 
+    {
+      inRight--; 
+      histo[*inRight]++;
+      if (*inRight < min) { min = *inRight; }
+    }
+  *outRight = min;
+
+  /* Second half of the structuring element */
+  for (i=0; (i<size-middle-1) && (outLeft<outRight); i++) 
+    {
+      inRight--; outRight--;
+      histo[*inRight]++;
+      if (*inRight < min) { min = *inRight; }
+      *outRight = min;
+    }
+
+  /* Use the histogram as long as we have not found a new minimum */
+  while ( outLeft<outRight )
+    {
+      inRight--; outRight--;
+      histo[*(inRight+size)]--;
+      histo[*inRight]++;
+      if (*inRight < min) { min = *inRight; }
+      while (histo[min]<=0) { min++; }
+      *outRight = min;
+    }
+}
 
 /*!
  * \fn int erosionByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
@@ -47,184 +210,135 @@ fast algorithms based on anchors</b>. <em>Journal of Mathematical Imaging and Vi
  */
 int erosionByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
 {
-  uint8_t *in,*out,*aux;
-  uint8_t *inLeft,*inRight,*outLeft,*outRight,*current,*sentinel; 
-  uint8_t min;
-  int 	i,j,imageWidthMinus1,sizeMinus1;
-  int 	*histo,nbrBytes;
-  int	middle;
+  return erosionByAnchor_1D_horizontal_stride(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, size);
+}
+
+/*!
+ * \fn int erosionByAnchor_1D_horizontal_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosionByAnchor_1D_horizontal, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ *
+ * Rows of the input and output buffers need not be contiguous, so that
+ * a region of interest of a larger frame can be processed in place.
+ */
+int erosionByAnchor_1D_horizontal_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size)
+{
+  return erosionByAnchor_1D_horizontal_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, size, NULL);
+}
+
+/*!
+ * \fn int erosionByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosionByAnchor_1D_horizontal_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. The algorithm (anchors or van Herk/Gil-Werman)
+ * is selected by \ref morpho_ctx_set_engine.
+ */
+int erosionByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+{
+  int 	j,*histo;
+  struct morpho_histogram h;
 
   /* Tests */
   if ( MORPHO_ERROR == is_size_valid_1D(size, imageWidth, "erosionByAnchor_1D_horizontal", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "erosionByAnchor_1D_horizontal") ) return MORPHO_ERROR;
 
-  in =  (uint8_t *)imageIn;
-  out = (uint8_t *)imageOut;
-  imageWidthMinus1 = imageWidth-1;
-  sizeMinus1 = size-1;
-  middle = size/2;
+  /* Textured images are better handled by the van Herk/Gil-Werman engine */
+  if ( anchor_use_vhgw(imageIn, imageWidth, imageHeight, inStride, size, 0, ctx) )
+    return anchor_vhgw_horizontal(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, size, 0, ctx);
 
   /* Initialisation of the histogram */
-  nbrBytes = 256*sizeof(int);
-  histo = (int *)malloc(nbrBytes);
+  if ((histo=(int *)morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int))) == NULL) {
+    perror("Malloc");
+    return MORPHO_ERROR;
+  }
+  histo_init(&h, histo, 0, morpho_ctx_histogram(ctx));
 
   /* Computation */
   /* Row by row */
   for (j=0; j<imageHeight; j++)
-    {
-      /* Initialisation of both extremities of a line */
-      inLeft = in+(j*imageWidth);
-      outLeft = out+(j*imageWidth);
-      inRight = inLeft+imageWidthMinus1;
-      outRight = outLeft+imageWidthMinus1;
-
-      /* Handles the left border */ 
-      /* First half of the structuring element */
-      memset(histo, 0, nbrBytes);
-      min = *inLeft; histo[min]++;
-      for (i=0; i<middle; i++) 
-   	{
-	  inLeft++; 
-	  histo[*inLeft]++;
-	  if (*inLeft < min) { min = *inLeft; }
-	}
-      *outLeft = min;
-
-      /* Second half of the structuring element */
-      for (i=0; i<size-middle-1; i++) 
-   	{
-	  inLeft++; outLeft++;
-	  histo[*inLeft]++;
-	  if (*inLeft < min) { min = *inLeft; }
-	  *outLeft = min;
-	}
-
-      /* Use the histogram as long as we have not found a new minimum */
-      while ( (inLeft<inRight) && (min<=*(inLeft+1)))
-   	{
-	  inLeft++; outLeft++;
-	  histo[*(inLeft-size)]--;
-	  histo[*inLeft]++;
-	  while (histo[min]<=0) { min++; }
-	  *outLeft = min;
-	}
-
-      /* Enters in the loop */
-      min = *outLeft;
-
-    startLine:
-      current = inLeft+1;
-      while ((current<inRight) && (*current<=min))
-	{ min=*current; outLeft++; *outLeft=min; current++; }
-      inLeft = current-1;
-      sentinel = inLeft+size;
-      if (sentinel>inRight) { goto finishLine; }
-      outLeft++;
-      *outLeft = min;
-		
-      /* We ran "size" pixels ahead */ 
-      current++; 
-      while (current<sentinel)
-	{
-	  if (*current<=min) /* We have found a new minimum */
-	    {
-	      min = *current;
-	      outLeft++; 
-	      *outLeft = min;
-	      inLeft = current;
-	      goto startLine; 
-	    }
-	  current++; 
-	  outLeft++; 
-	  *outLeft = min;
-	}
-
-      /* We did not find a smaller value in the segment in reach
-       * of inLeft; current is the first position outside the 
-       * reach of inLeft 
-       */
-      if (*current<=min)
-	{
-	  min = *current;
-	  outLeft++; 
-	  *outLeft = min;
-	  inLeft = current;
-	  goto startLine; 
-	}
-      else	/* We can not avoid computing the histogram */
-	{
-	  memset(histo, 0, nbrBytes);
-	  inLeft++; outLeft++; 
-	  for (aux=inLeft; aux<=current; aux++) { histo[*aux]++; }
-	  min++; while (histo[min]<=0) { min++; }
-	  *outLeft = min;
-	}
-		
-      /* We just follow the pixels, update the histogram and look for
-       * the minimum */
-      while (current < inRight)  
-	{ 
-	  current++; 
-	  if (*current <= min)
-	    {
-	      /* We have found a new mimum */
-	      min = *current;
-	      outLeft++; 
-	      *outLeft = min;
-	      inLeft = current;
-	      goto startLine; 
-	    }
-	  else 
-	    {
-	      /* Update the histogram */
-	      histo[*current]++;
-	      histo[*inLeft]--;
-	      /* Recompute the minimum */
-	      while (histo[min]<=0) { min++; }
-	      inLeft++; outLeft++; 
-	      *outLeft=min; 
-	    }
-	}
-
-    finishLine:
-      /* Handles the right border */ 
-      /* First half of the structuring element */
-      memset(histo, 0, nbrBytes);
-      min = *inRight; histo[min]++;
-      for (i=0; i<middle; i++) 
-	{
-	  inRight--; 
-	  histo[*inRight]++;
-	  if (*inRight < min) { min = *inRight; }
-	}
-      *outRight = min;
-   
-      /* Second half of the structuring element */
-      for (i=0; (i<size-middle-1) && (outLeft<outRight); i++) 
-	{
-	  inRight--; outRight--;
-	  histo[*inRight]++;
-	  if (*inRight < min) { min = *inRight; }
-	  *outRight = min;
-	}
-
-      /* Use the histogram as long as we have not found a new minimum */
-      while ( outLeft<outRight )
-	{
-	  inRight--; outRight--;
-	  histo[*(inRight+size)]--;
-	  histo[*inRight]++;
-	  if (*inRight < min) { min = *inRight; }
-	  while (histo[min]<=0) { min++; }
-	  *outRight = min;
-	}
-    }
+    erosionByAnchor_line(imageIn+j*inStride, imageOut+j*outStride, imageWidth, size, &h);
 
   /* Free memory */
-  free(histo);
+  morpho_scratch_release(ctx, histo);
   if(DEBUG) printf(" finished.\n");
   return MORPHO_SUCCESS;
 }
 
+/* Processes one band of rows with a histogram of its own */
+static int erosionByAnchor_band(void *arg, int band, int nbrBands)
+{
+  struct anchor_job *job = (struct anchor_job *)arg;
+  int 	histo[256];
+  struct morpho_histogram h;
+  int 	j,first,last;
+
+  histo_init(&h, histo, 0, job->histogram);
+  first = morpho_band_first(job->imageHeight, band, nbrBands);
+  last = morpho_band_first(job->imageHeight, band+1, nbrBands);
+  for (j=first; j<last; j++)
+    erosionByAnchor_line(job->imageIn+j*job->inStride, job->imageOut+j*job->outStride, job->imageWidth, job->size, &h);
+  return MORPHO_SUCCESS;
+}
+
+/*!
+ * \fn int erosionByAnchor_1D_horizontal_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int nbrThreads)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \param[in]  nbrThreads Number of threads (<= 0 selects the default given by \ref morpho_get_num_threads)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ * 
+ * \brief Multithreaded erosion with an horizontal linear segment
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref erosionByAnchor_1D_horizontal, but the rows are split into
+ * bands that are processed in parallel by the worker threads of the library.
+ * The result is identical to that of the single-threaded version.
+ */
+int erosionByAnchor_1D_horizontal_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int nbrThreads)
+{
+  struct anchor_job job;
+
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(size, imageWidth, "erosionByAnchor_1D_horizontal_mt", 1) ) return MORPHO_ERROR;
+
+  job.imageIn = imageIn;
+  job.imageOut = imageOut;
+  job.imageWidth = imageWidth;
+  job.imageHeight = imageHeight;
+  job.inStride = imageWidth;
+  job.outStride = imageWidth;
+  job.size = size;
+  job.histogram = MORPHO_HISTOGRAM_LINEAR;
+
+  return morpho_run_bands(erosionByAnchor_band, &job, morpho_resolve_threads(nbrThreads, imageHeight));
+}
+
 /*!
  * \fn int erosionByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
  * \param[in]  *imageIn Input buffer
@@ -248,185 +362,170 @@ fast algorithms based on anchors</b>. <em>Journal of Mathematical Imaging and Vi
  */
 int erosionByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
 {
-  uint8_t *in,*out,*aux;
-  uint8_t *inUp,*inDown,*outUp,*outDown,*current,*sentinel; 
-  uint8_t min;
-  int 	i,j,imageJump,sizeJump,sizeMinus1;
-  int 	*histo,nbrBytes;
-  int	middle;
+  return erosionByAnchor_1D_vertical_stride(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, size);
+}
+
+/*!
+ * \fn int erosionByAnchor_1D_vertical_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosionByAnchor_1D_vertical, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ *
+ * Rows of the input and output buffers need not be contiguous, so that
+ * a region of interest of a larger frame can be processed in place.
+ */
+int erosionByAnchor_1D_vertical_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size)
+{
+  return erosionByAnchor_1D_vertical_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, size, NULL);
+}
+
+/*!
+ * \fn int erosionByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosionByAnchor_1D_vertical_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. The algorithm (anchors or van Herk/Gil-Werman)
+ * is selected by \ref morpho_ctx_set_engine.
+ */
+int erosionByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+{
+  uint8_t *columnsIn,*columnsOut;
+  int 	c,x,nbrColumns;
+  int 	*histo;
+  struct morpho_histogram h;
 
   /* Tests */
   if ( MORPHO_ERROR == is_size_valid_1D(size, imageHeight, "erosionByAnchor_1D_vertical", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "erosionByAnchor_1D_vertical") ) return MORPHO_ERROR;
 
-  in =  (uint8_t *)imageIn;
-  out = (uint8_t *)imageOut;
-  imageJump = imageWidth*(imageHeight-1);
-  sizeMinus1 = size-1;
-  sizeJump = size*imageWidth;
-  middle = size/2;
+  /* Textured images are better handled by the van Herk/Gil-Werman engine */
+  if ( anchor_use_vhgw(imageIn, imageWidth, imageHeight, inStride, size, 1, ctx) )
+    return anchor_vhgw_vertical(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, size, 0, ctx);
 
-  /* Initialisation of the histogram */
-  nbrBytes = 256*sizeof(int);
-  histo = (int *)malloc(nbrBytes);
+  /* Initialisation of the histogram and of the column buffers */
+  histo = (int *)morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int));
+  columnsIn = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, 2*ANCHOR_COLUMN_BLOCK*imageHeight*sizeof(uint8_t));
+  if ( (histo == NULL) || (columnsIn == NULL) ) {
+    perror("Malloc");
+    morpho_scratch_release(ctx, histo); morpho_scratch_release(ctx, columnsIn);
+    return MORPHO_ERROR;
+  }
+  histo_init(&h, histo, 0, morpho_ctx_histogram(ctx));
+  columnsOut = columnsIn+ANCHOR_COLUMN_BLOCK*imageHeight;
 
   /* Computation */
-  /* Row by row */
-  for (j=0; j<imageWidth; j++)
+  /* Blocks of adjacent columns are copied into contiguous lines, 
+   * processed by the line kernel and written back */
+  for (x=0; x<imageWidth; x+=ANCHOR_COLUMN_BLOCK)
     {
-      /* Initialisation of both extremities of a column */
-      inUp = in+j;
-      outUp = out+j;
-      inDown  = inUp+imageJump;
-      outDown = outUp+imageJump;
-
-      /* Handles the upper border */ 
-      /* First half of the structuring element */
-      memset(histo, 0, nbrBytes);
-      min = *inUp; histo[min]++;
-      for (i=0; i<middle; i++) 
-   	{
-	  inUp+=imageWidth; 
-	  histo[*inUp]++;
-	  if (*inUp < min) { min = *inUp; }
-	}
-      *outUp = min;
-
-      /* Second half of the structuring element */
-      for (i=0; i<size-middle-1; i++) 
-   	{
-	  inUp+=imageWidth; outUp+=imageWidth;
-	  histo[*inUp]++;
-	  if (*inUp < min) { min = *inUp; }
-	  *outUp = min;
-	}
-
-      /* Uses the histogram as long as we have not found a new minimum */
-      while ( (inUp<inDown) && (min<=*(inUp+imageWidth)))
-   	{
-	  inUp+=imageWidth; outUp+=imageWidth;
-	  histo[*(inUp-sizeJump)]--;
-	  histo[*inUp]++;
-	  while (histo[min]<=0) { min++; }
-	  *outUp = min;
-	}
-
-      /* Enters in the loop */
-      min = *outUp;
-
-    startLine:
-      current = inUp+imageWidth;
-      while ((current<inDown) && (*current<=min))
-	{ min=*current; outUp+=imageWidth; *outUp=min; current+=imageWidth; }
-      inUp = current-imageWidth;
-      sentinel = inUp+sizeJump;
-      if (sentinel>inDown) { goto finishLine; }
-      outUp+=imageWidth;
-      *outUp = min;
-		
-      /* We ran "size" pixels ahead */ 
-      current+=imageWidth; 
-      while (current<sentinel)
-	{
-	  if (*current<=min) /* We have found a new minimum */
-	    {
-	      min = *current;
-	      outUp+=imageWidth; 
-	      *outUp = min;
-	      inUp = current;
-	      goto startLine; 
-	    }
-	  current+=imageWidth; 
-	  outUp+=imageWidth; 
-	  *outUp = min;
-	}
-
-      /* We did not find a smaller value in the segment in reach
-       * of inUp; current is the first position outside the 
-       * reach of inUp 
-       */
-      if (*current<=min)
-	{
-	  min = *current;
-	  outUp+=imageWidth; 
-	  *outUp = min;
-	  inUp = current;
-	  goto startLine; 
-	}
-      else	/* We can not avoid computing the histogram */
-	{
-	  memset(histo, 0, nbrBytes);
-	  inUp+=imageWidth; outUp+=imageWidth; 
-	  for (aux=inUp; aux<=current; aux+=imageWidth) { histo[*aux]++; }
-	  min++; while (histo[min]<=0) { min++; }
-	  *outUp = min;
-	}
-		
-      /* We just follow the pixels, update the histogram and look for
-       * the minimum */
-      while (current < inDown)  
-	{ 
-	  current+=imageWidth; 
-	  if (*current <= min)
-	    {
-	      /* We have found a new mimum */
-	      min = *current;
-	      outUp+=imageWidth; 
-	      *outUp = min;
-	      inUp = current;
-	      goto startLine; 
-	    }
-	  else 
-	    {
-	      /* Update the histogram */
-	      histo[*current]++;
-	      histo[*inUp]--;
-	      /* Recompute the minimum */
-	      while (histo[min]<=0) { min++; }
-	      inUp+=imageWidth; outUp+=imageWidth; 
-	      *outUp=min; 
-	    }
-	}
-
-    finishLine:
-      /* Handles the bottom border */ 
-      /* First half of the structuring element */
-      memset(histo, 0, nbrBytes);
-      min = *inDown; histo[min]++;
-      for (i=0; i<middle; i++) 
-	{
-	  inDown-=imageWidth; 
-	  histo[*inDown]++;
-	  if (*inDown < min) { min = *inDown; }
-	}
-      *outDown = min;
-   
-      /* Second half of the structuring element */
-      for (i=0; (i<size-middle-1) && (outUp<outDown); i++) 
-	{
-	  inDown-=imageWidth; outDown-=imageWidth;
-	  histo[*inDown]++;
-	  if (*inDown < min) { min = *inDown; }
-	  *outDown = min;
-	}
-
-      /* Use the histogram as long as we have not found a new minimum */
-      while ( outUp<outDown )
-	{
-	  inDown-=imageWidth; outDown-=imageWidth;
-	  histo[*(inDown+sizeJump)]--;
-	  histo[*inDown]++;
-	  if (*inDown < min) { min = *inDown; }
-	  while (histo[min]<=0) { min++; }
-	  *outDown = min;
-	}
+      nbrColumns = imageWidth-x;
+      if (nbrColumns > ANCHOR_COLUMN_BLOCK) { nbrColumns = ANCHOR_COLUMN_BLOCK; }
+      anchor_gather_columns(imageIn+x, inStride, imageHeight, nbrColumns, columnsIn);
+      for (c=0; c<nbrColumns; c++)
+	erosionByAnchor_line(columnsIn+c*imageHeight, columnsOut+c*imageHeight, imageHeight, size, &h);
+      anchor_scatter_columns(columnsOut, outStride, imageHeight, nbrColumns, imageOut+x);
     }
 
   /* Free memory */
-  free(histo);
+  morpho_scratch_release(ctx, columnsIn);
+  morpho_scratch_release(ctx, histo);
   if(DEBUG) printf(" finished.\n");
   return MORPHO_SUCCESS;
 }
 
+/*!
+ * \fn int erosionByAnchor_1D_oriented(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, double angle)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  size (= length in tems of pixels) of the linear structuring element (odd)
+ * \param[in]  angle Orientation of the segment, in degrees counterclockwise from the horizontal axis
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Erosion with a linear segment of any orientation
+ *
+ * \ingroup libmorpho
+ *
+ * The image is scanned along the translations of the discrete (Bresenham)
+ * line of the given angle, which cover each pixel once, and each profile
+ * is processed by the anchor algorithm of \ref erosionByAnchor_1D_horizontal.
+ * The segment holds size pixels of the line, counted along its axis of
+ * largest extent, and the cost per pixel does not depend on its length.
+ * Angles of 0 and 90 degrees give the horizontal and vertical operators.
+ */
+int erosionByAnchor_1D_oriented(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, double angle)
+{
+  return erosionByAnchor_1D_oriented_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, size, angle, NULL);
+}
+
+/*!
+ * \fn int erosionByAnchor_1D_oriented_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, double angle, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= length in tems of pixels) of the linear structuring element (odd)
+ * \param[in]  angle Orientation of the segment, in degrees counterclockwise from the horizontal axis
+ * \param[in]  ctx Context providing the scratch memory and the number of threads (NULL for one thread)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosionByAnchor_1D_oriented, for buffers with padded rows and with the settings of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. The profiles are split into as many bands
+ * as threads (see \ref morpho_ctx_set_num_threads). imageIn and imageOut
+ * may be the same buffer, with the same stride.
+ *
+ * Profiles shorter than the segment, in the corners of the image, are
+ * processed directly.
+ */
+int erosionByAnchor_1D_oriented_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, double angle, struct morpho_ctx *ctx)
+{
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(size, (imageWidth > imageHeight) ? imageWidth : imageHeight, "erosionByAnchor_1D_oriented", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "erosionByAnchor_1D_oriented") ) return MORPHO_ERROR;
+
+  /* The rows and the columns have faster operators, which do not all
+     work in place and which need a segment shorter than the row or the
+     column */
+  if (imageIn != imageOut)
+    switch (anchor_oriented_axis(angle, imageWidth, imageHeight))
+      {
+      case ANCHOR_LINE_HORIZONTAL:
+	if (size < imageWidth) { return erosionByAnchor_1D_horizontal_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, size, ctx); }
+	break;
+      case ANCHOR_LINE_VERTICAL:
+	if (size < imageHeight) { return erosionByAnchor_1D_vertical_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, size, ctx); }
+	break;
+      }
+
+  return anchor_oriented(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, size, angle, erosionByAnchor_line, NULL, 0, ctx);
+}
+
 /*!
  * \fn int erosionByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight)
  * \param[in]  *imageIn Input buffer
@@ -451,22 +550,124 @@ fast algorithms based on anchors</b>. <em>Journal of Mathematical Imaging and Vi
  * \author      Marc Van Droogenbroeck
  */
 int erosionByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight)
+{
+  return erosionByAnchor_2D_stride(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, seWidth, seHeight);
+}
+
+/*!
+ * \fn int erosionByAnchor_2D_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosionByAnchor_2D, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ *
+ * Rows of the input and output buffers need not be contiguous, so that
+ * a region of interest of a larger frame can be processed in place.
+ */
+int erosionByAnchor_2D_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight)
+{
+  return erosionByAnchor_2D_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, seWidth, seHeight, NULL);
+}
+
+/*!
+ * \fn int erosionByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosionByAnchor_2D_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int erosionByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
 {
   uint8_t	*bloc=NULL;
   int err1, err2;
 
-  if ((bloc=(uint8_t*)malloc(imageWidth*imageHeight*sizeof(uint8_t))) == NULL) {
+  if ((bloc=(uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, imageWidth*imageHeight*sizeof(uint8_t))) == NULL) {
     perror("Malloc");
     return MORPHO_ERROR;
   }
   
-  err1 = erosionByAnchor_1D_horizontal(imageIn, bloc, imageWidth, imageHeight, seWidth);
-  err2 = erosionByAnchor_1D_vertical(bloc, imageOut, imageWidth, imageHeight, seHeight);
+  err1 = erosionByAnchor_1D_horizontal_ctx(imageIn, bloc, imageWidth, imageHeight, inStride, imageWidth, seWidth, ctx);
+  err2 = erosionByAnchor_1D_vertical_ctx(bloc, imageOut, imageWidth, imageHeight, imageWidth, outStride, seHeight, ctx);
 
-  free(bloc);
+  morpho_scratch_release(ctx, bloc);
 
   if ( (MORPHO_SUCCESS == err1) && (MORPHO_SUCCESS == err2) ) 
 	return MORPHO_SUCCESS;
   else 	return MORPHO_ERROR;
 }
 
+/*!
+ * \fn int erosionByAnchor_2D_fused(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be equal to imageIn)
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Erosion with a seWidth * seHeight rectangle, streamed row by row
+ * 
+ * \ingroup libmorpho
+ *
+ * Gives the same result as \ref erosionByAnchor_2D, but the horizontal and
+ * vertical passes are fused: each row is processed horizontally and kept 
+ * in a ring buffer of about 2*seHeight rows, from which the vertical pass 
+ * produces output rows as soon as enough rows are available. No intermediate
+ * image of the size of the input is allocated, and the operation can be 
+ * performed in place.
+ */
+int erosionByAnchor_2D_fused(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight)
+{
+  return erosionByAnchor_2D_fused_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, seWidth, seHeight, NULL);
+}
+
+/*!
+ * \fn int erosionByAnchor_2D_fused_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be equal to imageIn, with the same stride)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosionByAnchor_2D_fused, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int erosionByAnchor_2D_fused_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
+{
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(seWidth, imageWidth, "erosionByAnchor_2D_fused", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(seHeight, imageHeight, "erosionByAnchor_2D_fused", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "erosionByAnchor_2D_fused") ) return MORPHO_ERROR;
+
+  return anchor_fused_2D(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, seWidth, seHeight, erosionByAnchor_line, 0, ctx);
+}
@@ -0,0 +1,300 @@
+/* LIBMORPHO
+ *
+ * gradientArbitrarySE.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file gradientArbitrarySE.c
+ */ 
+
+#include "arbitraryUtil.h"
+#include "dispatch.h"
+
+/*!
+ * \fn int gradient_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int type)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element (position 0 is the first pixel on the left). se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element (position 0 is the first pixel on the top). se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \param[in]  type \ref MORPHO_GRADIENT_BEUCHER, \ref MORPHO_GRADIENT_INTERNAL or \ref MORPHO_GRADIENT_EXTERNAL
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Morphological gradient by an arbitrary structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Beucher gradient (\ref dilation_arbitrary_SE minus \ref erosion_arbitrary_SE),
+ * internal gradient (the image minus its erosion) or external gradient (the
+ * dilation minus the image), computed in a single pass over the image: the
+ * histograms of the erosion and of the dilation are updated line after 
+ * line on the same input rows, and each output row is written once, without
+ * any intermediate image.
+ */
+int gradient_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int type)
+{
+return gradient_arbitrary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, type, NULL);
+}
+
+/*!
+ * \fn int gradient_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int type, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \param[in]  type \ref MORPHO_GRADIENT_BEUCHER, \ref MORPHO_GRADIENT_INTERNAL or \ref MORPHO_GRADIENT_EXTERNAL
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref gradient_arbitrary_SE, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int gradient_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int type, struct morpho_ctx *ctx)
+{
+struct	morpho_se_plan plan;
+struct	front_store store;
+void	*planBuffer;
+size_t	size;
+int	ret;
+
+/* Analysis of the structuring element, in the scratch memory */
+size = se_plan_size(seWidth, seHeight, PLAN_EROSION|PLAN_DILATION);
+if ( (planBuffer = morpho_scratch(ctx, MORPHO_SLOT_FRONTS, size)) == NULL)
+	{ perror("Malloc"); return MORPHO_ERROR; }
+store.next = (char *)planBuffer;
+store.end = store.next+size;
+if ( MORPHO_SUCCESS != se_plan_init(&plan, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, imageWidth, 0, PLAN_EROSION|PLAN_DILATION, &store) )
+	{
+	perror("ERROR(gradient_arbitrary_SE): analyse_b did not return a valid code");
+	morpho_scratch_release(ctx, planBuffer);
+	return MORPHO_ERROR;
+	}
+
+ret = gradient_arbitrary_SE_plan(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, &plan, type, ctx);
+
+morpho_scratch_release(ctx, planBuffer);
+return ret;
+}
+
+/*!
+ * \fn int gradient_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int type, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image (must be the width the plan was created for)
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  plan Plan of the structuring element, created by \ref morpho_se_plan_create
+ * \param[in]  type \ref MORPHO_GRADIENT_BEUCHER, \ref MORPHO_GRADIENT_INTERNAL or \ref MORPHO_GRADIENT_EXTERNAL
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Morphological gradient by a precomputed structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref gradient_arbitrary_SE_ctx, but the analysis of the structuring 
+ * element is read from the plan instead of being computed at each call.
+ */
+int gradient_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int type, struct morpho_ctx *ctx)
+{
+char st[200];
+
+int	ret,j,which;
+uint8_t	lo,hi,*bloc,*in,*out,*b;
+struct	binary_pass pass;
+
+/* Test the compatibility */
+if ( (type < MORPHO_GRADIENT_BEUCHER) || (type > MORPHO_GRADIENT_EXTERNAL) )
+	{
+	snprintf(st, 200, "ERROR(%s): unknown type of gradient (=%d).", "gradient_arbitrary_SE", type);
+	perror(st);
+	return MORPHO_ERROR;
+	}
+which = (type == MORPHO_GRADIENT_INTERNAL) ? PLAN_EROSION : (type == MORPHO_GRADIENT_EXTERNAL) ? PLAN_DILATION : PLAN_EROSION|PLAN_DILATION;
+if ( MORPHO_ERROR == is_plan_valid(plan, 0, imageWidth, which, "gradient_arbitrary_SE") ) return MORPHO_ERROR;
+
+if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "gradient_arbitrary_SE") ) return MORPHO_ERROR;
+
+if (imageWidth <= plan->seWidth) 
+	{ 
+	snprintf(st, 200, "ERROR(%s): size(=%d) of the structuring elements should be larger than the image one(=%d).", "gradient_arbitrary_SE", plan->seWidth, imageWidth);        
+	perror(st);
+        return MORPHO_ERROR;
+        }
+
+if (imageHeight <= plan->seHeight) 
+	{ 
+	snprintf(st, 200, "ERROR(%s): size(=%d) of the structuring elements should be larger than the image one(=%d).", "gradient_arbitrary_SE", plan->seHeight, imageHeight);        
+	perror(st);
+        return MORPHO_ERROR;
+        }
+
+/* A two-valued image (a mask) is processed with one bit per pixel: the 
+   erosion (or the dilation for the external gradient) goes to a 
+   temporary image, the dilation to the output */
+if ( binary_values(imageIn, imageWidth, imageHeight, inStride, &lo, &hi) )
+	{
+	if ( (bloc = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, imageWidth*imageHeight*sizeof(uint8_t))) == NULL)
+		{
+		perror("Malloc");
+		return MORPHO_ERROR;
+		}
+	pass.dilation = (type == MORPHO_GRADIENT_EXTERNAL);
+	pass.se = (pass.dilation) ? plan->dilation.se : plan->erosion.se;
+	pass.ox = (pass.dilation) ? plan->dilation.ox : plan->erosion.ox;
+	pass.oy = (pass.dilation) ? plan->dilation.oy : plan->erosion.oy;
+	ret = binary_SE_passes(imageIn, bloc, imageWidth, imageHeight, inStride, imageWidth, lo, hi, plan->seWidth, plan->seHeight, &pass, 1, ctx);
+	if ( (MORPHO_SUCCESS == ret) && (type == MORPHO_GRADIENT_BEUCHER) )
+		{
+		pass.se = plan->dilation.se;
+		pass.ox = plan->dilation.ox;
+		pass.oy = plan->dilation.oy;
+		pass.dilation = 1;
+		ret = binary_SE_passes(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, lo, hi, plan->seWidth, plan->seHeight, &pass, 1, ctx);
+		}
+	for (j=0; (MORPHO_SUCCESS == ret) && (j<imageHeight); j++)
+		{
+		in = imageIn+j*inStride;
+		out = imageOut+j*outStride;
+		b = bloc+j*imageWidth;
+		switch (type)
+			{
+			case MORPHO_GRADIENT_INTERNAL: morpho_isa->rows_sub(in, b, out, imageWidth); break;
+			case MORPHO_GRADIENT_EXTERNAL: morpho_isa->rows_sub(b, in, out, imageWidth); break;
+			default: morpho_isa->rows_sub(out, b, out, imageWidth);
+			}
+		}
+	morpho_scratch_release(ctx, bloc);
+	return ret;
+	}
+
+/* Both volumes read the input image in place */
+ret = gradient_run(imageIn,inStride, imageOut,imageWidth,imageHeight,outStride, plan, type, ctx);
+
+if ( MORPHO_SUCCESS != ret)
+	{
+	perror("ERROR(gradient_arbitrary_SE): gradient_run did not return a valid code");
+	return MORPHO_ERROR;
+	}
+
+return MORPHO_SUCCESS;
+}
+
+/*************************************************************/
+/* Beucher gradient by a structuring element that is symmetric */
+/* with respect to its origin: the windows of the erosion and  */
+/* of the dilation are the same, and a single histogram gives  */
+/* both extrema. The border of src is LARGEST_UINT8, so that   */
+/* the maximum is corrected where the window crosses it: sat   */
+/* is the summed area table of se, (bh+1)*(bv+1) values, that  */
+/* gives the number of points of the window inside the image.  */
+/* ATTENTION: sizeof(in) != sizeof(out) 		       */
+/*************************************************************/
+int gradient_volume(	struct volume_src *src,
+		uint8_t *out, int imageWidth, int imageHeight, int outStride,
+		uint8_t *se, int bh, int bv, int *sat,
+		struct front *l, struct front *r, 
+		int ox,int oy, int lineFirst, int lineLast, int histogram)
+{
+uint8_t	min,max,top,*corner,val;
+int	i,space[256],col,*pos,line,lx,n,x,y;
+int	i0,i1,j0,j1,outside;
+uint8_t	*data;
+int	*lpos,*rpos,s,nbrSegments,dir,nbrIn,nbrOut;
+struct	scan_segment seg[3];
+struct	morpho_histogram h;
+
+
+/* Build the first histogram */
+histo_init(&h, space, 0, histogram);
+histo_reset(&h, 256);
+for (i=0;i<bh*bv;i++)
+   if (se[i] != 0)	
+	histo_add(&h, LARGEST_UINT8);
+min=LARGEST_UINT8;
+max=LARGEST_UINT8;
+
+/* Same scan as erosion_volume, with both extrema */
+for (line=lineFirst;line<lineLast;line++)
+  {
+  dir = (line%2 == 0) ? 1 : -1;
+  nbrSegments = scan_segments(src, line, seg);
+  for (s=0;s<nbrSegments;s++)
+    {
+    data = (uint8_t *)seg[s].region->data; lx = seg[s].lx;
+    /* The entering front is r from left to right, l from right to left */
+    lpos = (dir > 0) ? seg[s].region->lpos : seg[s].region->rpos; 
+    rpos = (dir > 0) ? seg[s].region->rpos : seg[s].region->lpos;
+    nbrOut = (dir > 0) ? l->size : r->size;
+    nbrIn = (dir > 0) ? r->size : l->size;
+    for (col=seg[s].first;col!=seg[s].last;col+=dir)
+	{
+	corner = &data[col+lx];
+	/* Updates the histogram */
+	/* 1. Adding "flat" pixels */
+ 	   pos=rpos; 
+   	   for (n=0;n<nbrIn;n++)
+		{
+		val = *(corner+((*pos)+dir));
+		histo_add(&h, val);
+		if (val < min) min=val;
+		if (val > max) max=val;
+		pos++; 
+		}
+	/* 3. Removing "flat" pixels */
+ 	   pos=lpos; 
+   	   for (n=0;n<nbrOut;n++)   
+		{ histo_remove(&h, *(corner+*pos)); pos++; }
+	/* Recomputes the extrema if necessary */
+	min = histo_first(&h, min);
+	max = histo_last(&h, max);
+	/* Puts the value in the picture */
+	x = col+dir-bh+ox;
+	y = line-bv+oy;
+	if ( (x>=0) && (x<imageWidth) && (y>=0) && (y<imageHeight) )
+		{
+		top = max;
+		/* Points of the window outside the image hold LARGEST_UINT8 */
+		i0 = (ox-x > 0) ? ox-x : 0; i1 = (ox-x+imageWidth < bh) ? ox-x+imageWidth : bh;
+		j0 = (oy-y > 0) ? oy-y : 0; j1 = (oy-y+imageHeight < bv) ? oy-y+imageHeight : bv;
+		outside = sat[bh+bv*(bh+1)]-(sat[i1+j1*(bh+1)]-sat[i0+j1*(bh+1)]-sat[i1+j0*(bh+1)]+sat[i0+j0*(bh+1)]);
+		if ( (outside > 0) && (space[LARGEST_UINT8] <= outside) )
+			top = histo_last(&h, LARGEST_UINT8-1);
+		out[x+y*outStride] = top-min;
+		}
+	}
+    }
+  }
+
+return MORPHO_SUCCESS;
+}
@@ -0,0 +1,500 @@
+/* LIBMORPHO
+ *
+ * gradientByAnchor.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file gradientByAnchor.c
+ */ 
+
+#include "anchorUtil.h"
+#include "dispatch.h"
+
+/* Erosion and dilation of a single line of imageWidth pixels by a segment
+ * of size pixels, in one traversal. ero and dil receive the erosion and 
+ * the dilation, grad their difference; each of them may be NULL.
+ *
+ * Both extrema are followed by anchors: the position of the minimum 
+ * (maximum) is known as long as it is the last pixel of the window that 
+ * has this value. When an anchor leaves the window, the histogram of the
+ * window is built and both extrema are read from it, until new anchors 
+ * enter the window for both of them. The histogram (256 values) is 
+ * provided by the caller. */
+static void gradientByAnchor_line(uint8_t *in, uint8_t *ero, uint8_t *dil, uint8_t *grad, int imageWidth, int size, struct morpho_histogram *h)
+{
+  uint8_t v,min,max;
+  int 	x,i,half,enter,leave,first,last;
+  int 	anchorMin,anchorMax,useHisto;
+
+  half = size/2;
+
+  /* Window of the first pixel */
+  min = 255; max = 0; 
+  anchorMin = anchorMax = 0;
+  for (i=0; (i<=half) && (i<imageWidth); i++)
+    {
+      v = in[i];
+      if (v <= min) { min = v; anchorMin = i; }
+      if (v >= max) { max = v; anchorMax = i; }
+    }
+  useHisto = 0;
+
+  for (x=0; x<imageWidth; x++)
+    {
+      if (x > 0)
+	{
+	  enter = x+half;
+	  leave = x-half-1;
+	  if (useHisto)
+	    {
+	      if (leave >= 0) { histo_remove(h, in[leave]); }
+	      if (enter < imageWidth) { histo_add(h, in[enter]); }
+	    }
+
+	  /* The entering pixel becomes an anchor */
+	  if (enter < imageWidth)
+	    {
+	      v = in[enter];
+	      if (v <= min) { min = v; anchorMin = enter; }
+	      if (v >= max) { max = v; anchorMax = enter; }
+	    }
+
+	  /* An anchor leaves the window: no other pixel of the window has 
+	   * its value, the histogram is needed */
+	  if ( ((anchorMin >= 0) && (anchorMin <= leave)) || ((anchorMax >= 0) && (anchorMax <= leave)) )
+	    {
+	      if (!useHisto)
+		{
+		  histo_reset(h, 256);
+		  first = (leave+1 > 0) ? leave+1 : 0;
+		  last = (enter < imageWidth) ? enter : imageWidth-1;
+		  for (i=first; i<=last; i++) { histo_add(h, in[i]); }
+		  useHisto = 1;
+		}
+	      if (anchorMin <= leave) { anchorMin = -1; }
+	      if (anchorMax <= leave) { anchorMax = -1; }
+	    }
+
+	  if (useHisto)
+	    {
+	      if (anchorMin < 0) { min = histo_first(h, min); }
+	      if (anchorMax < 0) { max = histo_last(h, max); }
+	      if ( (anchorMin >= 0) && (anchorMax >= 0) ) { useHisto = 0; }
+	    }
+	}
+
+      if (ero) { ero[x] = min; }
+      if (dil) { dil[x] = max; }
+      if (grad) { grad[x] = max-min; }
+    }
+}
+
+/* Prefix and suffix minima and maxima of line[0..length-1], by blocks of 
+ * size values starting at 0, in a single traversal (see blocks_min in 
+ * anchorUtil.c) */
+static void blocks_minmax(uint8_t *line, uint8_t *prefixMin, uint8_t *suffixMin, uint8_t *prefixMax, uint8_t *suffixMax, int length, int size)
+{
+  uint8_t v,min,max;
+  int b,e,p;
+
+  for (b=0; b<length; b+=size)
+    {
+      e = (b+size < length) ? b+size : length;
+      min = max = line[b];
+      for (p=b; p<e; p++)
+	{
+	  v = line[p];
+	  min = (v < min) ? v : min;
+	  max = (v > max) ? v : max;
+	  prefixMin[p] = min;
+	  prefixMax[p] = max;
+	}
+      min = max = line[e-1];
+      for (p=e-1; p>=b; p--)
+	{
+	  v = line[p];
+	  min = (v < min) ? v : min;
+	  max = (v > max) ? v : max;
+	  suffixMin[p] = min;
+	  suffixMax[p] = max;
+	}
+    }
+}
+
+/* Length of the work buffer of gradientByVHGW_line */
+#define	VHGW_WORK_SIZE(imageWidth,size)	((size_t)5*((imageWidth)+2*((size)/2)))
+
+/* Same as gradientByAnchor_line, with the van Herk/Gil-Werman algorithm.
+ *
+ * The line is padded with size/2 copies of its first and last pixels: as
+ * the windows are clipped to the line, they always contain the pixel that
+ * is copied, so that the same padded line serves both extrema. work 
+ * provides VHGW_WORK_SIZE values. */
+static void gradientByVHGW_line(uint8_t *in, uint8_t *ero, uint8_t *dil, uint8_t *grad, int imageWidth, int size, uint8_t *work)
+{
+  uint8_t *line,*prefixMin,*suffixMin,*prefixMax,*suffixMax;
+  int 	half,length;
+
+  half = size/2;
+  length = imageWidth+2*half;
+  line = work;
+  prefixMin = line+length; suffixMin = prefixMin+length;
+  prefixMax = suffixMin+length; suffixMax = prefixMax+length;
+
+  memset(line, in[0], half);
+  memcpy(line+half, in, imageWidth);
+  memset(line+half+imageWidth, in[imageWidth-1], half);
+  blocks_minmax(line, prefixMin, suffixMin, prefixMax, suffixMax, length, size);
+
+  /* Output pixel x covers the values x to x+size-1 of the padded line */
+  if (ero == NULL) { ero = suffixMin; }
+  if (dil == NULL) { dil = suffixMax; }
+  morpho_isa->rows_min(suffixMin, prefixMin+2*half, ero, imageWidth);
+  morpho_isa->rows_max(suffixMax, prefixMax+2*half, dil, imageWidth);
+  if (grad) { morpho_isa->rows_sub(dil, ero, grad, imageWidth); }
+}
+
+/* Erosion, dilation and gradient by a seWidth x seHeight rectangle in a 
+ * single sweep over the rows. Each input row goes through one of the dual 
+ * line kernels (or is copied when seWidth is 1), chosen as for the 
+ * erosions by anchor_use_vhgw, and its minima and maxima are pushed into 
+ * two anchor_rings for the vertical pass. Any of 
+ * the outputs may be NULL, and may be equal to imageIn (with the same 
+ * stride), as output row y is written once input row y+seHeight/2 has 
+ * been read. */
+static int gradientByAnchor_rows(uint8_t *imageIn, uint8_t *imageErosion, uint8_t *imageDilation, uint8_t *imageGradient, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
+{
+  uint8_t *buffer,*rowMin,*rowMax,*outMin,*outMax,*in,*work;
+  struct anchor_ring ringMin,ringMax;
+  int 	*histo;
+  struct morpho_histogram h;
+  int 	u,y,t,half,nbrRows,useVhgw;
+  size_t ringSize,workSize;
+
+  useVhgw = (seWidth > 1) && anchor_use_vhgw(imageIn, imageWidth, imageHeight, inStride, seWidth, 0, ctx);
+  ringSize = ANCHOR_RING_SIZE(imageWidth, seHeight);
+  workSize = (useVhgw) ? VHGW_WORK_SIZE(imageWidth, seWidth) : 0;
+  histo = (int *)morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int));
+  buffer = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, (2*ringSize+2*imageWidth+workSize)*sizeof(uint8_t));
+  if ( (histo == NULL) || (buffer == NULL) ) {
+    perror("Malloc");
+    morpho_scratch_release(ctx, histo); morpho_scratch_release(ctx, buffer);
+    return MORPHO_ERROR;
+  }
+  histo_init(&h, histo, 0, morpho_ctx_histogram(ctx));
+  anchor_ring_init(&ringMin, buffer, imageWidth, seHeight, 0);
+  anchor_ring_init(&ringMax, buffer+ringSize, imageWidth, seHeight, 1);
+  outMin = buffer+2*ringSize;
+  outMax = outMin+imageWidth;
+  work = outMax+imageWidth;
+
+  half = seHeight/2;
+  nbrRows = imageHeight+seHeight-1;
+
+  /* Virtual row u holds the horizontal pass of image row u-half */
+  for (u=0; u<nbrRows; u++)
+    {
+      rowMin = anchor_ring_row(&ringMin, u);
+      rowMax = anchor_ring_row(&ringMax, u);
+      t = u-half;
+      if ( (t>=0) && (t<imageHeight) )
+	{
+	  in = imageIn+t*inStride;
+	  if (useVhgw)
+	    gradientByVHGW_line(in, rowMin, rowMax, NULL, imageWidth, seWidth, work);
+	  else if (seWidth > 1)
+	    gradientByAnchor_line(in, rowMin, rowMax, NULL, imageWidth, seWidth, &h);
+	  else
+	    { memcpy(rowMin, in, imageWidth); memcpy(rowMax, in, imageWidth); }
+	}
+      else
+	{ memset(rowMin, 255, imageWidth); memset(rowMax, 0, imageWidth); }
+
+      /* Output row y covers the virtual rows y to u */
+      y = u-seHeight+1;
+      if (y < 0)
+	{
+	  anchor_ring_push(&ringMin, u, outMin);
+	  anchor_ring_push(&ringMax, u, outMax);
+	  continue;
+	}
+      if (imageErosion) { outMin = imageErosion+y*outStride; }
+      if (imageDilation) { outMax = imageDilation+y*outStride; }
+      anchor_ring_push(&ringMin, u, outMin);
+      anchor_ring_push(&ringMax, u, outMax);
+      if (imageGradient) { morpho_isa->rows_sub(outMax, outMin, imageGradient+y*outStride, imageWidth); }
+    }
+
+  morpho_scratch_release(ctx, buffer);
+  morpho_scratch_release(ctx, histo);
+  return MORPHO_SUCCESS;
+}
+
+/*!
+ * \fn int gradientByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ * 
+ * \brief Morphological gradient with an horizontal linear segment
+ * 
+ * \ingroup libmorpho
+ *
+ * Difference between the dilation and the erosion with an horizontal linear
+ * segment whose size is given in pixels. Both are computed in a single 
+ * traversal of each row, with the engine of the context (see 
+ * \ref morpho_ctx_set_engine): the van Herk/Gil-Werman engine computes the
+ * prefix and suffix minima and maxima together, and the anchor engine 
+ * follows the minimum and the maximum by anchors, with a histogram shared
+ * by both that is only built when an anchor leaves the segment.
+ */
+int gradientByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
+{
+  return gradientByAnchor_1D_horizontal_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, size, NULL);
+}
+
+/*!
+ * \fn int gradientByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be equal to imageIn, with the same stride)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref gradientByAnchor_1D_horizontal, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int gradientByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+{
+  uint8_t *line;
+  int 	j,*histo;
+  struct morpho_histogram h;
+
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(size, imageWidth, "gradientByAnchor_1D_horizontal", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "gradientByAnchor_1D_horizontal") ) return MORPHO_ERROR;
+
+  /* van Herk/Gil-Werman: the kernel copies each row before writing it */
+  if ( anchor_use_vhgw(imageIn, imageWidth, imageHeight, inStride, size, 0, ctx) )
+    {
+      if ((line=(uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, VHGW_WORK_SIZE(imageWidth, size)*sizeof(uint8_t))) == NULL) {
+	perror("Malloc");
+	return MORPHO_ERROR;
+      }
+      for (j=0; j<imageHeight; j++)
+	gradientByVHGW_line(imageIn+j*inStride, NULL, NULL, imageOut+j*outStride, imageWidth, size, line);
+      morpho_scratch_release(ctx, line);
+      return MORPHO_SUCCESS;
+    }
+
+  /* Initialisation of the histogram and of a copy of the row, for in 
+   * place calls */
+  histo = (int *)morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int));
+  line = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, imageWidth*sizeof(uint8_t));
+  if ( (histo == NULL) || (line == NULL) ) {
+    perror("Malloc");
+    morpho_scratch_release(ctx, histo); morpho_scratch_release(ctx, line);
+    return MORPHO_ERROR;
+  }
+  histo_init(&h, histo, 0, morpho_ctx_histogram(ctx));
+
+  /* Computation */
+  /* Row by row */
+  for (j=0; j<imageHeight; j++)
+    {
+      if (imageIn == imageOut)
+	{
+	  memcpy(line, imageIn+j*inStride, imageWidth);
+	  gradientByAnchor_line(line, NULL, NULL, imageOut+j*outStride, imageWidth, size, &h);
+	}
+      else
+	gradientByAnchor_line(imageIn+j*inStride, NULL, NULL, imageOut+j*outStride, imageWidth, size, &h);
+    }
+
+  /* Free memory */
+  morpho_scratch_release(ctx, line);
+  morpho_scratch_release(ctx, histo);
+  if(DEBUG) printf(" finished.\n");
+  return MORPHO_SUCCESS;
+}
+
+/*!
+ * \fn int gradientByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ * 
+ * \brief Morphological gradient with a vertical linear segment
+ * 
+ * \ingroup libmorpho
+ *
+ * Difference between the dilation and the erosion with a vertical linear
+ * segment whose size is given in pixels, computed in a single sweep over
+ * the rows of the image.
+ */
+int gradientByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
+{
+  return gradientByAnchor_1D_vertical_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, size, NULL);
+}
+
+/*!
+ * \fn int gradientByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be equal to imageIn, with the same stride)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref gradientByAnchor_1D_vertical, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int gradientByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+{
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(size, imageHeight, "gradientByAnchor_1D_vertical", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "gradientByAnchor_1D_vertical") ) return MORPHO_ERROR;
+
+  return gradientByAnchor_rows(imageIn, NULL, NULL, imageOut, imageWidth, imageHeight, inStride, outStride, 1, size, ctx);
+}
+
+/*!
+ * \fn int gradientByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Morphological gradient with a seWidth * seHeight rectangle structuring element
+ * 
+ * \ingroup libmorpho
+ *
+ * Difference between \ref dilationByAnchor_2D and \ref erosionByAnchor_2D,
+ * computed in a single sweep over the rows: each row is read once, its 
+ * horizontal minima and maxima are computed in the same traversal, and 
+ * the vertical passes produce the output rows as soon as enough rows are
+ * available. No intermediate image is allocated.
+ */
+int gradientByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight)
+{
+  return gradientByAnchor_2D_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, seWidth, seHeight, NULL);
+}
+
+/*!
+ * \fn int gradientByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be equal to imageIn, with the same stride)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref gradientByAnchor_2D, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int gradientByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
+{
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(seWidth, imageWidth, "gradientByAnchor_2D", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(seHeight, imageHeight, "gradientByAnchor_2D", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "gradientByAnchor_2D") ) return MORPHO_ERROR;
+
+  return gradientByAnchor_rows(imageIn, NULL, NULL, imageOut, imageWidth, imageHeight, inStride, outStride, seWidth, seHeight, ctx);
+}
+
+/*!
+ * \fn int erosionDilationByAnchor_2D(uint8_t *imageIn, uint8_t *imageErosion, uint8_t *imageDilation, int imageWidth, int imageHeight, int seWidth, int seHeight)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageErosion Output buffer of the erosion
+ * \param[out]  *imageDilation Output buffer of the dilation
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Erosion and dilation with a seWidth * seHeight rectangle structuring element, in a single sweep
+ * 
+ * \ingroup libmorpho
+ *
+ * Gives the results of \ref erosionByAnchor_2D and \ref dilationByAnchor_2D
+ * while reading the input once, as \ref gradientByAnchor_2D does. 
+ */
+int erosionDilationByAnchor_2D(uint8_t *imageIn, uint8_t *imageErosion, uint8_t *imageDilation, int imageWidth, int imageHeight, int seWidth, int seHeight)
+{
+  return erosionDilationByAnchor_2D_ctx(imageIn, imageErosion, imageDilation, imageWidth, imageHeight, imageWidth, imageWidth, seWidth, seHeight, NULL);
+}
+
+/*!
+ * \fn int erosionDilationByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageErosion, uint8_t *imageDilation, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageErosion Output buffer of the erosion
+ * \param[out]  *imageDilation Output buffer of the dilation
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of both output buffers (>= imageWidth)
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref erosionDilationByAnchor_2D, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int erosionDilationByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageErosion, uint8_t *imageDilation, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
+{
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(seWidth, imageWidth, "erosionDilationByAnchor_2D", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(seHeight, imageHeight, "erosionDilationByAnchor_2D", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "erosionDilationByAnchor_2D") ) return MORPHO_ERROR;
+
+  return gradientByAnchor_rows(imageIn, imageErosion, imageDilation, NULL, imageWidth, imageHeight, inStride, outStride, seWidth, seHeight, ctx);
+}
@@ -0,0 +1,236 @@
+/* LIBMORPHO
+ *
+ * granulometryByAnchor.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file granulometryByAnchor.c
+ */
+
+#include "anchorUtil.h"
+
+/* Description of a granulometry, shared by the bands of sizes */
+struct	granulometry_job
+	{
+	uint8_t	*imageIn;
+	int	imageWidth, imageHeight, inStride;
+	int	firstSize, step, nbrSizes;
+	unsigned long long *volume;	/* volume of each opening */
+	uint8_t	*stack;			/* openings, or NULL */
+	uint8_t	*scratch;		/* padded images of the bands */
+	size_t	bandSize;		/* size of the padded images of a band */
+	struct morpho_ctx *ctx;		/* parent of the contexts of the bands */
+	};
+
+/* Sum of the pixels of a contiguous image */
+static unsigned long long image_volume(uint8_t *image, int nbrPixels)
+{
+  unsigned long long volume;
+  int	i;
+
+  volume = 0;
+  for (i=0; i<nbrPixels; i++) { volume += image[i]; }
+  return volume;
+}
+
+/* Sum of the pixels of an image with padded rows */
+static unsigned long long image_volume_stride(uint8_t *image, int imageWidth, int imageHeight, int stride)
+{
+  unsigned long long volume;
+  int	j;
+
+  volume = 0;
+  for (j=0; j<imageHeight; j++) { volume += image_volume(image+j*stride, imageWidth); }
+  return volume;
+}
+
+/* Openings by the squares of a contiguous band of sizes.
+ *
+ * The vertical opening by anchors (see openingByAnchor_1D_vertical) is the
+ * opening of the column extended by its first and last pixels. With the
+ * image extended by pad copies of its first and last rows, the opening by
+ * a square of size n (n/2 <= pad) is therefore the dilation of the erosion 
+ * by the same square, restricted to the rows of the image. The erosion by
+ * a square of size n+step is the erosion of the previous one by a square 
+ * of size step+1, so that only the first erosion of the band reads the 
+ * input. */
+static int granulometry_band(void *arg, int band, int nbrBands)
+{
+  struct granulometry_job *job = (struct granulometry_job *)arg;
+  struct morpho_ctx *ctx;
+  uint8_t *ero,*dil,*out;
+  int	w,h,k,j,first,last,size,pad,half,err;
+
+  first = morpho_band_first(job->nbrSizes, band, nbrBands);
+  last = morpho_band_first(job->nbrSizes, band+1, nbrBands);
+  if (first >= last) { return MORPHO_SUCCESS; }
+  w = job->imageWidth; h = job->imageHeight;
+  pad = (job->firstSize+(last-1)*job->step)/2;
+
+  /* Each band has its own images and child context */
+  ctx = morpho_ctx_child(job->ctx, band);
+  ero = job->scratch+band*job->bandSize;
+  dil = ero+(size_t)w*(h+2*pad);
+
+  /* Extension of the input */
+  for (j=0; j<h+2*pad; j++)
+    {
+      k = (j < pad) ? 0 : ( (j >= h+pad) ? h-1 : j-pad );
+      memcpy(ero+j*w, job->imageIn+k*job->inStride, w*sizeof(uint8_t));
+    }
+
+  err = MORPHO_SUCCESS;
+  for (k=first; (k<last) && (MORPHO_SUCCESS == err); k++)
+    {
+      size = job->firstSize+k*job->step;
+      half = size/2;
+      if (k == first)
+	err = erosionByAnchor_2D_ctx(ero, ero, w, h+2*pad, w, w, size, size, ctx);
+      else
+	err = erosionByAnchor_2D_ctx(ero, ero, w, h+2*pad, w, w, job->step+1, job->step+1, ctx);
+      if (MORPHO_SUCCESS == err)
+	err = dilationByAnchor_2D_ctx(ero+(pad-half)*w, dil, w, h+2*half, w, w, size, size, ctx);
+      out = dil+half*w;
+      if (job->stack != NULL)
+	{
+	  memcpy(job->stack+(size_t)k*w*h, out, w*h*sizeof(uint8_t));
+	}
+      job->volume[k] = image_volume(out, w*h);
+    }
+
+  return err;
+}
+
+/*!
+ * \fn int granulometryByAnchor_2D(uint8_t *imageIn, int imageWidth, int imageHeight, int firstSize, int lastSize, int step, unsigned long long *spectrum, uint8_t *stack)
+ * \param[in]  *imageIn Input buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  firstSize Size (odd, in pixels) of the smallest square structuring element
+ * \param[in]  lastSize Largest size of the square structuring elements
+ * \param[in]  step Difference (even) between two consecutive sizes
+ * \param[out]  *spectrum Pattern spectrum, one value per size
+ * \param[out]  *stack Openings, one imageWidth*imageHeight image per size (NULL if not needed)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Granulometry by squares of increasing sizes
+ *
+ * \ingroup libmorpho
+ *
+ * Openings by the squares of sizes firstSize, firstSize+step, ... up to
+ * lastSize, as \ref openingByAnchor_2D. spectrum[k] receives the volume
+ * (sum of the pixels) removed by the k-th opening from the previous one,
+ * the first one being compared to the input image, so that the spectrum
+ * sums to the volume of the input minus that of the last opening. When
+ * stack is not NULL, the k-th opening is written at stack+k*imageWidth*imageHeight.
+ *
+ * Consecutive sizes share their work: the erosion by a square is obtained
+ * by eroding the previous one by a square of size step+1.
+ */
+int granulometryByAnchor_2D(uint8_t *imageIn, int imageWidth, int imageHeight, int firstSize, int lastSize, int step, unsigned long long *spectrum, uint8_t *stack)
+{
+  return granulometryByAnchor_2D_ctx(imageIn, imageWidth, imageHeight, imageWidth, firstSize, lastSize, step, spectrum, stack, NULL);
+}
+
+/*!
+ * \fn int granulometryByAnchor_2D_ctx(uint8_t *imageIn, int imageWidth, int imageHeight, int inStride, int firstSize, int lastSize, int step, unsigned long long *spectrum, uint8_t *stack, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  firstSize Size (odd, in pixels) of the smallest square structuring element
+ * \param[in]  lastSize Largest size of the square structuring elements
+ * \param[in]  step Difference (even) between two consecutive sizes
+ * \param[out]  *spectrum Pattern spectrum, one value per size
+ * \param[out]  *stack Openings, one imageWidth*imageHeight image per size (NULL if not needed)
+ * \param[in]  ctx Context providing the scratch memory and the number of threads (NULL for one thread)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref granulometryByAnchor_2D, for an input with padded rows and with the settings of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. The sizes are split into as many contiguous
+ * bands as threads (see \ref morpho_ctx_set_num_threads); each band is
+ * processed with scratch memory of its own and starts with a full erosion
+ * of the input. The result does not depend on the number of threads. All
+ * the scratch memory, including that of the bands, is kept by the context,
+ * so that the calls after the first one do not allocate any memory.
+ */
+int granulometryByAnchor_2D_ctx(uint8_t *imageIn, int imageWidth, int imageHeight, int inStride, int firstSize, int lastSize, int step, unsigned long long *spectrum, uint8_t *stack, struct morpho_ctx *ctx)
+{
+  struct granulometry_job job;
+  unsigned long long previous;
+  char	st[200];
+  int	k,nbrSizes,nbrBands,err;
+
+  /* Tests */
+  if ( (step < 2) || (1 == (step%2)) || (lastSize < firstSize) ) {
+    snprintf(st, 200, "ERROR(granulometryByAnchor_2D): sizes %d to %d by steps of %d should be increasing by an even step.", firstSize, lastSize, step);
+    perror(st);
+    return MORPHO_ERROR;
+  }
+  nbrSizes = (lastSize-firstSize)/step+1;
+  lastSize = firstSize+(nbrSizes-1)*step;
+  if ( MORPHO_ERROR == is_size_valid_1D(firstSize, imageWidth, "granulometryByAnchor_2D", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(lastSize, imageWidth, "granulometryByAnchor_2D", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(lastSize, imageHeight, "granulometryByAnchor_2D", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, imageWidth, imageWidth, "granulometryByAnchor_2D") ) return MORPHO_ERROR;
+
+  /* The padded images of the bands and the volumes come from the context;
+     the bands run their operators with child contexts */
+  nbrBands = morpho_resolve_threads(morpho_ctx_threads(ctx), nbrSizes);
+  job.bandSize = (size_t)2*imageWidth*(imageHeight+2*(lastSize/2));
+  job.bandSize = (job.bandSize+sizeof(unsigned long long)-1)/sizeof(unsigned long long)*sizeof(unsigned long long);
+  job.scratch = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, nbrBands*job.bandSize+nbrSizes*sizeof(unsigned long long));
+  if (job.scratch == NULL) {
+    perror("Malloc");
+    return MORPHO_ERROR;
+  }
+  if ( MORPHO_ERROR == morpho_ctx_children(ctx, nbrBands, (nbrBands == 1) ? morpho_ctx_threads(ctx) : 1) ) {
+    morpho_scratch_release(ctx, job.scratch);
+    return MORPHO_ERROR;
+  }
+  job.volume = (unsigned long long *)(job.scratch+nbrBands*job.bandSize);
+  job.imageIn = imageIn;
+  job.imageWidth = imageWidth;
+  job.imageHeight = imageHeight;
+  job.inStride = inStride;
+  job.firstSize = firstSize;
+  job.step = step;
+  job.nbrSizes = nbrSizes;
+  job.stack = stack;
+  job.ctx = ctx;
+
+  /* Computation */
+  err = morpho_run_bands(granulometry_band, &job, nbrBands);
+  if (MORPHO_SUCCESS == err)
+    {
+      previous = image_volume_stride(imageIn, imageWidth, imageHeight, inStride);
+      for (k=0; k<nbrSizes; k++)
+	{
+	  spectrum[k] = previous-job.volume[k];
+	  previous = job.volume[k];
+	}
+    }
+
+  /* Free memory */
+  morpho_scratch_release(ctx, job.scratch);
+  if(DEBUG) printf(" finished.\n");
+  return err;
+}
@@ -0,0 +1,156 @@
+/* LIBMORPHO
+ *
+ * histogram.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "libmorpho.h"
+
+#ifndef __HISTOGRAM__
+#define __HISTOGRAM__
+
+/* Number of 64 bits words of the occupancy bitmap: enough for the 767
+   values of the structuring functions (SMALLEST_VAL..LARGEST_VAL) */
+#define	HISTO_WORDS	12
+
+/* Histogram of the values offset..offset+64*HISTO_WORDS-1.
+
+   With MORPHO_HISTOGRAM_LINEAR, only the counts are maintained and the
+   extremum is recovered by walking the counts, as in the original code.
+   With MORPHO_HISTOGRAM_BITMAP, the value v also has its bit set in word[] 
+   as long as count[v] > 0. The extremum is then found by a bit scan of at 
+   most HISTO_WORDS words, whatever the distance to the previous one. */
+struct	morpho_histogram
+	{
+	int	*count;			/* indexed by the value */
+	int	bitmap;			/* 1 if word[] is maintained */
+	int	offset;			/* smallest value */
+	unsigned long long word[HISTO_WORDS];
+	};
+
+#if defined(__GNUC__)
+#define	histo_ctz(x)	__builtin_ctzll(x)
+#define	histo_msb(x)	(63-__builtin_clzll(x))
+#else
+static int histo_ctz(unsigned long long x)
+{
+  int n = 0;
+  while (!(x & 1ULL)) { x >>= 1; n++; }
+  return n;
+}
+static int histo_msb(unsigned long long x)
+{
+  int n = 0;
+  while (x >>= 1) { n++; }
+  return n;
+}
+#endif
+
+/* Uses count, indexed from offset, with the given engine */
+static inline void histo_init(struct morpho_histogram *h, int *count, int offset, int histogram)
+{
+  h->count = count;
+  h->offset = offset;
+  h->bitmap = (histogram == MORPHO_HISTOGRAM_BITMAP);
+}
+
+/* Empties the histogram; count must hold nbrValues integers from offset */
+static inline void histo_reset(struct morpho_histogram *h, int nbrValues)
+{
+  memset(h->count+h->offset, 0, nbrValues*sizeof(int));
+  if (h->bitmap) { memset(h->word, 0, sizeof(h->word)); }
+}
+
+static inline void histo_add(struct morpho_histogram *h, int v)
+{
+  int i;
+
+  if ( (h->count[v]++ == 0) && h->bitmap )
+    {
+      i = v-h->offset;
+      h->word[i>>6] |= 1ULL << (i&63);
+    }
+}
+
+static inline void histo_remove(struct morpho_histogram *h, int v)
+{
+  int i;
+
+  if ( (--h->count[v] == 0) && h->bitmap )
+    {
+      i = v-h->offset;
+      h->word[i>>6] &= ~(1ULL << (i&63));
+    }
+}
+
+/* Smallest value >= from with a positive count; there must be one */
+static inline int histo_first(struct morpho_histogram *h, int from)
+{
+  unsigned long long bits;
+  int i,w;
+
+  if (!h->bitmap)
+    {
+      while (h->count[from] <= 0) { from++; }
+      return from;
+    }
+  i = from-h->offset;
+  w = i>>6;
+  bits = h->word[w] & (~0ULL << (i&63));
+  while (bits == 0) { bits = h->word[++w]; }
+  return h->offset+(w<<6)+histo_ctz(bits);
+}
+
+/* Largest value <= from with a positive count; there must be one */
+static inline int histo_last(struct morpho_histogram *h, int from)
+{
+  unsigned long long bits;
+  int i,w;
+
+  if (!h->bitmap)
+    {
+      while (h->count[from] <= 0) { from--; }
+      return from;
+    }
+  i = from-h->offset;
+  w = i>>6;
+  bits = h->word[w] & (~0ULL >> (63-(i&63)));
+  while (bits == 0) { bits = h->word[--w]; }
+  return h->offset+(w<<6)+histo_msb(bits);
+}
+
+/* Value of rank k (0 for the smallest) of the histogram. The search
+   starts from cur, *below being the number of values smaller than cur, 
+   and *below is updated for the value returned. Between two calls, the 
+   values added or removed below cur must be counted in *below; the search
+   then only walks the distance between the two ranked values. */
+static inline int histo_rank(struct morpho_histogram *h, int cur, int *below, int k)
+{
+  while (*below > k)
+    {
+      cur = histo_last(h, cur-1);
+      *below -= h->count[cur];
+    }
+  while (*below+h->count[cur] <= k)
+    {
+      *below += h->count[cur];
+      cur = histo_first(h, cur+1);
+    }
+  return cur;
+}
+
+#endif
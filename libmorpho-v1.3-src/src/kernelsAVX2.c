@@ -0,0 +1,165 @@
+/* LIBMORPHO
+ *
+ * kernelsAVX2.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file kernelsAVX2.c
+ */ 
+
+#include "dispatch.h"
+
+#if MORPHO_X86_DISPATCH
+
+#include <immintrin.h>
+
+/* AVX2 kernels, 32 pixels or 4 words at a time; see struct morpho_kernels */
+
+#define	AVX2	__attribute__((target("avx2")))
+
+AVX2 static void avx2_rows_min(uint8_t *a, uint8_t *b, uint8_t *out, int n)
+{
+  int x;
+
+  for (x=0; x+32<=n; x+=32)
+    _mm256_storeu_si256((__m256i *)(out+x), _mm256_min_epu8(_mm256_loadu_si256((__m256i *)(a+x)), _mm256_loadu_si256((__m256i *)(b+x))));
+  kernel_rows_min(a+x, b+x, out+x, n-x);
+}
+
+AVX2 static void avx2_rows_max(uint8_t *a, uint8_t *b, uint8_t *out, int n)
+{
+  int x;
+
+  for (x=0; x+32<=n; x+=32)
+    _mm256_storeu_si256((__m256i *)(out+x), _mm256_max_epu8(_mm256_loadu_si256((__m256i *)(a+x)), _mm256_loadu_si256((__m256i *)(b+x))));
+  kernel_rows_max(a+x, b+x, out+x, n-x);
+}
+
+AVX2 static void avx2_rows_sub(uint8_t *a, uint8_t *b, uint8_t *out, int n)
+{
+  int x;
+
+  for (x=0; x+32<=n; x+=32)
+    _mm256_storeu_si256((__m256i *)(out+x), _mm256_subs_epu8(_mm256_loadu_si256((__m256i *)(a+x)), _mm256_loadu_si256((__m256i *)(b+x))));
+  kernel_rows_sub(a+x, b+x, out+x, n-x);
+}
+
+AVX2 static int avx2_find_other(uint8_t *line, int n, uint8_t a, uint8_t b)
+{
+  __m256i va,vb,v;
+  unsigned mask;
+  int 	x;
+
+  va = _mm256_set1_epi8((char)a);
+  vb = _mm256_set1_epi8((char)b);
+  for (x=0; x+32<=n; x+=32)
+    {
+      v = _mm256_loadu_si256((__m256i *)(line+x));
+      mask = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)));
+      if (mask != 0xFFFFFFFFU) { return x+__builtin_ctz(~mask); }
+    }
+  return x+kernel_find_other(line+x, n-x, a, b);
+}
+
+AVX2 static void avx2_pack_bits(uint8_t *line, int n, uint8_t hi, unsigned long long *words)
+{
+  __m256i vhi;
+  unsigned long long low,high;
+  int 	x;
+
+  vhi = _mm256_set1_epi8((char)hi);
+  for (x=0; x+64<=n; x+=64)
+    {
+      low = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *)(line+x)), vhi));
+      high = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *)(line+x+32)), vhi));
+      words[x/64] = low | (high << 32);
+    }
+  kernel_pack_bits(line+x, n-x, hi, words+x/64);
+}
+
+AVX2 static void avx2_unpack_bits(unsigned long long *words, int n, uint8_t lo, uint8_t hi, uint8_t *line)
+{
+  __m256i vlo,vdiff,pattern,m;
+  unsigned bits;
+  int 	x;
+
+  vlo = _mm256_set1_epi8((char)lo);
+  vdiff = _mm256_set1_epi8((char)(lo^hi));
+  pattern = _mm256_set1_epi64x((long long)0x8040201008040201ULL);
+  /* Byte i of a group of 8 pixels is set if bit i of their byte is */
+  for (x=0; x+32<=n; x+=32)
+    {
+      bits = (unsigned)(words[x/64] >> (x%64));
+      m = _mm256_set_epi64x((long long)(((bits>>24)&0xFF)*0x0101010101010101ULL), (long long)(((bits>>16)&0xFF)*0x0101010101010101ULL),
+			    (long long)(((bits>>8)&0xFF)*0x0101010101010101ULL), (long long)((bits&0xFF)*0x0101010101010101ULL));
+      m = _mm256_cmpeq_epi8(_mm256_and_si256(m, pattern), pattern);
+      _mm256_storeu_si256((__m256i *)(line+x), _mm256_xor_si256(vlo, _mm256_and_si256(m, vdiff)));
+    }
+  for (; x<n; x++)
+    line[x] = ( (words[x/64] >> (x%64)) & 1ULL ) ? hi : lo;
+}
+
+AVX2 static void avx2_shifted_and(unsigned long long *acc, unsigned long long *row, int n, int r)
+{
+  __m128i right,left;
+  __m256i v;
+  int 	k;
+
+  right = _mm_cvtsi32_si128(r);
+  left = _mm_cvtsi32_si128(64-r);
+  for (k=0; k+4<=n; k+=4)
+    {
+      v = _mm256_or_si256(_mm256_srl_epi64(_mm256_loadu_si256((__m256i *)(row+k)), right),
+			  _mm256_sll_epi64(_mm256_loadu_si256((__m256i *)(row+k+1)), left));
+      _mm256_storeu_si256((__m256i *)(acc+k), _mm256_and_si256(_mm256_loadu_si256((__m256i *)(acc+k)), v));
+    }
+  kernel_shifted_and(acc+k, row+k, n-k, r);
+}
+
+AVX2 static void avx2_shifted_or(unsigned long long *acc, unsigned long long *row, int n, int r)
+{
+  __m128i right,left;
+  __m256i v;
+  int 	k;
+
+  right = _mm_cvtsi32_si128(r);
+  left = _mm_cvtsi32_si128(64-r);
+  for (k=0; k+4<=n; k+=4)
+    {
+      v = _mm256_or_si256(_mm256_srl_epi64(_mm256_loadu_si256((__m256i *)(row+k)), right),
+			  _mm256_sll_epi64(_mm256_loadu_si256((__m256i *)(row+k+1)), left));
+      _mm256_storeu_si256((__m256i *)(acc+k), _mm256_or_si256(_mm256_loadu_si256((__m256i *)(acc+k)), v));
+    }
+  kernel_shifted_or(acc+k, row+k, n-k, r);
+}
+
+const struct morpho_kernels morpho_kernels_avx2 =
+  {
+    "avx2",
+    avx2_rows_min,
+    avx2_rows_max,
+    avx2_rows_sub,
+    kernel_transpose_sse2,
+    avx2_find_other,
+    avx2_pack_bits,
+    avx2_unpack_bits,
+    avx2_shifted_and,
+    avx2_shifted_or
+  };
+
+#endif
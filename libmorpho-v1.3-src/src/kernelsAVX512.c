@@ -0,0 +1,151 @@
+/* LIBMORPHO
+ *
+ * kernelsAVX512.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file kernelsAVX512.c
+ */ 
+
+#include "dispatch.h"
+
+#if MORPHO_X86_DISPATCH
+
+#include <immintrin.h>
+
+/* AVX-512 (F and BW) kernels, 64 pixels or 8 words at a time; see 
+   struct morpho_kernels */
+
+#define	AVX512	__attribute__((target("avx512f,avx512bw")))
+
+AVX512 static void avx512_rows_min(uint8_t *a, uint8_t *b, uint8_t *out, int n)
+{
+  int x;
+
+  for (x=0; x+64<=n; x+=64)
+    _mm512_storeu_si512((void *)(out+x), _mm512_min_epu8(_mm512_loadu_si512((void *)(a+x)), _mm512_loadu_si512((void *)(b+x))));
+  kernel_rows_min(a+x, b+x, out+x, n-x);
+}
+
+AVX512 static void avx512_rows_max(uint8_t *a, uint8_t *b, uint8_t *out, int n)
+{
+  int x;
+
+  for (x=0; x+64<=n; x+=64)
+    _mm512_storeu_si512((void *)(out+x), _mm512_max_epu8(_mm512_loadu_si512((void *)(a+x)), _mm512_loadu_si512((void *)(b+x))));
+  kernel_rows_max(a+x, b+x, out+x, n-x);
+}
+
+AVX512 static void avx512_rows_sub(uint8_t *a, uint8_t *b, uint8_t *out, int n)
+{
+  int x;
+
+  for (x=0; x+64<=n; x+=64)
+    _mm512_storeu_si512((void *)(out+x), _mm512_subs_epu8(_mm512_loadu_si512((void *)(a+x)), _mm512_loadu_si512((void *)(b+x))));
+  kernel_rows_sub(a+x, b+x, out+x, n-x);
+}
+
+AVX512 static int avx512_find_other(uint8_t *line, int n, uint8_t a, uint8_t b)
+{
+  __m512i va,vb,v;
+  unsigned long long mask;
+  int 	x;
+
+  va = _mm512_set1_epi8((char)a);
+  vb = _mm512_set1_epi8((char)b);
+  for (x=0; x+64<=n; x+=64)
+    {
+      v = _mm512_loadu_si512((void *)(line+x));
+      mask = _mm512_cmpeq_epi8_mask(v, va) | _mm512_cmpeq_epi8_mask(v, vb);
+      if (mask != ~0ULL) { return x+__builtin_ctzll(~mask); }
+    }
+  return x+kernel_find_other(line+x, n-x, a, b);
+}
+
+AVX512 static void avx512_pack_bits(uint8_t *line, int n, uint8_t hi, unsigned long long *words)
+{
+  __m512i vhi;
+  int 	x;
+
+  vhi = _mm512_set1_epi8((char)hi);
+  for (x=0; x+64<=n; x+=64)
+    words[x/64] = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((void *)(line+x)), vhi);
+  kernel_pack_bits(line+x, n-x, hi, words+x/64);
+}
+
+AVX512 static void avx512_unpack_bits(unsigned long long *words, int n, uint8_t lo, uint8_t hi, uint8_t *line)
+{
+  __m512i vlo,vhi;
+  int 	x;
+
+  vlo = _mm512_set1_epi8((char)lo);
+  vhi = _mm512_set1_epi8((char)hi);
+  for (x=0; x+64<=n; x+=64)
+    _mm512_storeu_si512((void *)(line+x), _mm512_mask_blend_epi8(words[x/64], vlo, vhi));
+  kernel_unpack_bits(words+x/64, n-x, lo, hi, line+x);
+}
+
+AVX512 static void avx512_shifted_and(unsigned long long *acc, unsigned long long *row, int n, int r)
+{
+  __m128i right,left;
+  __m512i v;
+  int 	k;
+
+  right = _mm_cvtsi32_si128(r);
+  left = _mm_cvtsi32_si128(64-r);
+  for (k=0; k+8<=n; k+=8)
+    {
+      v = _mm512_or_si512(_mm512_srl_epi64(_mm512_loadu_si512((void *)(row+k)), right),
+			  _mm512_sll_epi64(_mm512_loadu_si512((void *)(row+k+1)), left));
+      _mm512_storeu_si512((void *)(acc+k), _mm512_and_si512(_mm512_loadu_si512((void *)(acc+k)), v));
+    }
+  kernel_shifted_and(acc+k, row+k, n-k, r);
+}
+
+AVX512 static void avx512_shifted_or(unsigned long long *acc, unsigned long long *row, int n, int r)
+{
+  __m128i right,left;
+  __m512i v;
+  int 	k;
+
+  right = _mm_cvtsi32_si128(r);
+  left = _mm_cvtsi32_si128(64-r);
+  for (k=0; k+8<=n; k+=8)
+    {
+      v = _mm512_or_si512(_mm512_srl_epi64(_mm512_loadu_si512((void *)(row+k)), right),
+			  _mm512_sll_epi64(_mm512_loadu_si512((void *)(row+k+1)), left));
+      _mm512_storeu_si512((void *)(acc+k), _mm512_or_si512(_mm512_loadu_si512((void *)(acc+k)), v));
+    }
+  kernel_shifted_or(acc+k, row+k, n-k, r);
+}
+
+const struct morpho_kernels morpho_kernels_avx512 =
+  {
+    "avx512",
+    avx512_rows_min,
+    avx512_rows_max,
+    avx512_rows_sub,
+    kernel_transpose_sse2,
+    avx512_find_other,
+    avx512_pack_bits,
+    avx512_unpack_bits,
+    avx512_shifted_and,
+    avx512_shifted_or
+  };
+
+#endif
@@ -0,0 +1,197 @@
+/* LIBMORPHO
+ *
+ * kernelsSSE2.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file kernelsSSE2.c
+ */ 
+
+#include "dispatch.h"
+
+#if MORPHO_X86_DISPATCH
+
+#include <immintrin.h>
+
+/* SSE2 kernels, 16 pixels or 2 words at a time; see struct morpho_kernels */
+
+#define	SSE2	__attribute__((target("sse2")))
+
+SSE2 static void sse2_rows_min(uint8_t *a, uint8_t *b, uint8_t *out, int n)
+{
+  int x;
+
+  for (x=0; x+16<=n; x+=16)
+    _mm_storeu_si128((__m128i *)(out+x), _mm_min_epu8(_mm_loadu_si128((__m128i *)(a+x)), _mm_loadu_si128((__m128i *)(b+x))));
+  kernel_rows_min(a+x, b+x, out+x, n-x);
+}
+
+SSE2 static void sse2_rows_max(uint8_t *a, uint8_t *b, uint8_t *out, int n)
+{
+  int x;
+
+  for (x=0; x+16<=n; x+=16)
+    _mm_storeu_si128((__m128i *)(out+x), _mm_max_epu8(_mm_loadu_si128((__m128i *)(a+x)), _mm_loadu_si128((__m128i *)(b+x))));
+  kernel_rows_max(a+x, b+x, out+x, n-x);
+}
+
+SSE2 static void sse2_rows_sub(uint8_t *a, uint8_t *b, uint8_t *out, int n)
+{
+  int x;
+
+  for (x=0; x+16<=n; x+=16)
+    _mm_storeu_si128((__m128i *)(out+x), _mm_subs_epu8(_mm_loadu_si128((__m128i *)(a+x)), _mm_loadu_si128((__m128i *)(b+x))));
+  kernel_rows_sub(a+x, b+x, out+x, n-x);
+}
+
+/* Transposes a 16 x 16 tile in registers: four rounds of interleaving 
+   the bytes of rows i and i+8 turn the rows into the columns */
+SSE2 static void sse2_transpose_tile(uint8_t *in, int inStride, uint8_t *out, int outStride)
+{
+  __m128i a[16],b[16];
+  int 	i,round;
+
+  for (i=0; i<16; i++)
+    a[i] = _mm_loadu_si128((__m128i *)(in+(size_t)i*inStride));
+  for (round=0; round<4; round++)
+    {
+      for (i=0; i<8; i++)
+	{
+	  b[2*i] = _mm_unpacklo_epi8(a[i], a[i+8]);
+	  b[2*i+1] = _mm_unpackhi_epi8(a[i], a[i+8]);
+	}
+      memcpy(a, b, sizeof(a));
+    }
+  for (i=0; i<16; i++)
+    _mm_storeu_si128((__m128i *)(out+(size_t)i*outStride), a[i]);
+}
+
+SSE2 void kernel_transpose_sse2(uint8_t *in, int inStride, uint8_t *out, int outStride, int width, int height)
+{
+  int 	x0,y0;
+
+  for (y0=0; y0+TRANSPOSE_TILE<=height; y0+=TRANSPOSE_TILE)
+    {
+      for (x0=0; x0+TRANSPOSE_TILE<=width; x0+=TRANSPOSE_TILE)
+	sse2_transpose_tile(in+(size_t)y0*inStride+x0, inStride, out+(size_t)x0*outStride+y0, outStride);
+      kernel_transpose(in+(size_t)y0*inStride+x0, inStride, out+(size_t)x0*outStride+y0, outStride, width-x0, TRANSPOSE_TILE);
+    }
+  kernel_transpose(in+(size_t)y0*inStride, inStride, out+y0, outStride, width, height-y0);
+}
+
+SSE2 static int sse2_find_other(uint8_t *line, int n, uint8_t a, uint8_t b)
+{
+  __m128i va,vb,v;
+  int 	x,mask;
+
+  va = _mm_set1_epi8((char)a);
+  vb = _mm_set1_epi8((char)b);
+  for (x=0; x+16<=n; x+=16)
+    {
+      v = _mm_loadu_si128((__m128i *)(line+x));
+      mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+      if (mask != 0xFFFF) { return x+__builtin_ctz(~mask); }
+    }
+  return x+kernel_find_other(line+x, n-x, a, b);
+}
+
+SSE2 static void sse2_pack_bits(uint8_t *line, int n, uint8_t hi, unsigned long long *words)
+{
+  __m128i vhi;
+  unsigned long long word;
+  int 	x,i;
+
+  vhi = _mm_set1_epi8((char)hi);
+  for (x=0; x+64<=n; x+=64)
+    {
+      word = 0ULL;
+      for (i=0; i<64; i+=16)
+	word |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i *)(line+x+i)), vhi)) << i;
+      words[x/64] = word;
+    }
+  kernel_pack_bits(line+x, n-x, hi, words+x/64);
+}
+
+SSE2 static void sse2_unpack_bits(unsigned long long *words, int n, uint8_t lo, uint8_t hi, uint8_t *line)
+{
+  __m128i vlo,vdiff,pattern,m;
+  unsigned bits;
+  int 	x;
+
+  vlo = _mm_set1_epi8((char)lo);
+  vdiff = _mm_set1_epi8((char)(lo^hi));
+  pattern = _mm_set1_epi64x((long long)0x8040201008040201ULL);
+  /* Byte i of a group of 8 pixels is set if bit i of their byte is */
+  for (x=0; x+16<=n; x+=16)
+    {
+      bits = (unsigned)(words[x/64] >> (x%64));
+      m = _mm_set_epi64x((long long)(((bits>>8)&0xFF)*0x0101010101010101ULL), (long long)((bits&0xFF)*0x0101010101010101ULL));
+      m = _mm_cmpeq_epi8(_mm_and_si128(m, pattern), pattern);
+      _mm_storeu_si128((__m128i *)(line+x), _mm_xor_si128(vlo, _mm_and_si128(m, vdiff)));
+    }
+  for (; x<n; x++)
+    line[x] = ( (words[x/64] >> (x%64)) & 1ULL ) ? hi : lo;
+}
+
+SSE2 static void sse2_shifted_and(unsigned long long *acc, unsigned long long *row, int n, int r)
+{
+  __m128i right,left,v;
+  int 	k;
+
+  right = _mm_cvtsi32_si128(r);
+  left = _mm_cvtsi32_si128(64-r);
+  for (k=0; k+2<=n; k+=2)
+    {
+      v = _mm_or_si128(_mm_srl_epi64(_mm_loadu_si128((__m128i *)(row+k)), right),
+		       _mm_sll_epi64(_mm_loadu_si128((__m128i *)(row+k+1)), left));
+      _mm_storeu_si128((__m128i *)(acc+k), _mm_and_si128(_mm_loadu_si128((__m128i *)(acc+k)), v));
+    }
+  kernel_shifted_and(acc+k, row+k, n-k, r);
+}
+
+SSE2 static void sse2_shifted_or(unsigned long long *acc, unsigned long long *row, int n, int r)
+{
+  __m128i right,left,v;
+  int 	k;
+
+  right = _mm_cvtsi32_si128(r);
+  left = _mm_cvtsi32_si128(64-r);
+  for (k=0; k+2<=n; k+=2)
+    {
+      v = _mm_or_si128(_mm_srl_epi64(_mm_loadu_si128((__m128i *)(row+k)), right),
+		       _mm_sll_epi64(_mm_loadu_si128((__m128i *)(row+k+1)), left));
+      _mm_storeu_si128((__m128i *)(acc+k), _mm_or_si128(_mm_loadu_si128((__m128i *)(acc+k)), v));
+    }
+  kernel_shifted_or(acc+k, row+k, n-k, r);
+}
+
+const struct morpho_kernels morpho_kernels_sse2 =
+  {
+    "sse2",
+    sse2_rows_min,
+    sse2_rows_max,
+    sse2_rows_sub,
+    kernel_transpose_sse2,
+    sse2_find_other,
+    sse2_pack_bits,
+    sse2_unpack_bits,
+    sse2_shifted_and,
+    sse2_shifted_or
+  };
+
+#endif
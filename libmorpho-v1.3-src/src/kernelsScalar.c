@@ -0,0 +1,134 @@
+/* LIBMORPHO
+ *
+ * kernelsScalar.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file kernelsScalar.c
+ */ 
+
+#include "dispatch.h"
+
+/* Portable kernels, see struct morpho_kernels */
+
+void kernel_rows_min(uint8_t *a, uint8_t *b, uint8_t *out, int n)
+{
+  int x;
+
+  for (x=0; x<n; x++)
+    out[x] = (a[x] < b[x]) ? a[x] : b[x];
+}
+
+void kernel_rows_max(uint8_t *a, uint8_t *b, uint8_t *out, int n)
+{
+  int x;
+
+  for (x=0; x<n; x++)
+    out[x] = (a[x] > b[x]) ? a[x] : b[x];
+}
+
+void kernel_rows_sub(uint8_t *a, uint8_t *b, uint8_t *out, int n)
+{
+  int x;
+
+  for (x=0; x<n; x++)
+    out[x] = (a[x] > b[x]) ? a[x]-b[x] : 0;
+}
+
+/* The image is transposed by tiles of TRANSPOSE_TILE x TRANSPOSE_TILE 
+   pixels, so that the rows of the output being written stay in the cache 
+   (and in the TLB) while a tile is processed */
+void kernel_transpose(uint8_t *in, int inStride, uint8_t *out, int outStride, int width, int height)
+{
+  int x,y,x0,y0,xEnd,yEnd;
+  uint8_t *row;
+
+  for (y0=0; y0<height; y0+=TRANSPOSE_TILE)
+    {
+      yEnd = (y0+TRANSPOSE_TILE < height) ? y0+TRANSPOSE_TILE : height;
+      for (x0=0; x0<width; x0+=TRANSPOSE_TILE)
+	{
+	  xEnd = (x0+TRANSPOSE_TILE < width) ? x0+TRANSPOSE_TILE : width;
+	  for (y=y0; y<yEnd; y++)
+	    {
+	      row = in+(size_t)y*inStride;
+	      for (x=x0; x<xEnd; x++) { out[(size_t)x*outStride+y] = row[x]; }
+	    }
+	}
+    }
+}
+
+int kernel_find_other(uint8_t *line, int n, uint8_t a, uint8_t b)
+{
+  int x;
+
+  for (x=0; x<n; x++)
+    if ( (line[x] != a) && (line[x] != b) ) { return x; }
+  return n;
+}
+
+void kernel_pack_bits(uint8_t *line, int n, uint8_t hi, unsigned long long *words)
+{
+  int x;
+
+  for (x=0; x<(n+63)/64; x++) { words[x] = 0ULL; }
+  for (x=0; x<n; x++)
+    if (line[x] == hi) { words[x/64] |= 1ULL << (x%64); }
+}
+
+void kernel_unpack_bits(unsigned long long *words, int n, uint8_t lo, uint8_t hi, uint8_t *line)
+{
+  int x;
+
+  for (x=0; x<n; x++)
+    line[x] = ( (words[x/64] >> (x%64)) & 1ULL ) ? hi : lo;
+}
+
+void kernel_shifted_and(unsigned long long *acc, unsigned long long *row, int n, int r)
+{
+  int k;
+
+  if (r == 0)
+    for (k=0; k<n; k++) { acc[k] &= row[k]; }
+  else
+    for (k=0; k<n; k++) { acc[k] &= (row[k] >> r) | (row[k+1] << (64-r)); }
+}
+
+void kernel_shifted_or(unsigned long long *acc, unsigned long long *row, int n, int r)
+{
+  int k;
+
+  if (r == 0)
+    for (k=0; k<n; k++) { acc[k] |= row[k]; }
+  else
+    for (k=0; k<n; k++) { acc[k] |= (row[k] >> r) | (row[k+1] << (64-r)); }
+}
+
+const struct morpho_kernels morpho_kernels_scalar =
+  {
+    "scalar",
+    kernel_rows_min,
+    kernel_rows_max,
+    kernel_rows_sub,
+    kernel_transpose,
+    kernel_find_other,
+    kernel_pack_bits,
+    kernel_unpack_bits,
+    kernel_shifted_and,
+    kernel_shifted_or
+  };
@@ -83,53 +83,360 @@ typedef short int int16_t;
 */
 #define  MORPHO_SUCCESS 0
 
+/* Histogram engines, see morpho_ctx_set_histogram() */
+/*!
+ * \def  MORPHO_HISTOGRAM_LINEAR
+ * The extremum of a histogram is found by walking its entries (default)
+*/
+#define  MORPHO_HISTOGRAM_LINEAR 0
+
+/*!
+ * \def  MORPHO_HISTOGRAM_BITMAP
+ * The extremum of a histogram is found by scanning a bitmap of its non-empty entries
+*/
+#define  MORPHO_HISTOGRAM_BITMAP 1
+
+/* Engines of the erosions and dilations by a segment or a rectangle, see morpho_ctx_set_engine() */
+/*!
+ * \def  MORPHO_ENGINE_AUTO
+ * The engine is chosen at each call from the size of the segment and a sample of the image (default)
+*/
+#define  MORPHO_ENGINE_AUTO 0
+
+/*!
+ * \def  MORPHO_ENGINE_ANCHOR
+ * The erosions and dilations by a segment always use the anchors
+*/
+#define  MORPHO_ENGINE_ANCHOR 1
+
+/*!
+ * \def  MORPHO_ENGINE_VHGW
+ * The erosions and dilations by a segment always use the van Herk/Gil-Werman algorithm
+*/
+#define  MORPHO_ENGINE_VHGW 2
+
+/* Gradients by an arbitrary structuring element, see gradient_arbitrary_SE() */
+/*!
+ * \def  MORPHO_GRADIENT_BEUCHER
+ * Dilation minus erosion
+*/
+#define  MORPHO_GRADIENT_BEUCHER 0
+
+/*!
+ * \def  MORPHO_GRADIENT_INTERNAL
+ * Image minus its erosion
+*/
+#define  MORPHO_GRADIENT_INTERNAL 1
+
+/*!
+ * \def  MORPHO_GRADIENT_EXTERNAL
+ * Dilation minus the image
+*/
+#define  MORPHO_GRADIENT_EXTERNAL 2
+
+/* Alternating sequential filters, see asfByAnchor_2D() */
+/*!
+ * \def  MORPHO_ASF_OPEN_CLOSE
+ * Each step is an opening followed by a closing
+*/
+#define  MORPHO_ASF_OPEN_CLOSE 0
+
+/*!
+ * \def  MORPHO_ASF_CLOSE_OPEN
+ * Each step is a closing followed by an opening
+*/
+#define  MORPHO_ASF_CLOSE_OPEN 1
+
+/*!
+ * \def  MORPHO_TREE_MAX
+ * Max-tree, for the area openings
+*/
+#define  MORPHO_TREE_MAX 0
+
+/*!
+ * \def  MORPHO_TREE_MIN
+ * Min-tree, for the area closings
+*/
+#define  MORPHO_TREE_MIN 1
+
+/*!
+ * \def  MORPHO_PATH_VERTICAL
+ * Paths going down, each pixel followed by one of the three pixels below it
+*/
+#define  MORPHO_PATH_VERTICAL 1
+
+/*!
+ * \def  MORPHO_PATH_HORIZONTAL
+ * Paths going right, each pixel followed by one of the three pixels on its right
+*/
+#define  MORPHO_PATH_HORIZONTAL 2
+
+/*!
+ * \def  MORPHO_PATH_DIAGONAL
+ * Paths going right and up, each pixel followed by its right, upper right or upper neighbor
+*/
+#define  MORPHO_PATH_DIAGONAL 4
+
+/*!
+ * \def  MORPHO_PATH_ANTIDIAGONAL
+ * Paths going right and down, each pixel followed by its right, lower right or lower neighbor
+*/
+#define  MORPHO_PATH_ANTIDIAGONAL 8
+
+/*!
+ * \def  MORPHO_PATH_ALL
+ * The four adjacency graphs of the paths
+*/
+#define  MORPHO_PATH_ALL 15
+
 /* util.c */
 int imageTranspose(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight);
 int is_size_valid_1D(int size, int imageWidth, char *func, int odd);
+int is_stride_valid(int inStride, int outStride, int imageWidth, char *func);
+
+/* workspace.c */
+struct morpho_ctx;
+struct morpho_ctx *morpho_ctx_create(int maxWidth, int maxHeight, int maxSeWidth, int maxSeHeight);
+void morpho_ctx_free(struct morpho_ctx *ctx);
+int morpho_ctx_set_num_threads(struct morpho_ctx *ctx, int nbrThreads);
+int morpho_ctx_set_histogram(struct morpho_ctx *ctx, int histogram);
+int morpho_ctx_set_engine(struct morpho_ctx *ctx, int engine);
+
+/* threadPool.c */
+int morpho_set_num_threads(int nbrThreads);
+int morpho_get_num_threads(void);
+void morpho_release_threads(void);
+
+/* dispatch.c */
+const char *morpho_get_isa(void);
+int morpho_set_isa(const char *isa);
 
 /* erosionByAnchor.c */
 int erosionByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int erosionByAnchor_1D_horizontal_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size);
+int erosionByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int erosionByAnchor_1D_horizontal_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int nbrThreads);
 int erosionByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int erosionByAnchor_1D_vertical_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size);
+int erosionByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int erosionByAnchor_1D_oriented(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, double angle);
+int erosionByAnchor_1D_oriented_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, double angle, struct morpho_ctx *ctx);
 int erosionByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight);
+int erosionByAnchor_2D_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight);
+int erosionByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx);
+int erosionByAnchor_2D_fused(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight);
+int erosionByAnchor_2D_fused_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx);
 
 /* src/dilationByAnchor.c */
 int dilationByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int dilationByAnchor_1D_horizontal_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size);
+int dilationByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int dilationByAnchor_1D_horizontal_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int nbrThreads);
 int dilationByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int dilationByAnchor_1D_vertical_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size);
+int dilationByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int dilationByAnchor_1D_oriented(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, double angle);
+int dilationByAnchor_1D_oriented_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, double angle, struct morpho_ctx *ctx);
 int dilationByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight);
+int dilationByAnchor_2D_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight);
+int dilationByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx);
+int dilationByAnchor_2D_fused(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight);
+int dilationByAnchor_2D_fused_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx);
 
 /* openingByAnchor.c */
 int openingByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int openingByAnchor_1D_horizontal_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size);
+int openingByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int openingByAnchor_1D_horizontal_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int nbrThreads);
 int openingByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int openingByAnchor_1D_vertical_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size);
+int openingByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int openingByAnchor_1D_oriented(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, double angle);
+int openingByAnchor_1D_oriented_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, double angle, struct morpho_ctx *ctx);
+int openingByAnchor_1D_oriented_bank(uint8_t *imageIn, uint8_t *imageOut, uint8_t *imageAngle, int imageWidth, int imageHeight, int size, double *angles, int nbrAngles);
+int openingByAnchor_1D_oriented_bank_ctx(uint8_t *imageIn, uint8_t *imageOut, uint8_t *imageAngle, int imageWidth, int imageHeight, int inStride, int outStride, int size, double *angles, int nbrAngles, struct morpho_ctx *ctx);
 int openingByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight);
+int openingByAnchor_2D_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight);
+int openingByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx);
+int whiteTopHatByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int whiteTopHatByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int whiteTopHatByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int whiteTopHatByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int whiteTopHatByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight);
+int whiteTopHatByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx);
 
 /* closingByAnchor.c */
 int closingByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int closingByAnchor_1D_horizontal_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size);
+int closingByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int closingByAnchor_1D_horizontal_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int nbrThreads);
 int closingByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int closingByAnchor_1D_vertical_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size);
+int closingByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int closingByAnchor_1D_oriented(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, double angle);
+int closingByAnchor_1D_oriented_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, double angle, struct morpho_ctx *ctx);
+int closingByAnchor_1D_oriented_bank(uint8_t *imageIn, uint8_t *imageOut, uint8_t *imageAngle, int imageWidth, int imageHeight, int size, double *angles, int nbrAngles);
+int closingByAnchor_1D_oriented_bank_ctx(uint8_t *imageIn, uint8_t *imageOut, uint8_t *imageAngle, int imageWidth, int imageHeight, int inStride, int outStride, int size, double *angles, int nbrAngles, struct morpho_ctx *ctx);
 int closingByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight);
+int closingByAnchor_2D_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight);
+int closingByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx);
+int blackTopHatByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int blackTopHatByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int blackTopHatByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int blackTopHatByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int blackTopHatByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight);
+int blackTopHatByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx);
+
+/* gradientByAnchor.c */
+int gradientByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int gradientByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int gradientByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size);
+int gradientByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx);
+int gradientByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight);
+int gradientByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx);
+int erosionDilationByAnchor_2D(uint8_t *imageIn, uint8_t *imageErosion, uint8_t *imageDilation, int imageWidth, int imageHeight, int seWidth, int seHeight);
+int erosionDilationByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageErosion, uint8_t *imageDilation, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx);
+
+/* asfByAnchor.c */
+int asfByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight, int nbrSteps, int order);
+int asfByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, int nbrSteps, int order, struct morpho_ctx *ctx);
+
+/* granulometryByAnchor.c */
+int granulometryByAnchor_2D(uint8_t *imageIn, int imageWidth, int imageHeight, int firstSize, int lastSize, int step, unsigned long long *spectrum, uint8_t *stack);
+int granulometryByAnchor_2D_ctx(uint8_t *imageIn, int imageWidth, int imageHeight, int inStride, int firstSize, int lastSize, int step, unsigned long long *spectrum, uint8_t *stack, struct morpho_ctx *ctx);
+
+/* rankByAnchor.c */
+int rankByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int rank, int outOf);
+int rankByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, int rank, int outOf, struct morpho_ctx *ctx);
+int rankByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int rank, int outOf);
+int rankByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, int rank, int outOf, struct morpho_ctx *ctx);
+int rankByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight, int rank, int outOf);
+int medianByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight);
+int rankByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, int rank, int outOf, struct morpho_ctx *ctx);
+
+/* sePlan.c */
+struct morpho_se_plan;
+struct morpho_se_plan *morpho_se_plan_create(uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int imageWidth);
+struct morpho_se_plan *morpho_sf_plan_create(uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int imageWidth);
+void morpho_se_plan_free(struct morpho_se_plan *plan);
 
 /* erosionArbitrarySE.c */
 int erosion_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int erosion_arbitrary_SE_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int erosion_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx);
+int erosion_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx);
+int erosion_arbitrary_SE_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int nbrThreads);
 
 /* dilationArbitrarySE.c */
 int dilation_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int dilation_arbitrary_SE_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int dilation_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx);
+int dilation_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx);
+int dilation_arbitrary_SE_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int nbrThreads);
 
 /* openingArbitrarySE.c */
 int opening_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se1, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int opening_arbitrary_SE_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int opening_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx);
+int opening_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx);
+int opening_arbitrary_SE_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int nbrThreads);
 
 /* closingArbitrarySE.c */
 int closing_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se1, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int closing_arbitrary_SE_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int closing_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx);
+int closing_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx);
+int closing_arbitrary_SE_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int nbrThreads);
+
+/* gradientArbitrarySE.c */
+int gradient_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int type);
+int gradient_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int type, struct morpho_ctx *ctx);
+int gradient_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int type, struct morpho_ctx *ctx);
+
+/* asfArbitrarySE.c */
+int asf_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan **plan, int nbrSteps, int order, struct morpho_ctx *ctx);
+
+/* rankArbitrarySE.c */
+int rank_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int rank, int outOf);
+int median_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int rank_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int rank, int outOf, struct morpho_ctx *ctx);
+int rank_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int rank, int outOf, struct morpho_ctx *ctx);
+
+/* reconstruction.c */
+int reconstructionByDilation(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int connectivity);
+int reconstructionByDilation_ctx(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int markerStride, int maskStride, int outStride, int connectivity, struct morpho_ctx *ctx);
+int reconstructionByErosion(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int connectivity);
+int reconstructionByErosion_ctx(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int markerStride, int maskStride, int outStride, int connectivity, struct morpho_ctx *ctx);
+int openingByReconstructionByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight, int connectivity);
+int openingByReconstructionByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, int connectivity, struct morpho_ctx *ctx);
+int closingByReconstructionByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight, int connectivity);
+int closingByReconstructionByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, int connectivity, struct morpho_ctx *ctx);
+int opening_by_reconstruction_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int connectivity, struct morpho_ctx *ctx);
+int closing_by_reconstruction_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int connectivity, struct morpho_ctx *ctx);
+
+/* areaOpening.c */
+struct morpho_maxtree;
+struct morpho_maxtree *morpho_maxtree_create(uint8_t *imageIn, int imageWidth, int imageHeight, int inStride, int connectivity, int type);
+void morpho_maxtree_free(struct morpho_maxtree *tree);
+int morpho_maxtree_area_filter(struct morpho_maxtree *tree, uint8_t *imageOut, int outStride, int area);
+int areaOpening(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int area, int connectivity);
+int areaOpening_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity);
+int areaOpening_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity, struct morpho_ctx *ctx);
+int areaClosing(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int area, int connectivity);
+int areaClosing_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity);
+int areaClosing_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int area, int connectivity, struct morpho_ctx *ctx);
+
+/* pathOpening.c */
+int pathOpening(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int length, int graphs, int gaps);
+int pathOpening_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps);
+int pathOpening_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps, struct morpho_ctx *ctx);
+int pathClosing(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int length, int graphs, int gaps);
+int pathClosing_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps);
+int pathClosing_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps, struct morpho_ctx *ctx);
+
+/* binaryArbitrarySE.c */
+int erosion_binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int erosion_binary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx);
+int dilation_binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int dilation_binary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx);
+int opening_binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int opening_binary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx);
+int closing_binary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin);
+int closing_binary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, struct morpho_ctx *ctx);
 
 /* erosionArbitrarySF.c */
 int erosion_arbitrary_SF(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin);
+int erosion_arbitrary_SF_stride(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin);
+int erosion_arbitrary_SF_ctx(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, struct morpho_ctx *ctx);
+int erosion_arbitrary_SF_plan(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx);
+int erosion_arbitrary_SF_mt(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int nbrThreads);
 
 /* dilationArbitrarySF.c */
 int dilation_arbitrary_SF(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin);
+int dilation_arbitrary_SF_stride(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin);
+int dilation_arbitrary_SF_ctx(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, struct morpho_ctx *ctx);
+int dilation_arbitrary_SF_plan(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx);
+int dilation_arbitrary_SF_mt(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int nbrThreads);
 
 /* openingArbitrarySF.c */
 int opening_arbitrary_SF(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin);
+int opening_arbitrary_SF_stride(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin);
+int opening_arbitrary_SF_ctx(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, struct morpho_ctx *ctx);
+int opening_arbitrary_SF_plan(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx);
+int opening_arbitrary_SF_mt(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int nbrThreads);
 
 /* closingArbitrarySF.c */
 int closing_arbitrary_SF(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin);
+int closing_arbitrary_SF_stride(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin);
+int closing_arbitrary_SF_ctx(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, struct morpho_ctx *ctx);
+int closing_arbitrary_SF_plan(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx);
+int closing_arbitrary_SF_mt(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int nbrThreads);
+
+/* rankArbitrarySF.c */
+int rank_arbitrary_SF(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int rank, int outOf);
+int median_arbitrary_SF(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin);
+int rank_arbitrary_SF_ctx(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int rank, int outOf, struct morpho_ctx *ctx);
+int rank_arbitrary_SF_plan(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int rank, int outOf, struct morpho_ctx *ctx);
 
 #endif
 
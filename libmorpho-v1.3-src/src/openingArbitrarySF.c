@@ -54,24 +54,155 @@
  */
 int opening_arbitrary_SF(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin)
 {
+return opening_arbitrary_SF_stride(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, sf1, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin);
+}
+
+/*!
+ * \fn int opening_arbitrary_SF_stride(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *sf Buffer containing the shape of a structuring function. 
+ * \param[in] sfWidth Width of the stucturing function buffer
+ * \param[in] sfHeight Height of the stucturing function buffer
+ * \param[in] sfHorizontalOrigin Horizontal position of the origin in the structuring function
+ * \param[in] sfVerticalOrigin Vertical position of the origin in the structuring function
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref opening_arbitrary_SF, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ *
+ * Rows of the input and output buffers need not be contiguous, so that
+ * a region of interest of a larger frame can be processed in place.
+ */
+int opening_arbitrary_SF_stride(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin)
+{
+return opening_arbitrary_SF_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, sf1, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin, NULL);
+}
+
+/*!
+ * \fn int opening_arbitrary_SF_ctx(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *sf Buffer containing the shape of a structuring function. 
+ * \param[in] sfWidth Width of the stucturing function buffer
+ * \param[in] sfHeight Height of the stucturing function buffer
+ * \param[in] sfHorizontalOrigin Horizontal position of the origin in the structuring function
+ * \param[in] sfVerticalOrigin Vertical position of the origin in the structuring function
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref opening_arbitrary_SF_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int opening_arbitrary_SF_ctx(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, struct morpho_ctx *ctx)
+{
 int16_t	*bloc;
 
 if (DEBUG) printf("Running opening_arbitrary_SF\n");
 
 /* Allocates a new picture */
-if ( (bloc = (int16_t *)malloc(imageWidth*imageHeight*sizeof(int16_t))) == NULL)
+if ( (bloc = (int16_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, imageWidth*imageHeight*sizeof(int16_t))) == NULL)
 	{
 	perror("Malloc");
 	return MORPHO_ERROR;
 	}
 
 /* Steps include: erosion, invert SE, and dilation */
-if (MORPHO_ERROR == erosion_arbitrary_SF( imageIn, bloc, imageWidth, imageHeight, sf1, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin) ) return MORPHO_ERROR;
+if (MORPHO_ERROR == erosion_arbitrary_SF_ctx(imageIn, bloc, imageWidth, imageHeight, inStride, imageWidth, sf1, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin, ctx) ) return MORPHO_ERROR;
 
-if (MORPHO_ERROR == dilation_arbitrary_SF(bloc, imageOut, imageWidth, imageHeight, sf1, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin) ) return MORPHO_ERROR;
+if (MORPHO_ERROR == dilation_arbitrary_SF_ctx(bloc, imageOut, imageWidth, imageHeight, imageWidth, outStride, sf1, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin, ctx) ) return MORPHO_ERROR;
 
 /* Free the data */
-free(bloc); 
+morpho_scratch_release(ctx, bloc); 
 
 return MORPHO_SUCCESS;
 }
+
+/*!
+ * \fn int opening_arbitrary_SF_plan(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image (must be the width the plan was created for)
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  plan Plan of the structuring function, created by \ref morpho_sf_plan_create
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Opening by a precomputed structuring function
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref opening_arbitrary_SF_ctx, but the analysis of the structuring 
+ * function is read from the plan instead of being computed at each call.
+ */
+int opening_arbitrary_SF_plan(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, struct morpho_ctx *ctx)
+{
+int16_t	*bloc;
+
+if (DEBUG) printf("Running opening_arbitrary_SF_plan\n");
+
+/* Allocates a new picture */
+if ( (bloc = (int16_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, imageWidth*imageHeight*sizeof(int16_t))) == NULL)
+	{
+	perror("Malloc");
+	return MORPHO_ERROR;
+	}
+
+/* Steps include: erosion and dilation */
+if (MORPHO_ERROR == erosion_arbitrary_SF_plan(imageIn, bloc, imageWidth, imageHeight, inStride, imageWidth, plan, ctx) ) return MORPHO_ERROR;
+
+if (MORPHO_ERROR == dilation_arbitrary_SF_plan(bloc, imageOut, imageWidth, imageHeight, imageWidth, outStride, plan, ctx) ) return MORPHO_ERROR;
+
+/* Free the data */
+morpho_scratch_release(ctx, bloc); 
+
+return MORPHO_SUCCESS;
+}
+
+/*!
+ * \fn int opening_arbitrary_SF_mt(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int nbrThreads)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *sf Buffer containing the shape of a structuring function. 
+ * \param[in] sfWidth Width of the stucturing function buffer
+ * \param[in] sfHeight Height of the stucturing function buffer
+ * \param[in] sfHorizontalOrigin Horizontal position of the origin in the structuring function
+ * \param[in] sfVerticalOrigin Vertical position of the origin in the structuring function
+ * \param[in]  nbrThreads Number of threads (<= 0 selects \ref morpho_get_num_threads)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Multithreaded opening by an arbitrary structuring function
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref opening_arbitrary_SF, but the rows are split into bands that are 
+ * scanned in parallel, each with a histogram of its own. The result is 
+ * identical to that of the single-threaded version.
+ */
+int opening_arbitrary_SF_mt(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf1, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int nbrThreads)
+{
+struct	morpho_ctx *ctx;
+int	ret;
+
+if ( (ctx = morpho_ctx_create(0, 0, 0, 0)) == NULL) return MORPHO_ERROR;
+morpho_ctx_set_num_threads(ctx, nbrThreads);
+ret = opening_arbitrary_SF_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, sf1, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin, ctx);
+morpho_ctx_free(ctx);
+return ret;
+}
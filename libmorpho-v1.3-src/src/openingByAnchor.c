@@ -22,7 +22,132 @@
  * \file openingByAnchor.c
  */ 
 
-#include "libmorpho.h"
+#include "anchorUtil.h"
+#include "dispatch.h"
+
+/* Opening of a single line of imageWidth pixels, computed in place. The
+ * histogram (256 values) is provided by the caller so that each thread can own
+ * its copy. */
+static void openingByAnchor_line(uint8_t *out, int imageWidth, int size, struct morpho_histogram *h)
+{
+  uint8_t *aux,*end;
+  uint8_t *outLeft,*outRight,*current,*sentinel; 
+  uint8_t min;
+
+  /* Initialisation of both extremities of a line */
+  outLeft = out;
+  outRight = outLeft+imageWidth-1;
+
+  /* Handling of both sides */
+  /* Left side */
+  while ( (outLeft < outRight) && (*outLeft >= *(outLeft+1)) )
+    { outLeft++; }
+
+  /* Right side */
+  while ( (outLeft < outRight) && (*(outRight-1) <= *outRight) )
+    { outRight--; }
+
+  /* Enters in the loop */
+startLine:
+  min = *outLeft;
+  current = outLeft+1;
+  while ((current<outRight) && (*current<=min))
+    { min=*current; outLeft++; current++; }
+  sentinel = outLeft+size;
+  if (sentinel>outRight) { goto finishLine; }
+
+  /* We ran "size" pixels ahead */ 
+  current++; 
+  while (current<sentinel)
+    {
+      if (*current<=min) /* We have found a new minimum */
+	{
+	  end = current;
+	  outLeft++; 
+	  while (outLeft < end) { *outLeft=min; outLeft++; }
+	  outLeft = current; 
+	  goto startLine; 
+	}
+      current++; 
+    }
+
+  /* We did not find a smaller value in the segment in reach
+   * of outLeft; current is the first position outside the 
+   * reach of outLeft 
+   */
+  if (*current<=min)
+    {
+      end = current;
+      outLeft++; 
+      while (outLeft < end) { *outLeft=min; outLeft++; }
+      outLeft = current;
+      goto startLine; 
+    }
+  else	/* We can not avoid computing the histogram */
+    {
+      histo_reset(h, 256);
+      outLeft++; 
+      for (aux=outLeft; aux<=current; aux++) { histo_add(h, *aux); }
+      min = histo_first(h, min+1);
+      histo_remove(h, *outLeft);
+      *outLeft = min;
+      histo_add(h, min);
+    }
+
+  /* We just follow the pixels, update the histogram and look for
+   * the minimum */
+  while (current < outRight)  
+    { 
+      current++; 
+      if (*current <= min)
+	{
+	  /* We have found a new mimum */
+	  end = current;
+	  outLeft++; 
+	  while (outLeft < end) { *outLeft=min; outLeft++; }
+	  outLeft = current; 
+	  goto startLine; 
+	}
+      else 
+	{
+	  /* Update the histogram */
+	  histo_add(h, *current);
+	  histo_remove(h, *outLeft);
+	  /* Recompute the minimum */
+	  min = histo_first(h, min);
+	  outLeft++; 
+	  histo_remove(h, *outLeft);
+	  *outLeft=min; 
+	  histo_add(h, min);
+	}
+    }
+
+  /* We have to finish the line */
+  while (outLeft < outRight)
+    {
+      histo_remove(h, *outLeft);
+      min = histo_first(h, min);
+      outLeft++; 
+      histo_remove(h, *outLeft);
+      *outLeft=min; 
+      histo_add(h, min);
+    }
+
+finishLine:
+  while (outLeft < outRight)
+    {
+      if (*outLeft<=*outRight)
+	{
+	  min=*outRight; outRight--; 
+	  if (*outRight>min) 	{ *outRight=min; }
+	}
+      else
+	{
+	  min=*outLeft; outLeft++; 
+	  if (*outLeft>min) 	{ *outLeft=min; }
+	}
+    }
+}
 
 /*!
  * \fn int openingByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
@@ -47,154 +172,140 @@ fast algorithms based on anchors</b>. <em>Journal of Mathematical Imaging and Vi
  */
 int openingByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
 {
-  uint8_t *in,*out,*aux,*end;
-  uint8_t *outLeft,*outRight,*current,*sentinel; 
-  uint8_t min;
-  int 	j,imageWidthMinus1,sizeMinus1;
-  int 	*histo,nbrBytes;
+  return openingByAnchor_1D_horizontal_stride(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, size);
+}
 
-  /* Tests */
-  if ( MORPHO_ERROR == is_size_valid_1D(size, imageWidth, "openingByAnchor_1D_horizontal", 0) ) return MORPHO_ERROR;
+/*!
+ * \fn int openingByAnchor_1D_horizontal_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref openingByAnchor_1D_horizontal, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ *
+ * Rows of the input and output buffers need not be contiguous, so that
+ * a region of interest of a larger frame can be processed in place.
+ */
+int openingByAnchor_1D_horizontal_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size)
+{
+  return openingByAnchor_1D_horizontal_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, size, NULL);
+}
 
-  in =  imageIn;
-  out = imageOut;
-  imageWidthMinus1 = imageWidth-1;
-  sizeMinus1 = size-1;
+/*!
+ * \fn int openingByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref openingByAnchor_1D_horizontal_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int openingByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+{
+  uint8_t *out;
+  int 	j,*histo;
+  struct morpho_histogram h;
 
-  /* Copy the input into the output */
-  memcpy(out, in, imageWidth*imageHeight*sizeof(uint8_t));
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(size, imageWidth, "openingByAnchor_1D_horizontal", 0) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "openingByAnchor_1D_horizontal") ) return MORPHO_ERROR;
 
   /* Initialisation of the histogram */
-  nbrBytes = 256*sizeof(int);
-  histo = (int *)malloc(nbrBytes);
+  if ((histo=(int *)morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int))) == NULL) {
+    perror("Malloc");
+    return MORPHO_ERROR;
+  }
+  histo_init(&h, histo, 0, morpho_ctx_histogram(ctx));
 
   /* Computation */
-  out = imageOut;
-
-  /* Row by row */
+  /* Row by row: copy the input into the output and work in place */
   for (j=0; j<imageHeight; j++)
     {
-      /* Initialisation of both extremities of a line */
-      outLeft = out+(j*imageWidth);
-      outRight = outLeft+imageWidthMinus1;
-
-      /* Handling of both sides */
-      /* Left side */
-      while ( (outLeft < outRight) && (*outLeft >= *(outLeft+1)) )
-	{ outLeft++; }
-
-      /* Right side */
-      while ( (outLeft < outRight) && (*(outRight-1) <= *outRight) )
-	{ outRight--; }
-
-      /* Enters in the loop */
-    startLine:
-      min = *outLeft;
-      current = outLeft+1;
-      while ((current<outRight) && (*current<=min))
-	{ min=*current; outLeft++; current++; }
-      sentinel = outLeft+size;
-      if (sentinel>outRight) { goto finishLine; }
-		
-      /* We ran "size" pixels ahead */ 
-      current++; 
-      while (current<sentinel)
-	{
-	  if (*current<=min) /* We have found a new minimum */
-	    {
-	      end = current;
-	      outLeft++; 
-	      while (outLeft < end) { *outLeft=min; outLeft++; }
-	      outLeft = current; 
-	      goto startLine; 
-	    }
-	  current++; 
-	}
-
-      /* We did not find a smaller value in the segment in reach
-       * of outLeft; current is the first position outside the 
-       * reach of outLeft 
-       */
-      if (*current<=min)
-	{
-	  end = current;
-	  outLeft++; 
-	  while (outLeft < end) { *outLeft=min; outLeft++; }
-	  outLeft = current;
-	  goto startLine; 
-	}
-      else	/* We can not avoid computing the histogram */
-	{
-	  memset(histo, 0, nbrBytes);
-	  outLeft++; 
-	  for (aux=outLeft; aux<=current; aux++) { histo[*aux]++; }
-	  min++; while (histo[min]<=0) { min++; }
-	  histo[*outLeft]--;
-	  *outLeft = min;
-	  histo[min]++;
-	}
-		
-      /* We just follow the pixels, update the histogram and look for
-       * the minimum */
-      while (current < outRight)  
-	{ 
-	  current++; 
-	  if (*current <= min)
-	    {
-	      /* We have found a new mimum */
-	      end = current;
-	      outLeft++; 
-	      while (outLeft < end) { *outLeft=min; outLeft++; }
-	      outLeft = current; 
-	      goto startLine; 
-	    }
-	  else 
-	    {
-	      /* Update the histogram */
-	      histo[*current]++;
-	      histo[*outLeft]--;
-	      /* Recompute the minimum */
-	      while (histo[min]<=0) { min++; }
-	      outLeft++; 
-	      histo[*outLeft]--;
-	      *outLeft=min; 
-	      histo[min]++;
-	    }
-	}
-   
-      /* We have to finish the line */
-      while (outLeft < outRight)
-	{
-	  histo[*outLeft]--;
-	  while (histo[min]<=0) { min++; }
-	  outLeft++; 
-	  histo[*outLeft]--;
-	  *outLeft=min; 
-	  histo[min]++;
-	}
-
-    finishLine:
-      while (outLeft < outRight)
-	{
-	  if (*outLeft<=*outRight)
-	    {
-	      min=*outRight; outRight--; 
-	      if (*outRight>min) 	{ *outRight=min; }
-	    }
-	  else
-	    {
-	      min=*outLeft; outLeft++; 
-	      if (*outLeft>min) 	{ *outLeft=min; }
-	    }
-	}
-     }
+      out = imageOut+j*outStride;
+      if (out != imageIn+j*inStride) memcpy(out, imageIn+j*inStride, imageWidth*sizeof(uint8_t));
+      openingByAnchor_line(out, imageWidth, size, &h);
+    }
 
   /* Free memory */
-  free(histo);
+  morpho_scratch_release(ctx, histo);
   if(DEBUG) printf(" finished.\n");
   return MORPHO_SUCCESS;
 }
 
+/* Processes one band of rows with a histogram of its own */
+static int openingByAnchor_band(void *arg, int band, int nbrBands)
+{
+  struct anchor_job *job = (struct anchor_job *)arg;
+  int 	histo[256];
+  struct morpho_histogram h;
+  int 	j,first,last;
+  uint8_t *out;
+
+  histo_init(&h, histo, 0, job->histogram);
+  first = morpho_band_first(job->imageHeight, band, nbrBands);
+  last = morpho_band_first(job->imageHeight, band+1, nbrBands);
+  for (j=first; j<last; j++)
+    {
+      out = job->imageOut+j*job->outStride;
+      if (out != job->imageIn+j*job->inStride) memcpy(out, job->imageIn+j*job->inStride, job->imageWidth*sizeof(uint8_t));
+      openingByAnchor_line(out, job->imageWidth, job->size, &h);
+    }
+  return MORPHO_SUCCESS;
+}
+
+/*!
+ * \fn int openingByAnchor_1D_horizontal_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int nbrThreads)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \param[in]  nbrThreads Number of threads (<= 0 selects the default given by \ref morpho_get_num_threads)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ * 
+ * \brief Multithreaded opening with an horizontal linear segment
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref openingByAnchor_1D_horizontal, but the rows are split into
+ * bands that are processed in parallel by the worker threads of the library.
+ * The result is identical to that of the single-threaded version.
+ */
+int openingByAnchor_1D_horizontal_mt(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int nbrThreads)
+{
+  struct anchor_job job;
+
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(size, imageWidth, "openingByAnchor_1D_horizontal_mt", 0) ) return MORPHO_ERROR;
+
+  job.imageIn = imageIn;
+  job.imageOut = imageOut;
+  job.imageWidth = imageWidth;
+  job.imageHeight = imageHeight;
+  job.inStride = imageWidth;
+  job.outStride = imageWidth;
+  job.size = size;
+  job.histogram = MORPHO_HISTOGRAM_LINEAR;
+
+  return morpho_run_bands(openingByAnchor_band, &job, morpho_resolve_threads(nbrThreads, imageHeight));
+}
+
 /*!
  * \fn int openingByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
  * \param[in]  *imageIn Input buffer
@@ -218,155 +329,250 @@ fast algorithms based on anchors</b>. <em>Journal of Mathematical Imaging and Vi
  */
 int openingByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
 {
-uint8_t *in,*out,*aux,*end;
-uint8_t *outUp,*outDown,*current,*sentinel; 
-uint8_t min;
-int 	j,imageJump,sizeJump,sizeMinus1;
-int 	*histo,nbrBytes;
+  return openingByAnchor_1D_vertical_stride(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, size);
+}
+
+/*!
+ * \fn int openingByAnchor_1D_vertical_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref openingByAnchor_1D_vertical, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ *
+ * Rows of the input and output buffers need not be contiguous, so that
+ * a region of interest of a larger frame can be processed in place.
+ */
+int openingByAnchor_1D_vertical_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size)
+{
+  return openingByAnchor_1D_vertical_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, size, NULL);
+}
+
+/*!
+ * \fn int openingByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref openingByAnchor_1D_vertical_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int openingByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+{
+  uint8_t *columns;
+  int 	c,x,nbrColumns;
+  int 	*histo;
+  struct morpho_histogram h;
 
-/* Tests */
+  /* Tests */
   if ( MORPHO_ERROR == is_size_valid_1D(size, imageHeight, "openingByAnchor_1D_vertical", 0) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "openingByAnchor_1D_vertical") ) return MORPHO_ERROR;
 
-in =  imageIn;
-out = imageOut;
-imageJump = imageWidth*(imageHeight-1);
-sizeMinus1 = size-1;
-sizeJump = size*imageWidth;
+  /* Initialisation of the histogram and of the column buffer */
+  histo = (int *)morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int));
+  columns = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, ANCHOR_COLUMN_BLOCK*imageHeight*sizeof(uint8_t));
+  if ( (histo == NULL) || (columns == NULL) ) {
+    perror("Malloc");
+    morpho_scratch_release(ctx, histo); morpho_scratch_release(ctx, columns);
+    return MORPHO_ERROR;
+  }
+  histo_init(&h, histo, 0, morpho_ctx_histogram(ctx));
 
-/* Copy the input into the output */
-memcpy(out, in, imageWidth*imageHeight*sizeof(uint8_t));
+  /* Computation */
+  /* Blocks of adjacent columns are copied into contiguous lines, 
+   * processed in place by the line kernel and written back */
+  for (x=0; x<imageWidth; x+=ANCHOR_COLUMN_BLOCK)
+    {
+      nbrColumns = imageWidth-x;
+      if (nbrColumns > ANCHOR_COLUMN_BLOCK) { nbrColumns = ANCHOR_COLUMN_BLOCK; }
+      anchor_gather_columns(imageIn+x, inStride, imageHeight, nbrColumns, columns);
+      for (c=0; c<nbrColumns; c++)
+	openingByAnchor_line(columns+c*imageHeight, imageHeight, size, &h);
+      anchor_scatter_columns(columns, outStride, imageHeight, nbrColumns, imageOut+x);
+    }
 
-/* Initialisation of the histogram */
-nbrBytes = 256*sizeof(int);
-histo = (int *)malloc(nbrBytes);
+  /* Free memory */
+  morpho_scratch_release(ctx, columns);
+  morpho_scratch_release(ctx, histo);
+  if(DEBUG) printf(" finished.\n");
+  return MORPHO_SUCCESS;
+}
 
-/* Computation */
-out = imageOut;
+/*!
+ * \fn int openingByAnchor_1D_oriented(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, double angle)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  size (= length in tems of pixels) of the linear structuring element
+ * \param[in]  angle Orientation of the segment, in degrees counterclockwise from the horizontal axis
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Opening with a linear segment of any orientation
+ *
+ * \ingroup libmorpho
+ *
+ * The image is scanned along the translations of the discrete (Bresenham)
+ * line of the given angle, which cover each pixel once, and each profile
+ * is processed by the anchor algorithm of \ref openingByAnchor_1D_horizontal.
+ * The segment holds size pixels of the line, counted along its axis of
+ * largest extent, and the cost per pixel does not depend on its length.
+ * Angles of 0 and 90 degrees give the horizontal and vertical operators.
+ */
+int openingByAnchor_1D_oriented(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, double angle)
+{
+  return openingByAnchor_1D_oriented_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, size, angle, NULL);
+}
 
-/* Row by row */
-for (j=0; j<imageWidth; j++)
-   {
-   /* Initialisation of both extremities of a line */
-   outUp = out+j;
-   outDown = outUp+imageJump;
+/*!
+ * \fn int openingByAnchor_1D_oriented_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, double angle, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= length in tems of pixels) of the linear structuring element
+ * \param[in]  angle Orientation of the segment, in degrees counterclockwise from the horizontal axis
+ * \param[in]  ctx Context providing the scratch memory and the number of threads (NULL for one thread)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref openingByAnchor_1D_oriented, for buffers with padded rows and with the settings of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. The profiles are split into as many bands
+ * as threads (see \ref morpho_ctx_set_num_threads). imageIn and imageOut
+ * may be the same buffer, with the same stride.
+ */
+int openingByAnchor_1D_oriented_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, double angle, struct morpho_ctx *ctx)
+{
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(size, (imageWidth > imageHeight) ? imageWidth : imageHeight, "openingByAnchor_1D_oriented", 0) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "openingByAnchor_1D_oriented") ) return MORPHO_ERROR;
+
+  /* The rows and the columns have faster operators, which do not all
+     work in place and which need a segment shorter than the row or the
+     column */
+  if (imageIn != imageOut)
+    switch (anchor_oriented_axis(angle, imageWidth, imageHeight))
+      {
+      case ANCHOR_LINE_HORIZONTAL:
+	if (size < imageWidth) { return openingByAnchor_1D_horizontal_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, size, ctx); }
+	break;
+      case ANCHOR_LINE_VERTICAL:
+	if (size < imageHeight) { return openingByAnchor_1D_vertical_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, size, ctx); }
+	break;
+      }
+
+  return anchor_oriented(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, size, angle, NULL, openingByAnchor_line, 0, ctx);
+}
 
-   /* Handling of both sides */
-        /* Left side */
-        while ( (outUp < outDown) && (*outUp >= *(outUp+imageWidth)) )
-                { outUp+=imageWidth; }
+/*!
+ * \fn int openingByAnchor_1D_oriented_bank(uint8_t *imageIn, uint8_t *imageOut, uint8_t *imageAngle, int imageWidth, int imageHeight, int size, double *angles, int nbrAngles)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[out]  *imageAngle Index, in angles, of the orientation that gave each pixel (NULL if not needed)
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  size (= length in tems of pixels) of the linear structuring elements
+ * \param[in]  *angles Orientations of the segments, in degrees counterclockwise from the horizontal axis
+ * \param[in]  nbrAngles Number of orientations (1 to 256)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Opening by the supremum of segments of several orientations
+ *
+ * \ingroup libmorpho
+ *
+ * imageOut receives the supremum over the orientations of the openings by
+ * segments of size pixels, as computed by \ref openingByAnchor_1D_oriented,
+ * and imageAngle the index of the first orientation that reaches it: the
+ * largest value of the openings, 0 where they are all equal. The openings are
+ * folded into imageOut as they are computed, so that no image is allocated
+ * per orientation.
+ */
+int openingByAnchor_1D_oriented_bank(uint8_t *imageIn, uint8_t *imageOut, uint8_t *imageAngle, int imageWidth, int imageHeight, int size, double *angles, int nbrAngles)
+{
+  return openingByAnchor_1D_oriented_bank_ctx(imageIn, imageOut, imageAngle, imageWidth, imageHeight, imageWidth, imageWidth, size, angles, nbrAngles, NULL);
+}
 
-        /* Right side */
-        while ( (outUp < outDown) && (*(outDown-imageWidth) <= *outDown) )
-                { outDown-=imageWidth; }
+/*!
+ * \fn int openingByAnchor_1D_oriented_bank_ctx(uint8_t *imageIn, uint8_t *imageOut, uint8_t *imageAngle, int imageWidth, int imageHeight, int inStride, int outStride, int size, double *angles, int nbrAngles, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[out]  *imageAngle Index, in angles, of the orientation that gave each pixel (NULL if not needed); its rows are outStride pixels apart
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffers (>= imageWidth)
+ * \param[in]  size (= length in tems of pixels) of the linear structuring elements
+ * \param[in]  *angles Orientations of the segments, in degrees counterclockwise from the horizontal axis
+ * \param[in]  nbrAngles Number of orientations (1 to 256)
+ * \param[in]  ctx Context providing the scratch memory and the number of threads (NULL for one thread)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref openingByAnchor_1D_oriented_bank, for buffers with padded rows and with the settings of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. The orientations are processed one after
+ * the other, each by as many bands of profiles as threads (see
+ * \ref morpho_ctx_set_num_threads). imageIn and imageOut may be the same
+ * buffer, with the same stride; the input is then first copied into the
+ * intermediate image of the context.
+ */
+int openingByAnchor_1D_oriented_bank_ctx(uint8_t *imageIn, uint8_t *imageOut, uint8_t *imageAngle, int imageWidth, int imageHeight, int inStride, int outStride, int size, double *angles, int nbrAngles, struct morpho_ctx *ctx)
+{
+  uint8_t *bloc;
+  char	st[200];
+  int	j,err;
 
-   /* Enters in the loop */
-startLine:
-   	min = *outUp;
-   	current = outUp+imageWidth;
-	while ((current<outDown) && (*current<=min))
-               	{ min=*current; outUp+=imageWidth; current+=imageWidth; }
-   	sentinel = outUp+sizeJump;
-   	if (sentinel>outDown) { goto finishLine; }
-		
-	/* We ran "size" pixels ahead */ 
-	current+=imageWidth; 
-	while (current<sentinel)
-		{
-		if (*current<=min) /* We have found a new minimum */
-			{
-			end = current;
-			outUp+=imageWidth; 
-			while (outUp < end) { *outUp=min; outUp+=imageWidth; }
-			outUp = current; 
-			goto startLine; 
-			}
-		current+=imageWidth; 
-		}
-
-   	/* We did not find a smaller value in the segment in reach
-	 * of outUp; current is the first position outside the 
-	 * reach of outUp 
- 	 */
-	if (*current<=min)
-		{
-		end = current;
-		outUp+=imageWidth; 
-		while (outUp < end) { *outUp=min; outUp+=imageWidth; }
-		outUp = current;
-		goto startLine; 
-		}
-	else	/* We can not avoid computing the histogram */
-		{
-		memset(histo, 0, nbrBytes);
-		outUp+=imageWidth; 
-		for (aux=outUp; aux<=current; aux+=imageWidth) { histo[*aux]++; }
-		min++; while (histo[min]<=0) { min++; }
-		histo[*outUp]--;
-		*outUp = min;
-		histo[min]++;
-		}
-		
-	/* We just follow the pixels, update the histogram and look for
-	 * the minimum */
-   	while (current < outDown)  
-		{ 
-		current+=imageWidth; 
-		if (*current <= min)
-			{
-			/* We have found a new mimum */
-			end = current;
-			outUp+=imageWidth; 
-			while (outUp < end) { *outUp=min; outUp+=imageWidth; }
-			outUp = current; 
-			goto startLine; 
-			}
-		else 
-			{
-			/* Update the histogram */
-			histo[*current]++;
-			histo[*outUp]--;
-			/* Recompute the minimum */
-			while (histo[min]<=0) { min++; }
-			outUp+=imageWidth; 
-			histo[*outUp]--;
-			*outUp=min; 
-			histo[min]++;
-			}
-		}
-   
-	/* We have to finish the line */
-	while (outUp < outDown)
-		{
-		histo[*outUp]--;
-		while (histo[min]<=0) { min++; }
-		outUp+=imageWidth; 
-		histo[*outUp]--;
-		*outUp=min; 
-		histo[min]++;
-		}
+  /* Tests */
+  if ( (nbrAngles < 1) || (nbrAngles > 256) ) {
+    snprintf(st, 200, "ERROR(openingByAnchor_1D_oriented_bank): number of orientations (=%d) should be between 1 and 256.", nbrAngles);
+    perror(st);
+    return MORPHO_ERROR;
+  }
+  if ( MORPHO_ERROR == is_size_valid_1D(size, (imageWidth > imageHeight) ? imageWidth : imageHeight, "openingByAnchor_1D_oriented_bank", 0) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "openingByAnchor_1D_oriented_bank") ) return MORPHO_ERROR;
 
-finishLine:
-		while (outUp < outDown)
-		{
-		if (*outUp<=*outDown)
-			{
-			min=*outDown; outDown-=imageWidth; 
-			if (*outDown>min) 	{ *outDown=min; }
-			}
-		else
-			{
-			min=*outUp; outUp+=imageWidth; 
-			if (*outUp>min) 	{ *outUp=min; }
-			}
-		}
-   }
-
-/* Free memory */
-free(histo);
-if(DEBUG) printf(" finished.\n");
- return MORPHO_SUCCESS;
-}
+  /* The input is read for every orientation */
+  bloc = NULL;
+  if ( (imageIn == imageOut) && (nbrAngles > 1) )
+    {
+      if ((bloc=(uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, imageWidth*imageHeight*sizeof(uint8_t))) == NULL) {
+	perror("Malloc");
+	return MORPHO_ERROR;
+      }
+      for (j=0; j<imageHeight; j++)
+	memcpy(bloc+j*imageWidth, imageIn+j*inStride, imageWidth*sizeof(uint8_t));
+      imageIn = bloc; inStride = imageWidth;
+    }
 
+  /* Computation */
+  err = anchor_oriented_bank(imageIn, imageOut, imageAngle, imageWidth, imageHeight, inStride, outStride, size, angles, nbrAngles, NULL, openingByAnchor_line, 0, ctx);
+
+  /* Free memory */
+  if (bloc != NULL) { morpho_scratch_release(ctx, bloc); }
+  if(DEBUG) printf(" finished.\n");
+  return err;
+}
 
 /*!
  * \fn int openingByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight)
@@ -392,23 +598,300 @@ fast algorithms based on anchors</b>. <em>Journal of Mathematical Imaging and Vi
  * \author      Marc Van Droogenbroeck
  */
 int openingByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight)
+{
+  return openingByAnchor_2D_stride(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, seWidth, seHeight);
+}
+
+/*!
+ * \fn int openingByAnchor_2D_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref openingByAnchor_2D, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ *
+ * Rows of the input and output buffers need not be contiguous, so that
+ * a region of interest of a larger frame can be processed in place.
+ */
+int openingByAnchor_2D_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight)
+{
+  return openingByAnchor_2D_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, seWidth, seHeight, NULL);
+}
+
+/*!
+ * \fn int openingByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref openingByAnchor_2D_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int openingByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
 {
   uint8_t	*bloc=NULL;
   int err1, err2, err3;
 
-  if ((bloc=(uint8_t*)malloc(imageWidth*imageHeight*sizeof(uint8_t))) == NULL) {
+  if ((bloc=(uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, imageWidth*imageHeight*sizeof(uint8_t))) == NULL) {
     perror("Malloc");
     return MORPHO_ERROR;
   }
 
-  err1 = erosionByAnchor_1D_horizontal(imageIn, bloc, imageWidth, imageHeight, seWidth);
-  err2 = openingByAnchor_1D_vertical(bloc, bloc, imageWidth, imageHeight, seHeight);
-  err3 = dilationByAnchor_1D_horizontal(bloc, imageOut, imageWidth, imageHeight, seWidth);
+  err1 = erosionByAnchor_1D_horizontal_ctx(imageIn, bloc, imageWidth, imageHeight, inStride, imageWidth, seWidth, ctx);
+  err2 = openingByAnchor_1D_vertical_ctx(bloc, bloc, imageWidth, imageHeight, imageWidth, imageWidth, seHeight, ctx);
+  err3 = dilationByAnchor_1D_horizontal_ctx(bloc, imageOut, imageWidth, imageHeight, imageWidth, outStride, seWidth, ctx);
 
-  free(bloc);
+  morpho_scratch_release(ctx, bloc);
 
-   if ( (MORPHO_SUCCESS == err1) && (MORPHO_SUCCESS == err2) && (MORPHO_SUCCESS == err3) )
+  if ( (MORPHO_SUCCESS == err1) && (MORPHO_SUCCESS == err2) && (MORPHO_SUCCESS == err3) )
         return MORPHO_SUCCESS;
   else  return MORPHO_ERROR;
 }
 
+/*!
+ * \fn int whiteTopHatByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ * 
+ * \brief White top-hat with an horizontal linear segment
+ * 
+ * \ingroup libmorpho
+ *
+ * Residue of the opening with an horizontal linear segment whose size is given
+ * in pixels (imageIn minus its opening), which keeps the bright structures
+ * narrower than the segment. Each row is opened in a scratch line and the
+ * difference is written straight into the output.
+ */
+int whiteTopHatByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
+{
+  return whiteTopHatByAnchor_1D_horizontal_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, size, NULL);
+}
+
+/*!
+ * \fn int whiteTopHatByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref whiteTopHatByAnchor_1D_horizontal, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. imageIn and imageOut may be the same buffer.
+ */
+int whiteTopHatByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+{
+  uint8_t *line;
+  int 	j,*histo;
+  struct morpho_histogram h;
+
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(size, imageWidth, "whiteTopHatByAnchor_1D_horizontal", 0) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "whiteTopHatByAnchor_1D_horizontal") ) return MORPHO_ERROR;
+
+  /* Initialisation of the histogram and of the line buffer */
+  histo = (int *)morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int));
+  line = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, imageWidth*sizeof(uint8_t));
+  if ( (histo == NULL) || (line == NULL) ) {
+    perror("Malloc");
+    morpho_scratch_release(ctx, histo); morpho_scratch_release(ctx, line);
+    return MORPHO_ERROR;
+  }
+  histo_init(&h, histo, 0, morpho_ctx_histogram(ctx));
+
+  /* Computation */
+  /* Row by row: opening of a copy of the row, subtracted on the fly */
+  for (j=0; j<imageHeight; j++)
+    {
+      memcpy(line, imageIn+j*inStride, imageWidth*sizeof(uint8_t));
+      openingByAnchor_line(line, imageWidth, size, &h);
+      morpho_isa->rows_sub(imageIn+j*inStride, line, imageOut+j*outStride, imageWidth);
+    }
+
+  /* Free memory */
+  morpho_scratch_release(ctx, line);
+  morpho_scratch_release(ctx, histo);
+  if(DEBUG) printf(" finished.\n");
+  return MORPHO_SUCCESS;
+}
+
+/*!
+ * \fn int whiteTopHatByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  size (= height in tems of pixels) of the linear structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ * 
+ * \brief White top-hat with a vertical linear segment
+ * 
+ * \ingroup libmorpho
+ *
+ * Same as \ref whiteTopHatByAnchor_1D_horizontal, with a vertical segment.
+ */
+int whiteTopHatByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size)
+{
+  return whiteTopHatByAnchor_1D_vertical_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, size, NULL);
+}
+
+/*!
+ * \fn int whiteTopHatByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= height in tems of pixels) of the linear structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref whiteTopHatByAnchor_1D_vertical, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. imageIn and imageOut may be the same buffer.
+ */
+int whiteTopHatByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, struct morpho_ctx *ctx)
+{
+  uint8_t *columns,*residue;
+  int 	c,x,nbrColumns;
+  int 	*histo;
+  struct morpho_histogram h;
+
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(size, imageHeight, "whiteTopHatByAnchor_1D_vertical", 0) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "whiteTopHatByAnchor_1D_vertical") ) return MORPHO_ERROR;
+
+  /* Initialisation of the histogram and of the column buffers */
+  histo = (int *)morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int));
+  columns = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, 2*ANCHOR_COLUMN_BLOCK*imageHeight*sizeof(uint8_t));
+  if ( (histo == NULL) || (columns == NULL) ) {
+    perror("Malloc");
+    morpho_scratch_release(ctx, histo); morpho_scratch_release(ctx, columns);
+    return MORPHO_ERROR;
+  }
+  histo_init(&h, histo, 0, morpho_ctx_histogram(ctx));
+  residue = columns+ANCHOR_COLUMN_BLOCK*imageHeight;
+
+  /* Computation */
+  /* Blocks of adjacent columns are copied into contiguous lines; the copy
+   * in residue is processed in place by the line kernel, replaced by its
+   * difference with the columns and written back */
+  for (x=0; x<imageWidth; x+=ANCHOR_COLUMN_BLOCK)
+    {
+      nbrColumns = imageWidth-x;
+      if (nbrColumns > ANCHOR_COLUMN_BLOCK) { nbrColumns = ANCHOR_COLUMN_BLOCK; }
+      anchor_gather_columns(imageIn+x, inStride, imageHeight, nbrColumns, columns);
+      memcpy(residue, columns, nbrColumns*imageHeight*sizeof(uint8_t));
+      for (c=0; c<nbrColumns; c++)
+	openingByAnchor_line(residue+c*imageHeight, imageHeight, size, &h);
+      morpho_isa->rows_sub(columns, residue, residue, nbrColumns*imageHeight);
+      anchor_scatter_columns(residue, outStride, imageHeight, nbrColumns, imageOut+x);
+    }
+
+  /* Free memory */
+  morpho_scratch_release(ctx, columns);
+  morpho_scratch_release(ctx, histo);
+  if(DEBUG) printf(" finished.\n");
+  return MORPHO_SUCCESS;
+}
+
+/*!
+ * \fn int whiteTopHatByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief White top-hat with a seWidth * seHeight rectangle structuring element
+ * 
+ * \ingroup libmorpho
+ *
+ * Residue of \ref openingByAnchor_2D (imageIn minus its opening). The 
+ * opening is computed as in \ref openingByAnchor_2D, except for its last 
+ * horizontal dilation, whose rows are subtracted from imageIn on the fly:
+ * the opening itself is never stored. seWidth must be odd.
+ */
+int whiteTopHatByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight)
+{
+  return whiteTopHatByAnchor_2D_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, seWidth, seHeight, NULL);
+}
+
+/*!
+ * \fn int whiteTopHatByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref whiteTopHatByAnchor_2D, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. imageIn and imageOut may be the same buffer,
+ * with the same stride.
+ */
+int whiteTopHatByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, struct morpho_ctx *ctx)
+{
+  uint8_t	*bloc=NULL;
+  int err;
+
+  /* Tests */
+  if ( MORPHO_ERROR == is_size_valid_1D(seWidth, imageWidth, "whiteTopHatByAnchor_2D", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(seHeight, imageHeight, "whiteTopHatByAnchor_2D", 0) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "whiteTopHatByAnchor_2D") ) return MORPHO_ERROR;
+
+  if ((bloc=(uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, imageWidth*imageHeight*sizeof(uint8_t))) == NULL) {
+    perror("Malloc");
+    return MORPHO_ERROR;
+  }
+
+  /* Opening up to its last pass, which reads imageIn again for the residue */
+  err = erosionByAnchor_1D_horizontal_ctx(imageIn, bloc, imageWidth, imageHeight, inStride, imageWidth, seWidth, ctx);
+  if (MORPHO_SUCCESS == err)
+    err = openingByAnchor_1D_vertical_ctx(bloc, bloc, imageWidth, imageHeight, imageWidth, imageWidth, seHeight, ctx);
+  if (MORPHO_SUCCESS == err)
+    err = anchor_residue_horizontal(bloc, imageIn, imageOut, imageWidth, imageHeight, imageWidth, inStride, outStride, seWidth, 1, ctx);
+
+  morpho_scratch_release(ctx, bloc);
+  return err;
+}
@@ -0,0 +1,530 @@
+/* LIBMORPHO
+ *
+ * pathOpening.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file pathOpening.c
+ */
+
+#include "libmorpho.h"
+#include "workspace.h"
+
+/* Largest number of gaps of a path */
+#define	PATH_MAX_GAPS	16
+
+/* States of a pixel */
+#define	PATH_REMOVED	1	/* below the current threshold */
+#define	PATH_DONE	2	/* its output value is known */
+#define	PATH_QUEUED	4
+#define	PATH_TOUCHED	8	/* its length changed at the current threshold */
+
+/* Successors of a pixel in the four adjacency graphs: the vertical graph
+ * goes down, the horizontal one right, the diagonal one up and right, and
+ * the antidiagonal one down and right */
+static const int pathSuccessors[4][3][2] =
+  {
+    { {-1,1}, {0,1}, {1,1} },
+    { {1,-1}, {1,0}, {1,1} },
+    { {1,0}, {1,-1}, {0,-1} },
+    { {1,0}, {1,1}, {0,1} }
+  };
+
+/* Path opening of an image by one adjacency graph */
+struct	path_job
+	{
+	int	imageWidth,imageHeight;
+	int	graph;			/* 0 to 3, see pathSuccessors */
+	int	length,gaps;
+	int	*sorted,*level;		/* pixels by increasing value, and start of each value */
+	uint8_t	*state;
+	unsigned short *plus,*minus;	/* gaps+1 lengths per pixel */
+	int	*next,*head;		/* queues, one per key */
+	int	*touched,nbrTouched;
+	int	*list;			/* pixels to remove */
+	};
+
+/* Key of a pixel: the successors of a pixel have larger keys */
+static inline int path_key(struct path_job *job, int x, int y)
+{
+  switch (job->graph)
+    {
+    case 0: return y;
+    case 1: return x;
+    case 2: return x-y+job->imageHeight-1;
+    }
+  return x+y;
+}
+
+/* Length of the longest path through p, which must not be removed */
+static int path_length(struct path_job *job, int p)
+{
+  unsigned short *plus,*minus;
+  int	k,best;
+
+  plus = job->plus+p*(job->gaps+1);
+  minus = job->minus+p*(job->gaps+1);
+  best = 0;
+  for (k=0; k<=job->gaps; k++)
+    {
+      if (plus[k]+minus[job->gaps-k]-1 > best) { best = plus[k]+minus[job->gaps-k]-1; }
+    }
+  return best;
+}
+
+/* Recomputes the lengths of p from those of its predecessors (forward=1)
+ * or of its successors (forward=0); returns 1 if they changed.
+ *
+ * len[k] is the length, truncated to the length of the filter, of the
+ * longest path that ends (forward) or starts at p and holds at most k
+ * removed pixels. A removed pixel only extends a path that already holds
+ * a pixel of the set, so that paths neither start nor end with a gap. */
+static int path_update(struct path_job *job, unsigned short *lengths, int p, int x, int y, int forward)
+{
+  unsigned short *len,*other;
+  int	best[PATH_MAX_GAPS+1];
+  int	i,k,qx,qy,v,changed,removed;
+
+  len = lengths+p*(job->gaps+1);
+  removed = job->state[p] & PATH_REMOVED;
+  if ( removed && (job->gaps == 0) )
+    {
+      if (len[0] == 0) { return 0; }
+      len[0] = 0;
+      return 1;
+    }
+
+  for (k=0; k<=job->gaps; k++) { best[k] = 0; }
+  for (i=0; i<3; i++)
+    {
+      qx = (forward) ? x-pathSuccessors[job->graph][i][0] : x+pathSuccessors[job->graph][i][0];
+      qy = (forward) ? y-pathSuccessors[job->graph][i][1] : y+pathSuccessors[job->graph][i][1];
+      if ( (qx < 0) || (qx >= job->imageWidth) || (qy < 0) || (qy >= job->imageHeight) ) { continue; }
+      other = lengths+(qy*job->imageWidth+qx)*(job->gaps+1);
+      for (k=0; k<=job->gaps; k++)
+	{
+	  if (other[k] > best[k]) { best[k] = other[k]; }
+	}
+    }
+
+  changed = 0;
+  for (k=0; k<=job->gaps; k++)
+    {
+      if (!removed)
+	v = best[k]+1;
+      else if ( (k > 0) && (best[k-1] > 0) )
+	v = best[k-1]+1;
+      else
+	v = 0;
+      if (v > job->length) { v = job->length; }
+      if (v != len[k]) { len[k] = v; changed = 1; }
+    }
+  return changed;
+}
+
+/* Adds p to the queue of its key */
+static void path_push(struct path_job *job, int p, int key)
+{
+  if (job->state[p] & PATH_QUEUED) { return; }
+  job->state[p] |= PATH_QUEUED;
+  job->next[p] = job->head[key];
+  job->head[key] = p;
+}
+
+/* Updates the queued pixels, by increasing keys (forward=1) or by
+ * decreasing keys, and queues the pixels that depend on those that
+ * changed; the keys of the queued pixels are between first and last */
+static void path_propagate(struct path_job *job, unsigned short *lengths, int first, int last, int forward)
+{
+  int	key,p,i,x,y,qx,qy,q,qkey;
+
+  key = (forward) ? first : last;
+  while ( (forward) ? (key <= last) : (key >= first) )
+    {
+      while ((p=job->head[key]) >= 0)
+	{
+	  job->head[key] = job->next[p];
+	  job->state[p] &= ~PATH_QUEUED;
+	  x = p%job->imageWidth; y = p/job->imageWidth;
+	  if (!path_update(job, lengths, p, x, y, forward)) { continue; }
+	  if (!(job->state[p] & PATH_TOUCHED))
+	    {
+	      job->state[p] |= PATH_TOUCHED;
+	      job->touched[job->nbrTouched++] = p;
+	    }
+	  for (i=0; i<3; i++)
+	    {
+	      qx = (forward) ? x+pathSuccessors[job->graph][i][0] : x-pathSuccessors[job->graph][i][0];
+	      qy = (forward) ? y+pathSuccessors[job->graph][i][1] : y-pathSuccessors[job->graph][i][1];
+	      if ( (qx < 0) || (qx >= job->imageWidth) || (qy < 0) || (qy >= job->imageHeight) ) { continue; }
+	      q = qy*job->imageWidth+qx;
+	      /* Without gaps, the lengths of a removed pixel stay at 0 */
+	      if ( (job->gaps == 0) && (job->state[q] & PATH_REMOVED) ) { continue; }
+	      qkey = path_key(job, qx, qy);
+	      path_push(job, q, qkey);
+	      if (qkey > last) { last = qkey; }
+	      if (qkey < first) { first = qkey; }
+	    }
+	}
+      key += (forward) ? 1 : -1;
+    }
+}
+
+/* Queues the pixels of a list and propagates their changes */
+static void path_propagate_list(struct path_job *job, unsigned short *lengths, int *list, int nbrPixels, int forward)
+{
+  int	i,p,key,first,last;
+
+  first = job->imageWidth+job->imageHeight; last = -1;
+  for (i=0; i<nbrPixels; i++)
+    {
+      p = list[i];
+      key = path_key(job, p%job->imageWidth, p/job->imageWidth);
+      path_push(job, p, key);
+      if (key < first) { first = key; }
+      if (key > last) { last = key; }
+    }
+  if (last >= 0) { path_propagate(job, lengths, first, last, forward); }
+}
+
+/* Removes the pixels of the list (the value of those that are not done
+ * yet is t) and then, until there are none, those whose longest path
+ * became shorter than the length of the filter: the latter belong to no
+ * long path for any larger threshold either, so that removing them at
+ * once only prunes the propagation. The list is overwritten. */
+static void path_remove(struct path_job *job, int *list, int nbrPixels, int t, uint8_t *out, int outStride)
+{
+  uint8_t *o;
+  int	i,p,w;
+
+  w = job->imageWidth;
+  while (nbrPixels > 0)
+    {
+      for (i=0; i<nbrPixels; i++)
+	{
+	  p = list[i];
+	  job->state[p] |= PATH_REMOVED;
+	  if (!(job->state[p] & PATH_DONE))
+	    {
+	      job->state[p] |= PATH_DONE;
+	      o = out+(p/w)*outStride+p%w;
+	      if (*o < t) { *o = t; }
+	    }
+	}
+      job->nbrTouched = 0;
+      path_propagate_list(job, job->plus, list, nbrPixels, 1);
+      path_propagate_list(job, job->minus, list, nbrPixels, 0);
+
+      nbrPixels = 0;
+      for (i=0; i<job->nbrTouched; i++)
+	{
+	  p = job->touched[i];
+	  job->state[p] &= ~PATH_TOUCHED;
+	  if ( !(job->state[p] & PATH_REMOVED) && (path_length(job, p) < job->length) ) { list[nbrPixels++] = p; }
+	}
+    }
+}
+
+/* Path opening by one graph, folded into out (rows of outStride pixels)
+ * by the maximum.
+ *
+ * The thresholds of the image are visited by increasing values, as in
+ * the algorithm of Talbot and Appleton: the pixels of the current value
+ * are removed from the set, and the decrease of the lengths of the paths
+ * is propagated from them only, in the order of the graph. A pixel gets
+ * the current value when it is removed or when its longest path becomes
+ * shorter than the length of the filter. */
+static void path_graph(struct path_job *job, uint8_t *out, int outStride)
+{
+  int	i,p,t,n,w,nbrPixels;
+
+  w = job->imageWidth;
+  n = job->imageWidth*job->imageHeight;
+  memset(job->state, 0, n*sizeof(uint8_t));
+  memset(job->plus, 0, (size_t)n*(job->gaps+1)*sizeof(unsigned short));
+  memset(job->minus, 0, (size_t)n*(job->gaps+1)*sizeof(unsigned short));
+
+  /* Lengths of the paths in the whole image */
+  job->nbrTouched = 0;
+  path_propagate_list(job, job->plus, job->sorted, n, 1);
+  path_propagate_list(job, job->minus, job->sorted, n, 0);
+  nbrPixels = 0;
+  for (i=0; i<job->nbrTouched; i++) { job->state[job->touched[i]] &= ~PATH_TOUCHED; }
+  for (p=0; p<n; p++)
+    {
+      if (path_length(job, p) < job->length) { job->list[nbrPixels++] = p; }
+    }
+  path_remove(job, job->list, nbrPixels, 0, out, outStride);
+
+  /* Removal of the pixels of value t that are still in the set */
+  for (t=0; t<255; t++)
+    {
+      nbrPixels = 0;
+      for (i=job->level[t]; i<job->level[t+1]; i++)
+	{
+	  p = job->sorted[i];
+	  if (!(job->state[p] & PATH_REMOVED)) { job->list[nbrPixels++] = p; }
+	}
+      path_remove(job, job->list, nbrPixels, t, out, outStride);
+    }
+
+  /* Pixels of value 255 whose paths are long enough */
+  for (p=0; p<n; p++)
+    {
+      if (!(job->state[p] & PATH_DONE)) { out[(p/w)*outStride+p%w] = 255; }
+    }
+}
+
+/* Path opening (inv=0) or closing (inv=255), computed on the complemented
+ * image for the closing */
+static int path_filter(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps, uint8_t inv, struct morpho_ctx *ctx)
+{
+  struct path_job job;
+  char	st[200];
+  int	histo[257];
+  uint8_t *value;
+  int	*memory;
+  size_t size;
+  int	i,n,x,y,p;
+
+  /* Tests */
+  if ( (length < 2) || (length > 65534) || (graphs < 1) || (graphs > MORPHO_PATH_ALL) || (gaps < 0) || (gaps > PATH_MAX_GAPS) ) {
+    snprintf(st, 200, "ERROR(path_filter): invalid length (=%d), graphs (=%d) or number of gaps (=%d).", length, graphs, gaps);
+    perror(st);
+    return MORPHO_ERROR;
+  }
+  if ( (imageWidth < 1) || (imageHeight < 1) ) {
+    perror("ERROR(path_filter): invalid image");
+    return MORPHO_ERROR;
+  }
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "path_filter") ) return MORPHO_ERROR;
+
+  n = imageWidth*imageHeight;
+  job.imageWidth = imageWidth;
+  job.imageHeight = imageHeight;
+  job.length = length;
+  job.gaps = gaps;
+  job.level = histo;
+
+  /* Sorted pixels, queues, touched pixels, pixels to remove and heads of
+     the queues, then the lengths, the states and the values */
+  size = ((size_t)4*n+imageWidth+imageHeight)*sizeof(int)
+    +(size_t)2*n*(gaps+1)*sizeof(unsigned short)+(size_t)2*n*sizeof(uint8_t);
+  if ((memory=(int *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, size)) == NULL) {
+    perror("Malloc");
+    return MORPHO_ERROR;
+  }
+  job.sorted = memory;
+  job.next = memory+n;
+  job.touched = memory+2*(size_t)n;
+  job.list = memory+3*(size_t)n;
+  job.head = memory+4*(size_t)n;
+  job.plus = (unsigned short *)(job.head+imageWidth+imageHeight);
+  job.minus = job.plus+(size_t)n*(gaps+1);
+  job.state = (uint8_t *)(job.minus+(size_t)n*(gaps+1));
+  value = job.state+n;
+  for (i=0; i<imageWidth+imageHeight; i++) { job.head[i] = -1; }
+
+  /* Counting sort of the pixels by increasing value; the input is not
+     read anymore, so that imageOut may be imageIn */
+  memset(histo, 0, sizeof(histo));
+  for (y=0; y<imageHeight; y++)
+    for (x=0; x<imageWidth; x++)
+      {
+	value[y*imageWidth+x] = imageIn[y*inStride+x]^inv;
+	histo[value[y*imageWidth+x]+1]++;
+      }
+  for (i=1; i<=256; i++) { histo[i] += histo[i-1]; }
+  for (p=0; p<n; p++) { job.sorted[histo[value[p]]++] = p; }
+  for (i=256; i>0; i--) { histo[i] = histo[i-1]; }
+  histo[0] = 0;
+
+  /* Supremum of the openings by the graphs */
+  for (y=0; y<imageHeight; y++) { memset(imageOut+y*outStride, 0, imageWidth*sizeof(uint8_t)); }
+  for (job.graph=0; job.graph<4; job.graph++)
+    {
+      if (graphs & (1 << job.graph)) { path_graph(&job, imageOut, outStride); }
+    }
+  if (inv)
+    {
+      for (y=0; y<imageHeight; y++)
+	for (x=0; x<imageWidth; x++) { imageOut[y*outStride+x] ^= inv; }
+    }
+
+  /* Free memory */
+  morpho_scratch_release(ctx, memory);
+  if(DEBUG) printf(" finished.\n");
+  return MORPHO_SUCCESS;
+}
+
+/*!
+ * \fn int pathOpening(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int length, int graphs, int gaps)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be imageIn)
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  length Smallest length (in pixels) of the bright paths that are kept (2 to 65534)
+ * \param[in]  graphs Adjacency graphs of the paths: MORPHO_PATH_ALL or a combination of MORPHO_PATH_VERTICAL, MORPHO_PATH_HORIZONTAL, MORPHO_PATH_DIAGONAL and MORPHO_PATH_ANTIDIAGONAL
+ * \param[in]  gaps Number of pixels of a path that may be below the threshold (0 to 16)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Path opening
+ *
+ * \ingroup libmorpho
+ *
+ * A path of the vertical graph goes from a pixel to one of the three
+ * pixels below it, so that it may bend by up to 45 degrees at each step;
+ * the horizontal graph goes right, and the diagonal (antidiagonal) one
+ * goes right, up (down) or both. For every threshold of the image, the
+ * pixels that belong to no path of at least length pixels of one of the
+ * graphs are removed: this is the supremum of the openings by all these
+ * paths, which keeps thin and curved bright structures that no segment
+ * fits in. For full technical details, see
+ * - H. Talbot and B. Appleton. <b>Efficient complete and incomplete path
+ * openings and closings</b>. <em>Image and Vision Computing</em>, 25(4):416-425, April 2007.
+ *
+ * With gaps > 0, a path may hold up to gaps pixels below the threshold
+ * (but neither as first nor as last pixel), which makes the filter robust
+ * to the noise along the structures; the result is then no longer
+ * idempotent. The lengths are propagated from the pixels that cross each
+ * threshold only and are truncated to length, and the scratch memory is
+ * about 4*gaps+22 bytes per pixel.
+ */
+int pathOpening(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int length, int graphs, int gaps)
+{
+  return pathOpening_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, length, graphs, gaps, NULL);
+}
+
+/*!
+ * \fn int pathOpening_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be imageIn)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  length Smallest length (in pixels) of the bright paths that are kept (2 to 65534)
+ * \param[in]  graphs Adjacency graphs of the paths (see \ref pathOpening)
+ * \param[in]  gaps Number of pixels of a path that may be below the threshold (0 to 16)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref pathOpening, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ */
+int pathOpening_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps)
+{
+  return pathOpening_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, length, graphs, gaps, NULL);
+}
+
+/*!
+ * \fn int pathOpening_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be imageIn)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  length Smallest length (in pixels) of the bright paths that are kept (2 to 65534)
+ * \param[in]  graphs Adjacency graphs of the paths (see \ref pathOpening)
+ * \param[in]  gaps Number of pixels of a path that may be below the threshold (0 to 16)
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref pathOpening_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. The scratch memory depends on gaps (see
+ * \ref pathOpening) and is kept by the context for the next calls.
+ */
+int pathOpening_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps, struct morpho_ctx *ctx)
+{
+  return path_filter(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, length, graphs, gaps, 0, ctx);
+}
+
+/*!
+ * \fn int pathClosing(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int length, int graphs, int gaps)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be imageIn)
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  length Smallest length (in pixels) of the dark paths that are kept (2 to 65534)
+ * \param[in]  graphs Adjacency graphs of the paths (see \ref pathOpening)
+ * \param[in]  gaps Number of pixels of a path that may be above the threshold (0 to 16)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Path closing
+ *
+ * \ingroup libmorpho
+ *
+ * Dual of \ref pathOpening: fills the dark structures that hold no path
+ * of length pixels.
+ */
+int pathClosing(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int length, int graphs, int gaps)
+{
+  return pathClosing_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, length, graphs, gaps, NULL);
+}
+
+/*!
+ * \fn int pathClosing_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be imageIn)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  length Smallest length (in pixels) of the dark paths that are kept (2 to 65534)
+ * \param[in]  graphs Adjacency graphs of the paths (see \ref pathOpening)
+ * \param[in]  gaps Number of pixels of a path that may be above the threshold (0 to 16)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref pathClosing, for buffers with padded rows
+ *
+ * \ingroup libmorpho
+ */
+int pathClosing_stride(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps)
+{
+  return pathClosing_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, length, graphs, gaps, NULL);
+}
+
+/*!
+ * \fn int pathClosing_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (may be imageIn)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  length Smallest length (in pixels) of the dark paths that are kept (2 to 65534)
+ * \param[in]  graphs Adjacency graphs of the paths (see \ref pathOpening)
+ * \param[in]  gaps Number of pixels of a path that may be above the threshold (0 to 16)
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref pathClosing_stride, with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. The scratch memory depends on gaps (see
+ * \ref pathOpening) and is kept by the context for the next calls.
+ */
+int pathClosing_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int length, int graphs, int gaps, struct morpho_ctx *ctx)
+{
+  return path_filter(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, length, graphs, gaps, 255, ctx);
+}
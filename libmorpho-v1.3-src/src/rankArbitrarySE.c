@@ -0,0 +1,294 @@
+/* LIBMORPHO
+ *
+ * rankArbitrarySE.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file rankArbitrarySE.c
+ */ 
+
+#include "arbitraryUtil.h"
+
+/*!
+ * \fn int rank_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int rank, int outOf)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element (position 0 is the first pixel on the left). se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element (position 0 is the first pixel on the top). se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \param[in]  rank Position of the value in the sorted window, from 0 (minimum) to outOf (maximum)
+ * \param[in]  outOf Scale of rank (> 0)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Rank filter by an arbitrary structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Each pixel receives the value found at the position rank/outOf of the 
+ * sorted values of the window of \ref erosion_arbitrary_SE: with n points 
+ * of the window inside the image, the value of rank (rank*(n-1)+outOf/2)/outOf
+ * (0 for the smallest). rank=0 gives the erosion, rank=outOf the maximum 
+ * of the window, rank=p and outOf=100 the percentile p, rank=1 and outOf=2 
+ * the median (see \ref median_arbitrary_SE), and rank=k and outOf=N-1 the 
+ * value of rank k of a structuring element of N points.
+ *
+ * The histogram of the window is updated by the fronts of the structuring 
+ * element, as for the erosion, and the ranked value is tracked from one 
+ * pixel to the next instead of being searched from an end of the histogram.
+ */
+int rank_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int rank, int outOf)
+{
+return rank_arbitrary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, rank, outOf, NULL);
+}
+
+/*!
+ * \fn int median_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Median filter by an arbitrary structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref rank_arbitrary_SE with rank=1 and outOf=2; for an even
+ * number of points, the larger of the two middle values is taken.
+ */
+int median_arbitrary_SE(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin)
+{
+return rank_arbitrary_SE_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, 1, 2, NULL);
+}
+
+/*!
+ * \fn int rank_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int rank, int outOf, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element
+ * \param[in]  rank Position of the value in the sorted window, from 0 (minimum) to outOf (maximum)
+ * \param[in]  outOf Scale of rank (> 0)
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref rank_arbitrary_SE, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int rank_arbitrary_SE_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int rank, int outOf, struct morpho_ctx *ctx)
+{
+struct	morpho_se_plan plan;
+struct	front_store store;
+void	*planBuffer;
+size_t	size;
+int	ret;
+
+/* Analysis of the structuring element, in the scratch memory */
+size = se_plan_size(seWidth, seHeight, PLAN_EROSION);
+if ( (planBuffer = morpho_scratch(ctx, MORPHO_SLOT_FRONTS, size)) == NULL)
+	{ perror("Malloc"); return MORPHO_ERROR; }
+store.next = (char *)planBuffer;
+store.end = store.next+size;
+if ( MORPHO_SUCCESS != se_plan_init(&plan, se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, imageWidth, 0, PLAN_EROSION, &store) )
+	{
+	perror("ERROR(rank_arbitrary_SE): analyse_b did not return a valid code");
+	morpho_scratch_release(ctx, planBuffer);
+	return MORPHO_ERROR;
+	}
+
+ret = rank_arbitrary_SE_plan(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, &plan, rank, outOf, ctx);
+
+morpho_scratch_release(ctx, planBuffer);
+return ret;
+}
+
+/*!
+ * \fn int rank_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int rank, int outOf, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image (must be the width the plan was created for)
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  plan Plan of the structuring element, created by \ref morpho_se_plan_create
+ * \param[in]  rank Position of the value in the sorted window, from 0 (minimum) to outOf (maximum)
+ * \param[in]  outOf Scale of rank (> 0)
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Rank filter by a precomputed structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref rank_arbitrary_SE_ctx, but the analysis of the structuring 
+ * element is read from the plan instead of being computed at each call.
+ */
+int rank_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int rank, int outOf, struct morpho_ctx *ctx)
+{
+char st[200];
+
+int	ret;
+
+/* Test the compatibility */
+if ( (outOf < 1) || (rank < 0) || (rank > outOf) )
+	{
+	snprintf(st, 200, "ERROR(%s): rank(=%d) should be between 0 and outOf(=%d).", "rank_arbitrary_SE", rank, outOf);
+	perror(st);
+	return MORPHO_ERROR;
+	}
+if ( MORPHO_ERROR == is_plan_valid(plan, 0, imageWidth, PLAN_EROSION, "rank_arbitrary_SE") ) return MORPHO_ERROR;
+
+if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "rank_arbitrary_SE") ) return MORPHO_ERROR;
+
+if (imageWidth <= plan->seWidth) 
+	{ 
+	snprintf(st, 200, "ERROR(%s): size(=%d) of the structuring elements should be larger than the image one(=%d).", "rank_arbitrary_SE", plan->seWidth, imageWidth);        
+	perror(st);
+        return MORPHO_ERROR;
+        }
+
+if (imageHeight <= plan->seHeight) 
+	{ 
+	snprintf(st, 200, "ERROR(%s): size(=%d) of the structuring elements should be larger than the image one(=%d).", "rank_arbitrary_SE", plan->seHeight, imageHeight);        
+	perror(st);
+        return MORPHO_ERROR;
+        }
+
+/* The input image is read in place */
+ret = rank_run(imageIn,inStride, imageOut,imageWidth,imageHeight,outStride, plan, rank, outOf, ctx);
+
+if ( MORPHO_SUCCESS != ret)
+	{
+	perror("ERROR(rank_arbitrary_SE): rank_run did not return a valid code");
+	return MORPHO_ERROR;
+	}
+
+return MORPHO_SUCCESS;
+}
+
+/*************************************************************/
+/* Rank filter procedure: same scan as erosion_volume. The   */
+/* border of src is LARGEST_UINT8, which is never smaller    */
+/* than a value of the image, so that the value of rank k of */
+/* the n points of the window inside the image is that of    */
+/* the whole window (k < n). n is given by sat, the summed   */
+/* area table of se, (bh+1)*(bv+1) values. The ranked value  */
+/* is cur, below being the number of values smaller than cur.*/
+/* ATTENTION: sizeof(in) != sizeof(out) 		     */
+/*************************************************************/
+int rank_volume(	struct volume_src *src,
+		uint8_t *out, int imageWidth, int imageHeight, int outStride,
+		uint8_t *se, int bh, int bv, int *sat,
+		struct front *l, struct front *r, 
+		int ox,int oy, int lineFirst, int lineLast, int histogram, int rank, int outOf)
+{
+uint8_t	*corner,val;
+int	i,space[256],col,*pos,line,lx,n,x,y,k,cur,below,total,inside;
+int	i0,i1,j0,j1;
+uint8_t	*data;
+int	*lpos,*rpos,s,nbrSegments,dir,nbrIn,nbrOut;
+struct	scan_segment seg[3];
+struct	morpho_histogram h;
+
+
+/* Build the first histogram */
+histo_init(&h, space, 0, histogram);
+histo_reset(&h, 256);
+for (i=0;i<bh*bv;i++)
+   if (se[i] != 0)	
+	histo_add(&h, LARGEST_UINT8);
+cur=LARGEST_UINT8;
+below=0;
+total=sat[bh+bv*(bh+1)];
+
+for (line=lineFirst;line<lineLast;line++)
+  {
+  dir = (line%2 == 0) ? 1 : -1;
+  nbrSegments = scan_segments(src, line, seg);
+  for (s=0;s<nbrSegments;s++)
+    {
+    data = (uint8_t *)seg[s].region->data; lx = seg[s].lx;
+    /* The entering front is r from left to right, l from right to left */
+    lpos = (dir > 0) ? seg[s].region->lpos : seg[s].region->rpos; 
+    rpos = (dir > 0) ? seg[s].region->rpos : seg[s].region->lpos;
+    nbrOut = (dir > 0) ? l->size : r->size;
+    nbrIn = (dir > 0) ? r->size : l->size;
+    for (col=seg[s].first;col!=seg[s].last;col+=dir)
+	{
+	corner = &data[col+lx];
+	/* Updates the histogram */
+	/* 1. Adding "flat" pixels */
+ 	   pos=rpos; 
+   	   for (n=0;n<nbrIn;n++)
+		{
+		val = *(corner+((*pos)+dir));
+		histo_add(&h, val);
+		if (val < cur) below++;
+		pos++; 
+		}
+	/* 3. Removing "flat" pixels */
+ 	   pos=lpos; 
+   	   for (n=0;n<nbrOut;n++)   
+		{
+		val = *(corner+*pos);
+		histo_remove(&h, val);
+		if (val < cur) below--;
+		pos++;
+		}
+	/* Puts the value in the picture */
+	x = col+dir-bh+ox;
+	y = line-bv+oy;
+	if ( (x>=0) && (x<imageWidth) && (y>=0) && (y<imageHeight) )
+		{
+		/* Number of points of the window inside the image */
+		inside = total;
+		if ( (x < ox) || (y < oy) || (x+bh-ox > imageWidth) || (y+bv-oy > imageHeight) )
+			{
+			i0 = (ox-x > 0) ? ox-x : 0; i1 = (ox-x+imageWidth < bh) ? ox-x+imageWidth : bh;
+			j0 = (oy-y > 0) ? oy-y : 0; j1 = (oy-y+imageHeight < bv) ? oy-y+imageHeight : bv;
+			inside = sat[i1+j1*(bh+1)]-sat[i0+j1*(bh+1)]-sat[i1+j0*(bh+1)]+sat[i0+j0*(bh+1)];
+			}
+		k = (int)(((long long)rank*(inside-1)+outOf/2)/outOf);
+		cur = histo_rank(&h, cur, &below, k);
+		out[x+y*outStride] = (uint8_t)cur;
+		}
+	}
+    }
+  }
+
+return MORPHO_SUCCESS;
+}
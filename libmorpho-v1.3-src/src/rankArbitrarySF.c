@@ -0,0 +1,311 @@
+/* LIBMORPHO
+ *
+ * rankArbitrarySF.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file rankArbitrarySF.c
+ */ 
+
+#include "arbitraryUtil.h"
+
+/*!
+ * \fn int rank_arbitrary_SF(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int rank, int outOf)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *sf Buffer containing the shape of a structuring function. 
+ * \param[in] sfWidth Width of the stucturing function buffer
+ * \param[in] sfHeight Height of the stucturing function buffer
+ * \param[in] sfHorizontalOrigin Horizontal position of the origin in the structuring function (position 0 is the first pixel on the left). sf[sfHorizontalOrigin, sfVerticalOrigin] must be !=0.
+ * \param[in] sfVerticalOrigin Vertical position of the origin in the structuring function (position 0 is the first pixel on the top). sf[sfHorizontalOrigin, sfVerticalOrigin] must be !=0.
+ * \param[in]  rank Position of the value in the sorted window, from 0 (minimum) to outOf (maximum)
+ * \param[in]  outOf Scale of rank (> 0)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Rank filter by an arbitrary structuring function
+ *
+ * \ingroup libmorpho
+ *
+ * Each pixel receives the value found at the position rank/outOf of the 
+ * sorted values of the window of \ref erosion_arbitrary_SF, that is of the
+ * values of the image minus the structuring function, with the convention
+ * of \ref rank_arbitrary_SE for the rank. rank=0 gives the erosion; with a
+ * flat structuring function (all its points equal to 1), the rank filter
+ * of the image by its support.
+ * 
+ * \warning All pixels of the input image should => -255 and <= 510: -255 <= imageIn[.] <= 510. 
+ * To avoid any computation overhead the function does not check that the input image 
+ * is compliant to this rule. 
+ */
+int rank_arbitrary_SF(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int rank, int outOf)
+{
+return rank_arbitrary_SF_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, sf, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin, rank, outOf, NULL);
+}
+
+/*!
+ * \fn int median_arbitrary_SF(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in] *sf Buffer containing the shape of a structuring function. 
+ * \param[in] sfWidth Width of the stucturing function buffer
+ * \param[in] sfHeight Height of the stucturing function buffer
+ * \param[in] sfHorizontalOrigin Horizontal position of the origin in the structuring function
+ * \param[in] sfVerticalOrigin Vertical position of the origin in the structuring function
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Median filter by an arbitrary structuring function
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref rank_arbitrary_SF with rank=1 and outOf=2.
+ */
+int median_arbitrary_SF(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin)
+{
+return rank_arbitrary_SF_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, sf, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin, 1, 2, NULL);
+}
+
+/*!
+ * \fn int rank_arbitrary_SF_ctx(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int rank, int outOf, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in] *sf Buffer containing the shape of a structuring function. 
+ * \param[in] sfWidth Width of the stucturing function buffer
+ * \param[in] sfHeight Height of the stucturing function buffer
+ * \param[in] sfHorizontalOrigin Horizontal position of the origin in the structuring function
+ * \param[in] sfVerticalOrigin Vertical position of the origin in the structuring function
+ * \param[in]  rank Position of the value in the sorted window, from 0 (minimum) to outOf (maximum)
+ * \param[in]  outOf Scale of rank (> 0)
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref rank_arbitrary_SF, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int rank_arbitrary_SF_ctx(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int rank, int outOf, struct morpho_ctx *ctx)
+{
+struct	morpho_se_plan plan;
+struct	front_store store;
+void	*planBuffer;
+size_t	size;
+int	ret;
+
+/* Analysis of the structuring function, in the scratch memory */
+size = se_plan_size(sfWidth, sfHeight, PLAN_EROSION);
+if ( (planBuffer = morpho_scratch(ctx, MORPHO_SLOT_FRONTS, size)) == NULL)
+	{ perror("Malloc"); return MORPHO_ERROR; }
+store.next = (char *)planBuffer;
+store.end = store.next+size;
+if ( MORPHO_SUCCESS != se_plan_init(&plan, sf, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin, imageWidth, 1, PLAN_EROSION, &store) )
+	{
+	perror("ERROR(rank_arbitrary_SF): analyse_b_gray did not return a valid code");
+	morpho_scratch_release(ctx, planBuffer);
+	return MORPHO_ERROR;
+	}
+
+ret = rank_arbitrary_SF_plan(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, &plan, rank, outOf, ctx);
+
+morpho_scratch_release(ctx, planBuffer);
+return ret;
+}
+
+/*!
+ * \fn int rank_arbitrary_SF_plan(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int rank, int outOf, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image (must be the width the plan was created for)
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  plan Plan of the structuring function, created by \ref morpho_sf_plan_create
+ * \param[in]  rank Position of the value in the sorted window, from 0 (minimum) to outOf (maximum)
+ * \param[in]  outOf Scale of rank (> 0)
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Rank filter by a precomputed structuring function
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref rank_arbitrary_SF_ctx, but the analysis of the structuring 
+ * function is read from the plan instead of being computed at each call.
+ */
+int rank_arbitrary_SF_plan(int16_t *imageIn, int16_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int rank, int outOf, struct morpho_ctx *ctx)
+{
+char st[200];
+
+int	ret;
+
+/* Test the compatibility */
+if ( (outOf < 1) || (rank < 0) || (rank > outOf) )
+	{
+	snprintf(st, 200, "ERROR(%s): rank(=%d) should be between 0 and outOf(=%d).", "rank_arbitrary_SF", rank, outOf);
+	perror(st);
+	return MORPHO_ERROR;
+	}
+if ( MORPHO_ERROR == is_plan_valid(plan, 1, imageWidth, PLAN_EROSION, "rank_arbitrary_SF") ) return MORPHO_ERROR;
+
+if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "rank_arbitrary_SF") ) return MORPHO_ERROR;
+
+if (imageWidth <= plan->seWidth) 
+	{ 
+	snprintf(st, 200, "ERROR(%s): size(=%d) of the structuring function should be larger than the image one(=%d).", "rank_arbitrary_SF", plan->seWidth, imageWidth);        
+	perror(st);
+        return MORPHO_ERROR;
+        }
+
+if (imageHeight <= plan->seHeight) 
+	{ 
+	snprintf(st, 200, "ERROR(%s): size(=%d) of the structuring function should be larger than the image one(=%d).", "rank_arbitrary_SF", plan->seHeight, imageHeight);        
+	perror(st);
+        return MORPHO_ERROR;
+        }
+
+/* The input image is read in place */
+ret = rank_run(imageIn,inStride, imageOut,imageWidth,imageHeight,outStride, plan, rank, outOf, ctx);
+
+if ( MORPHO_SUCCESS != ret)
+	{
+	perror("ERROR(rank_arbitrary_SF): rank_run did not return a valid code");
+	return MORPHO_ERROR;
+	}
+
+return MORPHO_SUCCESS;
+}
+
+/*************************************************************/
+/* Rank filter procedure: same scan as erosion_volume_gray.  */
+/* The border of src is RANK_BORDER_VAL, so that the values  */
+/* it gives are larger than all the values of the image      */
+/* minus sf; the rank is then computed as in rank_volume.    */
+/* The histogram spans RANK_SMALLEST_VAL..RANK_BORDER_VAL,   */
+/* which is beyond the bitmap: it is always linear.          */
+/* ATTENTION: sizeof(in) != sizeof(out) 		     */
+/*************************************************************/
+int rank_volume_gray( struct volume_src *src,
+		int16_t *out, int imageWidth, int imageHeight, int outStride,
+		uint8_t *sf, int bh, int bv, int *sat,
+		struct front *l, struct front *r, struct gfront *gl, struct gfront *gr,
+		int ox,int oy, int lineFirst, int lineLast, int rank, int outOf)
+{
+int16_t	*corner,val;
+uint8_t *value,*av,*ap;
+int	i,space[RANK_BORDER_VAL+1-RANK_SMALLEST_VAL],col,*pos,line,lx,n,x,y,k,cur,below,total,inside;
+int	i0,i1,j0,j1;
+int16_t	*data;
+int	*lpos,*rpos,*gpos,s,nbrSegments,dir,nbrIn,nbrOut,nbrGrey;
+struct	front *fin,*fout;
+struct	gfront *g;
+struct	scan_segment seg[3];
+struct	morpho_histogram h;
+
+
+/* Build the first histogram */
+histo_init(&h, space-RANK_SMALLEST_VAL, RANK_SMALLEST_VAL, MORPHO_HISTOGRAM_LINEAR);
+histo_reset(&h, RANK_BORDER_VAL+1-RANK_SMALLEST_VAL);
+for (i=0;i<bh*bv;i++)
+   if (sf[i] != 0)	
+	histo_add(&h, RANK_BORDER_VAL-sf[i]+GREY_OFFSET);
+cur=histo_first(&h, RANK_SMALLEST_VAL);
+below=0;
+total=sat[bh+bv*(bh+1)];
+
+for (line=lineFirst;line<lineLast;line++)
+  {
+  dir = (line%2 == 0) ? 1 : -1;
+  nbrSegments = scan_segments(src, line, seg);
+  for (s=0;s<nbrSegments;s++)
+    {
+    data = (int16_t *)seg[s].region->data; lx = seg[s].lx;
+    /* The entering front is r from left to right, l from right to left */
+    lpos = (dir > 0) ? seg[s].region->lpos : seg[s].region->rpos; 
+    rpos = (dir > 0) ? seg[s].region->rpos : seg[s].region->lpos;
+    gpos = (dir > 0) ? seg[s].region->grpos : seg[s].region->glpos;
+    fin = (dir > 0) ? r : l;
+    fout = (dir > 0) ? l : r;
+    g = (dir > 0) ? gr : gl;
+    nbrOut = fout->size;
+    nbrIn = fin->size;
+    nbrGrey = g->size;
+    for (col=seg[s].first;col!=seg[s].last;col+=dir)
+	{
+	corner = &data[col+lx];
+	/* Updates the histogram */
+	/* 1. Adding "flat" pixels */
+ 	   pos=rpos; value=fin->value;
+   	   for (n=0;n<nbrIn;n++)
+		{
+		val = *(corner+((*pos)+dir)) - *value;
+		histo_add(&h, val);
+		if (val < cur) below++;
+		pos++; value++;
+		}
+	/* 2. Adding and removing "grey" pixels */
+	   pos=gpos; ap=g->ap; av=g->av;
+   	   for (n=0;n<nbrGrey;n++)
+		{
+		val = *(corner+*pos) - *ap;
+		histo_add(&h, val);
+		if (val < cur) below++;
+		val = *(corner+*pos) - *av;
+		histo_remove(&h, val);
+		if (val < cur) below--;
+		pos++; ap++; av++;
+		}
+	/* 3. Removing "flat" pixels */
+ 	   pos=lpos; value=fout->value;
+   	   for (n=0;n<nbrOut;n++)   
+		{
+		val = *(corner+*pos) - *value;
+		histo_remove(&h, val);
+		if (val < cur) below--;
+		pos++; value++;
+		}
+	/* Puts the value in the picture */
+	x = col+dir-bh+ox;
+	y = line-bv+oy;
+	if ( (x>=0) && (x<imageWidth) && (y>=0) && (y<imageHeight) )
+		{
+		/* Number of points of the window inside the image */
+		inside = total;
+		if ( (x < ox) || (y < oy) || (x+bh-ox > imageWidth) || (y+bv-oy > imageHeight) )
+			{
+			i0 = (ox-x > 0) ? ox-x : 0; i1 = (ox-x+imageWidth < bh) ? ox-x+imageWidth : bh;
+			j0 = (oy-y > 0) ? oy-y : 0; j1 = (oy-y+imageHeight < bv) ? oy-y+imageHeight : bv;
+			inside = sat[i1+j1*(bh+1)]-sat[i0+j1*(bh+1)]-sat[i1+j0*(bh+1)]+sat[i0+j0*(bh+1)];
+			}
+		k = (int)(((long long)rank*(inside-1)+outOf/2)/outOf);
+		cur = histo_rank(&h, cur, &below, k);
+		out[x+y*outStride] = (int16_t)cur;
+		}
+	}
+    }
+  }
+
+return MORPHO_SUCCESS;
+}
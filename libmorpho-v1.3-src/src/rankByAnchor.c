@@ -0,0 +1,537 @@
+/* LIBMORPHO
+ *
+ * rankByAnchor.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file rankByAnchor.c
+ */
+
+#include "anchorUtil.h"
+
+/* Number of coarse bins of the histograms of the 2D filter; coarse bin b
+   counts the values 16*b to 16*b+15 */
+#define	RANK_COARSE	16
+
+/* Description of a 2D rank filter, shared by the bands of rows */
+struct	rank_job
+	{
+	uint8_t	*imageIn,*imageOut;
+	int	imageWidth,imageHeight;
+	int	inStride,outStride;
+	int	seWidth,seHeight;
+	int	rank,outOf;
+	unsigned short *columns;	/* column histograms of all the bands */
+	};
+
+/* Rank of the value of position rank/outOf among n sorted values */
+static inline int rank_index(int n, int rank, int outOf)
+{
+  return (int)(((long long)rank*(n-1)+outOf/2)/outOf);
+}
+
+/* Checks the rank of a filter */
+static int is_rank_valid(int rank, int outOf, char *func)
+{
+  char	st[200];
+
+  if ( (outOf < 1) || (rank < 0) || (rank > outOf) ) {
+    snprintf(st, 200, "ERROR(%s): rank(=%d) should be between 0 and outOf(=%d).", func, rank, outOf);
+    perror(st);
+    return MORPHO_ERROR;
+  }
+  return MORPHO_SUCCESS;
+}
+
+/* Rank filter of a line of imageWidth pixels by a segment of size pixels
+ * (odd), clipped at both ends of the line. in and out must differ.
+ *
+ * The histogram of the window is slid as for the erosion, and the ranked
+ * value is tracked with the number of values of the window below it, so
+ * that it moves only by the distance between two consecutive results. */
+static void rankByAnchor_line(uint8_t *in, uint8_t *out, int imageWidth, int size, int rank, int outOf, struct morpho_histogram *h)
+{
+  int	x,v,half,first,last,cur,below;
+
+  half = size/2;
+  histo_reset(h, 256);
+  for (x=0; x<=half; x++) { histo_add(h, in[x]); }
+  cur = histo_first(h, 0);
+  below = 0;
+
+  for (x=0; x<imageWidth; x++)
+    {
+      if (x > 0)
+	{
+	  if (x+half < imageWidth)
+	    {
+	      v = in[x+half];
+	      histo_add(h, v);
+	      if (v < cur) { below++; }
+	    }
+	  if (x-half-1 >= 0)
+	    {
+	      v = in[x-half-1];
+	      histo_remove(h, v);
+	      if (v < cur) { below--; }
+	    }
+	}
+      first = (x-half < 0) ? 0 : x-half;
+      last = (x+half >= imageWidth) ? imageWidth-1 : x+half;
+      cur = histo_rank(h, cur, &below, rank_index(last-first+1, rank, outOf));
+      out[x] = cur;
+    }
+}
+
+/*!
+ * \fn int rankByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int rank, int outOf)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element (odd)
+ * \param[in]  rank Position of the value in the sorted window, from 0 (minimum) to outOf (maximum)
+ * \param[in]  outOf Scale of rank (> 0)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Rank filter with an horizontal linear segment
+ *
+ * \ingroup libmorpho
+ *
+ * Each pixel receives the value of rank (rank*(n-1)+outOf/2)/outOf (0 for
+ * the smallest) of the n pixels of the centered segment that lie inside
+ * the image, as \ref rank_arbitrary_SE: rank=0 gives the erosion, rank=outOf
+ * the dilation and rank=1, outOf=2 the median.
+ *
+ * The histogram of the segment is slid along the row as for
+ * \ref erosionByAnchor_1D_horizontal, and the ranked value is tracked from
+ * one pixel to the next, so that the cost per pixel does not depend on
+ * the size of the segment.
+ */
+int rankByAnchor_1D_horizontal(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int rank, int outOf)
+{
+  return rankByAnchor_1D_horizontal_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, size, rank, outOf, NULL);
+}
+
+/*!
+ * \fn int rankByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, int rank, int outOf, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= width in tems of pixels) of the linear structuring element (odd)
+ * \param[in]  rank Position of the value in the sorted window, from 0 (minimum) to outOf (maximum)
+ * \param[in]  outOf Scale of rank (> 0)
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref rankByAnchor_1D_horizontal, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. Each row is copied before being filtered, so
+ * that imageIn and imageOut may be the same buffer, with the same stride.
+ */
+int rankByAnchor_1D_horizontal_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, int rank, int outOf, struct morpho_ctx *ctx)
+{
+  uint8_t *line;
+  int 	j,*histo;
+  struct morpho_histogram h;
+
+  /* Tests */
+  if ( MORPHO_ERROR == is_rank_valid(rank, outOf, "rankByAnchor_1D_horizontal") ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(size, imageWidth, "rankByAnchor_1D_horizontal", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "rankByAnchor_1D_horizontal") ) return MORPHO_ERROR;
+
+  /* Initialisation of the histogram and of the line buffer */
+  histo = (int *)morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int));
+  line = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, imageWidth*sizeof(uint8_t));
+  if ( (histo == NULL) || (line == NULL) ) {
+    perror("Malloc");
+    morpho_scratch_release(ctx, histo); morpho_scratch_release(ctx, line);
+    return MORPHO_ERROR;
+  }
+  histo_init(&h, histo, 0, morpho_ctx_histogram(ctx));
+
+  /* Computation */
+  /* Row by row */
+  for (j=0; j<imageHeight; j++)
+    {
+      memcpy(line, imageIn+j*inStride, imageWidth*sizeof(uint8_t));
+      rankByAnchor_line(line, imageOut+j*outStride, imageWidth, size, rank, outOf, &h);
+    }
+
+  /* Free memory */
+  morpho_scratch_release(ctx, line);
+  morpho_scratch_release(ctx, histo);
+  if(DEBUG) printf(" finished.\n");
+  return MORPHO_SUCCESS;
+}
+
+/*!
+ * \fn int rankByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int rank, int outOf)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  size (= height in tems of pixels) of the linear structuring element (odd)
+ * \param[in]  rank Position of the value in the sorted window, from 0 (minimum) to outOf (maximum)
+ * \param[in]  outOf Scale of rank (> 0)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Rank filter with a vertical linear segment
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref rankByAnchor_1D_horizontal, along the columns.
+ */
+int rankByAnchor_1D_vertical(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int size, int rank, int outOf)
+{
+  return rankByAnchor_1D_vertical_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, size, rank, outOf, NULL);
+}
+
+/*!
+ * \fn int rankByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, int rank, int outOf, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  size (= height in tems of pixels) of the linear structuring element (odd)
+ * \param[in]  rank Position of the value in the sorted window, from 0 (minimum) to outOf (maximum)
+ * \param[in]  outOf Scale of rank (> 0)
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref rankByAnchor_1D_vertical, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. Blocks of adjacent columns are filtered in
+ * contiguous buffers, as for \ref erosionByAnchor_1D_vertical_ctx, so that
+ * imageIn and imageOut may be the same buffer, with the same stride.
+ */
+int rankByAnchor_1D_vertical_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int size, int rank, int outOf, struct morpho_ctx *ctx)
+{
+  uint8_t *columnsIn,*columnsOut;
+  int 	c,x,nbrColumns;
+  int 	*histo;
+  struct morpho_histogram h;
+
+  /* Tests */
+  if ( MORPHO_ERROR == is_rank_valid(rank, outOf, "rankByAnchor_1D_vertical") ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(size, imageHeight, "rankByAnchor_1D_vertical", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "rankByAnchor_1D_vertical") ) return MORPHO_ERROR;
+
+  /* Initialisation of the histogram and of the column buffers */
+  histo = (int *)morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int));
+  columnsIn = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, 2*ANCHOR_COLUMN_BLOCK*imageHeight*sizeof(uint8_t));
+  if ( (histo == NULL) || (columnsIn == NULL) ) {
+    perror("Malloc");
+    morpho_scratch_release(ctx, histo); morpho_scratch_release(ctx, columnsIn);
+    return MORPHO_ERROR;
+  }
+  histo_init(&h, histo, 0, morpho_ctx_histogram(ctx));
+  columnsOut = columnsIn+ANCHOR_COLUMN_BLOCK*imageHeight;
+
+  /* Computation */
+  for (x=0; x<imageWidth; x+=ANCHOR_COLUMN_BLOCK)
+    {
+      nbrColumns = imageWidth-x;
+      if (nbrColumns > ANCHOR_COLUMN_BLOCK) { nbrColumns = ANCHOR_COLUMN_BLOCK; }
+      anchor_gather_columns(imageIn+x, inStride, imageHeight, nbrColumns, columnsIn);
+      for (c=0; c<nbrColumns; c++)
+	rankByAnchor_line(columnsIn+c*imageHeight, columnsOut+c*imageHeight, imageHeight, size, rank, outOf, &h);
+      anchor_scatter_columns(columnsOut, outStride, imageHeight, nbrColumns, imageOut+x);
+    }
+
+  /* Free memory */
+  morpho_scratch_release(ctx, columnsIn);
+  morpho_scratch_release(ctx, histo);
+  if(DEBUG) printf(" finished.\n");
+  return MORPHO_SUCCESS;
+}
+
+/* Adds (delta=1) or removes (delta=-1) a row to the column histograms */
+static void rank_columns_update(unsigned short *fine, unsigned short *coarse, uint8_t *row, int imageWidth, int delta)
+{
+  int	x;
+
+  for (x=0; x<imageWidth; x++)
+    {
+      fine[x*256+row[x]] += delta;
+      coarse[x*RANK_COARSE+(row[x]>>4)] += delta;
+    }
+}
+
+/* Adds (delta=1) or removes (delta=-1) the columns first..last of coarse
+ * bin b to the fine bins b of the kernel histogram */
+static void rank_bucket_update(int *kernel, unsigned short *fine, int b, int first, int last, int delta)
+{
+  unsigned short *column;
+  int	x,v;
+
+  for (x=first; x<=last; x++)
+    {
+      column = fine+x*256+16*b;
+      for (v=0; v<16; v++) { kernel[v] += delta*column[v]; }
+    }
+}
+
+/* Rank filter of a band of rows by a rectangle (Perreault and Hebert).
+ *
+ * Each column has the histogram of the seHeight pixels around the current
+ * row; it is updated by one pixel removed and one pixel added when going
+ * down. The histogram of the rectangle is the sum of seWidth of them: its
+ * coarse bins are updated by one column added and one removed when going
+ * right, and its fine bins are only brought up to date, for the columns
+ * of the window, in the coarse bin where the ranked value lies. The cost
+ * per pixel therefore does not depend on the size of the rectangle. */
+static int rankByAnchor_band(void *arg, int band, int nbrBands)
+{
+  struct rank_job *job = (struct rank_job *)arg;
+  unsigned short *fine,*coarse,*column;
+  uint8_t *out;
+  int	kernelFine[256],kernelCoarse[RANK_COARSE];
+  int	from[RANK_COARSE],to[RANK_COARSE];	/* columns of the fine bins */
+  int	w,h,x,y,b,v,first,last,halfWidth,halfHeight;
+  int	x0,x1,nbrRows,k,sum;
+
+  first = morpho_band_first(job->imageHeight, band, nbrBands);
+  last = morpho_band_first(job->imageHeight, band+1, nbrBands);
+  if (first >= last) { return MORPHO_SUCCESS; }
+  w = job->imageWidth; h = job->imageHeight;
+  halfWidth = job->seWidth/2; halfHeight = job->seHeight/2;
+
+  /* Column histograms of the first row of the band */
+  fine = job->columns+(size_t)band*w*(256+RANK_COARSE);
+  coarse = fine+(size_t)w*256;
+  memset(fine, 0, (size_t)w*(256+RANK_COARSE)*sizeof(unsigned short));
+  for (y=first-halfHeight; y<=first+halfHeight; y++)
+    {
+      if ( (y >= 0) && (y < h) )
+	rank_columns_update(fine, coarse, job->imageIn+y*job->inStride, w, 1);
+    }
+
+  for (y=first; y<last; y++)
+    {
+      if (y > first)
+	{
+	  if (y-halfHeight-1 >= 0)
+	    rank_columns_update(fine, coarse, job->imageIn+(y-halfHeight-1)*job->inStride, w, -1);
+	  if (y+halfHeight < h)
+	    rank_columns_update(fine, coarse, job->imageIn+(y+halfHeight)*job->inStride, w, 1);
+	}
+      nbrRows = ( (y+halfHeight < h) ? y+halfHeight : h-1 ) - ( (y-halfHeight > 0) ? y-halfHeight : 0 ) + 1;
+
+      /* The fine bins of the kernel are empty at the start of a row */
+      memset(kernelCoarse, 0, sizeof(kernelCoarse));
+      for (b=0; b<RANK_COARSE; b++) { from[b] = 0; to[b] = -1; }
+      for (x=0; x<=halfWidth; x++)
+	{
+	  column = coarse+x*RANK_COARSE;
+	  for (b=0; b<RANK_COARSE; b++) { kernelCoarse[b] += column[b]; }
+	}
+
+      out = job->imageOut+y*job->outStride;
+      for (x=0; x<w; x++)
+	{
+	  if (x > 0)
+	    {
+	      if (x+halfWidth < w)
+		{
+		  column = coarse+(x+halfWidth)*RANK_COARSE;
+		  for (b=0; b<RANK_COARSE; b++) { kernelCoarse[b] += column[b]; }
+		}
+	      if (x-halfWidth-1 >= 0)
+		{
+		  column = coarse+(x-halfWidth-1)*RANK_COARSE;
+		  for (b=0; b<RANK_COARSE; b++) { kernelCoarse[b] -= column[b]; }
+		}
+	    }
+	  x0 = (x-halfWidth < 0) ? 0 : x-halfWidth;
+	  x1 = (x+halfWidth >= w) ? w-1 : x+halfWidth;
+	  k = rank_index(nbrRows*(x1-x0+1), job->rank, job->outOf);
+
+	  /* Coarse bin of the ranked value */
+	  for (b=0, sum=0; sum+kernelCoarse[b] <= k; b++) { sum += kernelCoarse[b]; }
+
+	  /* Its fine bins, from the columns they were last computed for */
+	  if (to[b] < x0)
+	    {
+	      memset(kernelFine+16*b, 0, 16*sizeof(int));
+	      rank_bucket_update(kernelFine+16*b, fine, b, x0, x1, 1);
+	    }
+	  else
+	    {
+	      rank_bucket_update(kernelFine+16*b, fine, b, from[b], x0-1, -1);
+	      rank_bucket_update(kernelFine+16*b, fine, b, to[b]+1, x1, 1);
+	    }
+	  from[b] = x0; to[b] = x1;
+
+	  for (v=16*b; sum+kernelFine[v] <= k; v++) { sum += kernelFine[v]; }
+	  out[x] = v;
+	}
+    }
+  return MORPHO_SUCCESS;
+}
+
+/*!
+ * \fn int rankByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight, int rank, int outOf)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element (odd)
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element (odd)
+ * \param[in]  rank Position of the value in the sorted window, from 0 (minimum) to outOf (maximum)
+ * \param[in]  outOf Scale of rank (> 0)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Rank filter with a seWidth * seHeight rectangle structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Each pixel receives the value of rank (rank*(n-1)+outOf/2)/outOf (0 for
+ * the smallest) of the n pixels of the centered rectangle that lie inside
+ * the image, as \ref rank_arbitrary_SE. Unlike the erosion, a rank filter
+ * by a rectangle is not the composition of rank filters by segments.
+ *
+ * The histograms of the columns of the rectangle are kept from one row to
+ * the next and combined into the histogram of the rectangle in two levels
+ * (16 coarse bins of 16 values), so that the cost per pixel does not
+ * depend on the size of the rectangle. For full technical details, see
+ * - S. Perreault and P. Hebert. <b>Median filtering in constant time</b>.
+ * <em>IEEE Transactions on Image Processing</em>, 16(9):2389-2394, September 2007.
+ */
+int rankByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight, int rank, int outOf)
+{
+  return rankByAnchor_2D_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, seWidth, seHeight, rank, outOf, NULL);
+}
+
+/*!
+ * \fn int medianByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element (odd)
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element (odd)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Median filter with a seWidth * seHeight rectangle structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref rankByAnchor_2D with rank=1 and outOf=2; for an even
+ * number of pixels (at the borders), the larger of the two middle values
+ * is taken.
+ */
+int medianByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight)
+{
+  return rankByAnchor_2D_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, seWidth, seHeight, 1, 2, NULL);
+}
+
+/*!
+ * \fn int rankByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, int rank, int outOf, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element (odd)
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element (odd)
+ * \param[in]  rank Position of the value in the sorted window, from 0 (minimum) to outOf (maximum)
+ * \param[in]  outOf Scale of rank (> 0)
+ * \param[in]  ctx Context providing the scratch memory and the number of threads (NULL for one thread)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref rankByAnchor_2D, for buffers with padded rows and with the settings of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. The rows are split into as many bands as
+ * threads (see \ref morpho_ctx_set_num_threads), each with column
+ * histograms of its own (512+32 bytes per column). When imageIn and
+ * imageOut overlap, the input is first copied into the intermediate image
+ * of the context.
+ */
+int rankByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, int rank, int outOf, struct morpho_ctx *ctx)
+{
+  struct rank_job job;
+  uint8_t *bloc;
+  char	st[200];
+  int	j,nbrBands,err;
+
+  /* Tests */
+  if ( MORPHO_ERROR == is_rank_valid(rank, outOf, "rankByAnchor_2D") ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(seWidth, imageWidth, "rankByAnchor_2D", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_size_valid_1D(seHeight, imageHeight, "rankByAnchor_2D", 1) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(inStride, outStride, imageWidth, "rankByAnchor_2D") ) return MORPHO_ERROR;
+  if (seHeight > 65535) {
+    /* Counts of the column histograms */
+    snprintf(st, 200, "ERROR(rankByAnchor_2D): height(=%d) of the structuring element should be smaller than 65536.", seHeight);
+    perror(st);
+    return MORPHO_ERROR;
+  }
+
+  nbrBands = morpho_resolve_threads(morpho_ctx_threads(ctx), imageHeight);
+  job.columns = (unsigned short *)morpho_scratch(ctx, MORPHO_SLOT_LINES, (size_t)nbrBands*imageWidth*(256+RANK_COARSE)*sizeof(unsigned short));
+  if (job.columns == NULL) {
+    perror("Malloc");
+    return MORPHO_ERROR;
+  }
+
+  /* The bands read rows that others may write */
+  bloc = NULL;
+  job.imageIn = imageIn; job.inStride = inStride;
+  if ( (imageIn < imageOut+(size_t)(imageHeight-1)*outStride+imageWidth)
+       && (imageOut < imageIn+(size_t)(imageHeight-1)*inStride+imageWidth) )
+    {
+      if ((bloc=(uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_IMAGE, imageWidth*imageHeight*sizeof(uint8_t))) == NULL) {
+	perror("Malloc");
+	morpho_scratch_release(ctx, job.columns);
+	return MORPHO_ERROR;
+      }
+      for (j=0; j<imageHeight; j++)
+	memcpy(bloc+j*imageWidth, imageIn+j*inStride, imageWidth*sizeof(uint8_t));
+      job.imageIn = bloc; job.inStride = imageWidth;
+    }
+
+  job.imageOut = imageOut;
+  job.imageWidth = imageWidth;
+  job.imageHeight = imageHeight;
+  job.outStride = outStride;
+  job.seWidth = seWidth;
+  job.seHeight = seHeight;
+  job.rank = rank;
+  job.outOf = outOf;
+
+  /* Computation */
+  err = morpho_run_bands(rankByAnchor_band, &job, nbrBands);
+
+  /* Free memory */
+  if (bloc != NULL) { morpho_scratch_release(ctx, bloc); }
+  morpho_scratch_release(ctx, job.columns);
+  if(DEBUG) printf(" finished.\n");
+  return err;
+}
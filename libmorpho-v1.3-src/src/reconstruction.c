@@ -0,0 +1,493 @@
+/* LIBMORPHO
+ *
+ * reconstruction.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file reconstruction.c
+ */
+
+#include "anchorUtil.h"
+#include "dispatch.h"
+
+/* FIFO of pixel offsets, in the queue slot of a context and enlarged when
+ * full */
+struct	recon_queue
+	{
+	int	*data;
+	int	size,head,count;
+	struct morpho_ctx *ctx;
+	};
+
+static int queue_push(struct recon_queue *q, int offset)
+{
+  int	*data;
+
+  if (q->count == q->size)
+    {
+      /* The elements before head are moved after the old end */
+      data = (int *)morpho_scratch_grow(q->ctx, MORPHO_SLOT_QUEUE, q->data, (size_t)2*q->size*sizeof(int));
+      if (data == NULL) { return MORPHO_ERROR; }
+      memcpy(data+q->size, data, q->head*sizeof(int));
+      q->data = data;
+      q->size *= 2;
+    }
+  q->data[(q->head+q->count)%q->size] = offset;
+  q->count++;
+  return MORPHO_SUCCESS;
+}
+
+static int queue_pop(struct recon_queue *q)
+{
+  int	offset;
+
+  offset = q->data[q->head];
+  q->head = (q->head+1)%q->size;
+  q->count--;
+  return offset;
+}
+
+/* Maximum of row and of its neighbours in the adjacent row other, for the
+ * given connectivity, into tmp */
+static void recon_neighbours(uint8_t *row, uint8_t *other, uint8_t *tmp, int imageWidth, int connectivity)
+{
+  morpho_isa->rows_max(row, other, tmp, imageWidth);
+  if (connectivity == 8)
+    {
+      morpho_isa->rows_max(tmp+1, other, tmp+1, imageWidth-1);
+      morpho_isa->rows_max(tmp, other+1, tmp, imageWidth-1);
+    }
+}
+
+/* Reconstruction by dilation of imageOut (the marker, <= mask) under mask.
+ *
+ * Both images are read through the values v^inv, so that inv=255 gives
+ * the reconstruction by erosion of the complemented images; imageOut
+ * holds complemented values during the computation. This is the hybrid
+ * algorithm of L. Vincent: a raster scan and an anti-raster scan
+ * propagate the marker in most of the image, and the pixels that may
+ * still propagate their value after the second scan go through a FIFO. */
+static int reconstruct(uint8_t *mask, int maskStride, uint8_t *imageOut, int outStride, int imageWidth, int imageHeight, int connectivity, uint8_t inv, struct morpho_ctx *ctx)
+{
+  struct recon_queue q;
+  uint8_t *row,*m,*tmp,v,vq,mq;
+  int	x,y,dx,dy,xq,yq,p,r,grow,err;
+
+  tmp = (uint8_t *)morpho_scratch(ctx, MORPHO_SLOT_LINES, imageWidth*sizeof(uint8_t));
+  q.size = imageWidth*imageHeight;
+  q.head = q.count = 0;
+  q.ctx = ctx;
+  q.data = (int *)morpho_scratch(ctx, MORPHO_SLOT_QUEUE, q.size*sizeof(int));
+  if ( (tmp == NULL) || (q.data == NULL) ) {
+    perror("Malloc");
+    morpho_scratch_release(ctx, tmp); morpho_scratch_release(ctx, q.data);
+    return MORPHO_ERROR;
+  }
+
+  /* Raster scan: upper and left neighbours */
+  for (y=0; y<imageHeight; y++)
+    {
+      row = imageOut+y*outStride;
+      m = mask+y*maskStride;
+      if (y > 0) { recon_neighbours(row, row-outStride, tmp, imageWidth, connectivity); }
+      else { memcpy(tmp, row, imageWidth*sizeof(uint8_t)); }
+      v = 0;
+      for (x=0; x<imageWidth; x++)
+	{
+	  if (tmp[x] > v) { v = tmp[x]; }
+	  if ((uint8_t)(m[x]^inv) < v) { v = m[x]^inv; }
+	  row[x] = v;
+	}
+    }
+
+  /* Anti-raster scan: lower and right neighbours. A pixel is queued when
+   * one of these neighbours is smaller and may still grow */
+  err = MORPHO_SUCCESS;
+  r = (connectivity == 8) ? 1 : 0;
+  for (y=imageHeight-1; (y>=0) && (MORPHO_SUCCESS == err); y--)
+    {
+      row = imageOut+y*outStride;
+      m = mask+y*maskStride;
+      if (y < imageHeight-1) { recon_neighbours(row, row+outStride, tmp, imageWidth, connectivity); }
+      else { memcpy(tmp, row, imageWidth*sizeof(uint8_t)); }
+      v = 0;
+      for (x=imageWidth-1; x>=0; x--)
+	{
+	  if (tmp[x] > v) { v = tmp[x]; }
+	  if ((uint8_t)(m[x]^inv) < v) { v = m[x]^inv; }
+	  row[x] = v;
+	  grow = (x+1 < imageWidth) && (row[x+1] < v) && (row[x+1] < (uint8_t)(m[x+1]^inv));
+	  for (dx=-r; (dx<=r) && !grow && (y+1 < imageHeight); dx++)
+	    {
+	      xq = x+dx;
+	      if ( (xq < 0) || (xq >= imageWidth) ) continue;
+	      vq = row[outStride+xq];
+	      grow = (vq < v) && (vq < (uint8_t)(m[maskStride+xq]^inv));
+	    }
+	  if (grow) { err = queue_push(&q, y*outStride+x); }
+	}
+    }
+
+  /* Propagation by the FIFO */
+  while ( (q.count > 0) && (MORPHO_SUCCESS == err) )
+    {
+      p = queue_pop(&q);
+      y = p/outStride; x = p%outStride;
+      v = imageOut[p];
+      for (dy=-1; dy<=1; dy++)
+	for (dx=-1; dx<=1; dx++)
+	  {
+	    if ( ((dx == 0) && (dy == 0)) || ( (connectivity == 4) && (dx != 0) && (dy != 0) ) ) continue;
+	    xq = x+dx; yq = y+dy;
+	    if ( (xq < 0) || (xq >= imageWidth) || (yq < 0) || (yq >= imageHeight) ) continue;
+	    vq = imageOut[yq*outStride+xq];
+	    mq = mask[yq*maskStride+xq]^inv;
+	    if ( (vq < v) && (vq != mq) )
+	      {
+		imageOut[yq*outStride+xq] = (v < mq) ? v : mq;
+		if (MORPHO_SUCCESS != queue_push(&q, yq*outStride+xq)) { err = MORPHO_ERROR; }
+	      }
+	  }
+    }
+
+  /* Free memory */
+  if (MORPHO_SUCCESS != err) { perror("Malloc"); }
+  morpho_scratch_release(ctx, q.data);
+  morpho_scratch_release(ctx, tmp);
+  return err;
+}
+
+/* Reconstruction by dilation (dilation=1) or by erosion (dilation=0) of 
+ * marker under (over) mask, into imageOut */
+static int reconstruction_run(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int markerStride, int maskStride, int outStride, int connectivity, int dilation, struct morpho_ctx *ctx, char *func)
+{
+  char	st[200];
+  uint8_t *row,inv;
+  int	x,y,err;
+
+  /* Tests */
+  if ( (connectivity != 4) && (connectivity != 8) ) {
+    snprintf(st, 200, "ERROR(%s): connectivity(=%d) should be 4 or 8.", func, connectivity);
+    perror(st);
+    return MORPHO_ERROR;
+  }
+  if ( (imageWidth < 1) || (imageHeight < 1) || (mask == imageOut) ) {
+    snprintf(st, 200, "ERROR(%s): invalid image size or output buffer (the output may be the marker, not the mask).", func);
+    perror(st);
+    return MORPHO_ERROR;
+  }
+  if ( MORPHO_ERROR == is_stride_valid(markerStride, outStride, imageWidth, func) ) return MORPHO_ERROR;
+  if ( MORPHO_ERROR == is_stride_valid(maskStride, outStride, imageWidth, func) ) return MORPHO_ERROR;
+
+  /* The marker is brought under (over) the mask, and complemented for a
+   * reconstruction by erosion */
+  inv = (dilation) ? 0 : 255;
+  for (y=0; y<imageHeight; y++)
+    {
+      row = imageOut+y*outStride;
+      if (dilation)
+	morpho_isa->rows_min(marker+y*markerStride, mask+y*maskStride, row, imageWidth);
+      else
+	{
+	  morpho_isa->rows_max(marker+y*markerStride, mask+y*maskStride, row, imageWidth);
+	  for (x=0; x<imageWidth; x++) { row[x] ^= inv; }
+	}
+    }
+
+  err = reconstruct(mask, maskStride, imageOut, outStride, imageWidth, imageHeight, connectivity, inv, ctx);
+
+  if (!dilation)
+    for (y=0; y<imageHeight; y++)
+      {
+	row = imageOut+y*outStride;
+	for (x=0; x<imageWidth; x++) { row[x] ^= inv; }
+      }
+  if(DEBUG) printf(" finished.\n");
+  return err;
+}
+
+/*!
+ * \fn int reconstructionByDilation(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int connectivity)
+ * \param[in]  *marker Marker image
+ * \param[in]  *mask Mask image
+ * \param[out]  *imageOut Output buffer (may be marker, but not mask)
+ * \param[in]  imageWidth Width of the image buffers
+ * \param[in]  imageHeight Height of the image buffers
+ * \param[in]  connectivity 4 or 8
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Geodesic reconstruction by dilation
+ *
+ * \ingroup libmorpho
+ *
+ * Iterates the geodesic dilation of the marker (first replaced by its 
+ * minimum with the mask) under the mask until stability, that is, keeps
+ * the parts of the mask that the marker reaches through 4- or 8-connected
+ * paths. The result is obtained in a raster scan, an anti-raster scan
+ * and a propagation by a FIFO limited to the pixels that are still
+ * changing, as in
+ * - L. Vincent. <b>Morphological grayscale reconstruction in image analysis:
+ * applications and efficient algorithms</b>. <em>IEEE Transactions on Image
+ * Processing</em>, 2(2):176-201, April 1993.
+ */
+int reconstructionByDilation(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int connectivity)
+{
+  return reconstructionByDilation_ctx(marker, mask, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, imageWidth, connectivity, NULL);
+}
+
+/*!
+ * \fn int reconstructionByDilation_ctx(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int markerStride, int maskStride, int outStride, int connectivity, struct morpho_ctx *ctx)
+ * \param[in]  *marker Marker image
+ * \param[in]  *mask Mask image
+ * \param[out]  *imageOut Output buffer (may be marker, but not mask)
+ * \param[in]  imageWidth Width of the images
+ * \param[in]  imageHeight Height of the images
+ * \param[in]  markerStride Distance, in pixels, between two rows of the marker (>= imageWidth)
+ * \param[in]  maskStride Distance, in pixels, between two rows of the mask (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  connectivity 4 or 8
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref reconstructionByDilation, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int reconstructionByDilation_ctx(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int markerStride, int maskStride, int outStride, int connectivity, struct morpho_ctx *ctx)
+{
+  return reconstruction_run(marker, mask, imageOut, imageWidth, imageHeight, markerStride, maskStride, outStride, connectivity, 1, ctx, "reconstructionByDilation");
+}
+
+/*!
+ * \fn int reconstructionByErosion(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int connectivity)
+ * \param[in]  *marker Marker image
+ * \param[in]  *mask Mask image
+ * \param[out]  *imageOut Output buffer (may be marker, but not mask)
+ * \param[in]  imageWidth Width of the image buffers
+ * \param[in]  imageHeight Height of the image buffers
+ * \param[in]  connectivity 4 or 8
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Geodesic reconstruction by erosion
+ *
+ * \ingroup libmorpho
+ *
+ * Dual of \ref reconstructionByDilation: iterates the geodesic erosion of
+ * the marker (first replaced by its maximum with the mask) over the mask 
+ * until stability.
+ */
+int reconstructionByErosion(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int connectivity)
+{
+  return reconstructionByErosion_ctx(marker, mask, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, imageWidth, connectivity, NULL);
+}
+
+/*!
+ * \fn int reconstructionByErosion_ctx(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int markerStride, int maskStride, int outStride, int connectivity, struct morpho_ctx *ctx)
+ * \param[in]  *marker Marker image
+ * \param[in]  *mask Mask image
+ * \param[out]  *imageOut Output buffer (may be marker, but not mask)
+ * \param[in]  imageWidth Width of the images
+ * \param[in]  imageHeight Height of the images
+ * \param[in]  markerStride Distance, in pixels, between two rows of the marker (>= imageWidth)
+ * \param[in]  maskStride Distance, in pixels, between two rows of the mask (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  connectivity 4 or 8
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref reconstructionByErosion, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int reconstructionByErosion_ctx(uint8_t *marker, uint8_t *mask, uint8_t *imageOut, int imageWidth, int imageHeight, int markerStride, int maskStride, int outStride, int connectivity, struct morpho_ctx *ctx)
+{
+  return reconstruction_run(marker, mask, imageOut, imageWidth, imageHeight, markerStride, maskStride, outStride, connectivity, 0, ctx, "reconstructionByErosion");
+}
+
+/*!
+ * \fn int openingByReconstructionByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight, int connectivity)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (distinct from imageIn)
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \param[in]  connectivity 4 or 8
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Opening by reconstruction with a seWidth * seHeight rectangle
+ *
+ * \ingroup libmorpho
+ *
+ * Reconstruction by dilation, under the input, of its erosion by the 
+ * rectangle (see \ref erosionByAnchor_2D): the structures in which the
+ * rectangle does not fit are removed, the others are kept with their
+ * exact shape.
+ */
+int openingByReconstructionByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight, int connectivity)
+{
+  return openingByReconstructionByAnchor_2D_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, seWidth, seHeight, connectivity, NULL);
+}
+
+/*!
+ * \fn int openingByReconstructionByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, int connectivity, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (distinct from imageIn)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \param[in]  connectivity 4 or 8
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref openingByReconstructionByAnchor_2D, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create. The erosion is written into imageOut, where
+ * it is reconstructed.
+ */
+int openingByReconstructionByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, int connectivity, struct morpho_ctx *ctx)
+{
+  if ( (imageIn == imageOut) && (NULL != imageIn) ) {
+    perror("ERROR(openingByReconstructionByAnchor_2D): the output buffer should not be the input one.");
+    return MORPHO_ERROR;
+  }
+  if ( MORPHO_ERROR == erosionByAnchor_2D_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, seWidth, seHeight, ctx) ) return MORPHO_ERROR;
+  return reconstruction_run(imageOut, imageIn, imageOut, imageWidth, imageHeight, outStride, inStride, outStride, connectivity, 1, ctx, "openingByReconstructionByAnchor_2D");
+}
+
+/*!
+ * \fn int closingByReconstructionByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight, int connectivity)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (distinct from imageIn)
+ * \param[in]  imageWidth Width of the image buffer
+ * \param[in]  imageHeight Height of the image buffer
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \param[in]  connectivity 4 or 8
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Closing by reconstruction with a seWidth * seHeight rectangle
+ *
+ * \ingroup libmorpho
+ *
+ * Dual of \ref openingByReconstructionByAnchor_2D: reconstruction by 
+ * erosion, over the input, of its dilation by the rectangle.
+ */
+int closingByReconstructionByAnchor_2D(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int seWidth, int seHeight, int connectivity)
+{
+  return closingByReconstructionByAnchor_2D_ctx(imageIn, imageOut, imageWidth, imageHeight, imageWidth, imageWidth, seWidth, seHeight, connectivity, NULL);
+}
+
+/*!
+ * \fn int closingByReconstructionByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, int connectivity, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (distinct from imageIn)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  seWidth (= width in tems of pixels) of the rectangular structuring element
+ * \param[in]  seHeight (= height in tems of pixels) of the rectangular structuring element
+ * \param[in]  connectivity 4 or 8
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Same as \ref closingByReconstructionByAnchor_2D, for buffers with padded rows and with the scratch memory of a context
+ *
+ * \ingroup libmorpho
+ *
+ * See \ref morpho_ctx_create.
+ */
+int closingByReconstructionByAnchor_2D_ctx(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, int seWidth, int seHeight, int connectivity, struct morpho_ctx *ctx)
+{
+  if ( (imageIn == imageOut) && (NULL != imageIn) ) {
+    perror("ERROR(closingByReconstructionByAnchor_2D): the output buffer should not be the input one.");
+    return MORPHO_ERROR;
+  }
+  if ( MORPHO_ERROR == dilationByAnchor_2D_ctx(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, seWidth, seHeight, ctx) ) return MORPHO_ERROR;
+  return reconstruction_run(imageOut, imageIn, imageOut, imageWidth, imageHeight, outStride, inStride, outStride, connectivity, 0, ctx, "closingByReconstructionByAnchor_2D");
+}
+
+/*!
+ * \fn int opening_by_reconstruction_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int connectivity, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (distinct from imageIn)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  plan Plan of the structuring element, built by \ref morpho_se_plan_create
+ * \param[in]  connectivity 4 or 8
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Opening by reconstruction with a precomputed structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Reconstruction by dilation, under the input, of its erosion by the 
+ * structuring element (see \ref erosion_arbitrary_SE_plan).
+ */
+int opening_by_reconstruction_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int connectivity, struct morpho_ctx *ctx)
+{
+  if ( (imageIn == imageOut) && (NULL != imageIn) ) {
+    perror("ERROR(opening_by_reconstruction_arbitrary_SE): the output buffer should not be the input one.");
+    return MORPHO_ERROR;
+  }
+  if ( MORPHO_ERROR == erosion_arbitrary_SE_plan(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, plan, ctx) ) return MORPHO_ERROR;
+  return reconstruction_run(imageOut, imageIn, imageOut, imageWidth, imageHeight, outStride, inStride, outStride, connectivity, 1, ctx, "opening_by_reconstruction_arbitrary_SE");
+}
+
+/*!
+ * \fn int closing_by_reconstruction_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int connectivity, struct morpho_ctx *ctx)
+ * \param[in]  *imageIn Input buffer
+ * \param[out]  *imageOut Output buffer (distinct from imageIn)
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  imageHeight Height of the image
+ * \param[in]  inStride Distance, in pixels, between two rows of the input buffer (>= imageWidth)
+ * \param[in]  outStride Distance, in pixels, between two rows of the output buffer (>= imageWidth)
+ * \param[in]  plan Plan of the structuring element, built by \ref morpho_se_plan_create
+ * \param[in]  connectivity 4 or 8
+ * \param[in]  ctx Context providing the scratch memory (NULL to allocate it at each call)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ *
+ * \brief Closing by reconstruction with a precomputed structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * Reconstruction by erosion, over the input, of its dilation by the 
+ * structuring element (see \ref dilation_arbitrary_SE_plan).
+ */
+int closing_by_reconstruction_arbitrary_SE_plan(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight, int inStride, int outStride, struct morpho_se_plan *plan, int connectivity, struct morpho_ctx *ctx)
+{
+  if ( (imageIn == imageOut) && (NULL != imageIn) ) {
+    perror("ERROR(closing_by_reconstruction_arbitrary_SE): the output buffer should not be the input one.");
+    return MORPHO_ERROR;
+  }
+  if ( MORPHO_ERROR == dilation_arbitrary_SE_plan(imageIn, imageOut, imageWidth, imageHeight, inStride, outStride, plan, ctx) ) return MORPHO_ERROR;
+  return reconstruction_run(imageOut, imageIn, imageOut, imageWidth, imageHeight, outStride, inStride, outStride, connectivity, 0, ctx, "closing_by_reconstruction_arbitrary_SE");
+}
@@ -0,0 +1,213 @@
+/* LIBMORPHO
+ *
+ * sePlan.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file sePlan.c
+ */ 
+
+#include "arbitraryUtil.h"
+
+/*******************************************************************/
+/* Number of bytes needed by a plan; which tells whether the fronts of
+   the erosion (PLAN_EROSION), of the dilation (PLAN_DILATION) or both 
+   are computed */
+size_t se_plan_size(int seWidth, int seHeight, int which)
+{
+size_t	size=0;
+
+if (which & PLAN_EROSION) size += fronts_size(seWidth,seHeight) + seWidth*seHeight + sizeof(double);
+if (which & PLAN_DILATION) size += fronts_size(seWidth,seHeight) + seWidth*seHeight + sizeof(double);
+return size;
+}
+
+/*******************************************************************/
+/* Analyses and transforms the fronts of se (or of its inverse) */
+static int se_fronts_init(struct se_fronts *f, uint8_t *se, int seWidth, int seHeight, 
+		int ox, int oy, int blocWidth, int gray, struct front_store *store)
+{
+f->se = se;
+f->ox = ox;
+f->oy = oy;
+if (gray)
+	{
+	if ( MORPHO_SUCCESS != analyse_b_gray(se,seWidth,seHeight, &f->l,&f->r,&f->u,&f->d, 
+				&f->gl,&f->gr,&f->gu,&f->gd, ox,oy, store) ) return MORPHO_ERROR;
+	return transform_b_gray(blocWidth, &f->l,&f->r,&f->u,&f->d, &f->gl,&f->gr,&f->gu,&f->gd, store);
+	}
+if ( MORPHO_SUCCESS != analyse_b(se,seWidth,seHeight, &f->l,&f->r,&f->u,&f->d, ox,oy, store) ) return MORPHO_ERROR;
+return transform_b(blocWidth, &f->l,&f->r,&f->u,&f->d, store);
+}
+
+/*******************************************************************/
+/* Fills a plan whose memory is taken from store, 
+   which must hold se_plan_size(seWidth,seHeight,which) bytes */
+int se_plan_init(struct morpho_se_plan *plan, uint8_t *se, int seWidth, int seHeight, 
+		int ox, int oy, int imageWidth, int gray, int which, struct front_store *store)
+{
+uint8_t	*copy;
+int	blocWidth;
+
+memset(plan, 0, sizeof(struct morpho_se_plan));
+plan->gray = gray;
+plan->seWidth = seWidth;
+plan->seHeight = seHeight;
+plan->imageWidth = imageWidth;
+blocWidth = imageWidth+seWidth*2;
+
+if (which & PLAN_EROSION)
+	{
+	if ( (copy = (uint8_t *)front_store_alloc(store, seWidth*seHeight)) == NULL) return MORPHO_ERROR;
+	memcpy(copy, se, seWidth*seHeight);
+	if ( MORPHO_SUCCESS != se_fronts_init(&plan->erosion, copy, seWidth, seHeight, 
+				ox, oy, blocWidth, gray, store) ) return MORPHO_ERROR;
+	}
+
+/* The dilation is an erosion by the inverted structuring element */
+if (which & PLAN_DILATION)
+	{
+	if ( (copy = (uint8_t *)front_store_alloc(store, seWidth*seHeight)) == NULL) return MORPHO_ERROR;
+	invert_SE(se, copy, seWidth, seHeight);
+	if ( MORPHO_SUCCESS != se_fronts_init(&plan->dilation, copy, seWidth, seHeight, 
+				seWidth-1-ox, seHeight-1-oy, blocWidth, gray, store) ) return MORPHO_ERROR;
+	}
+
+return MORPHO_SUCCESS;
+}
+
+/*******************************************************************/
+/* Checks that a plan can be used by an operator */
+int is_plan_valid(struct morpho_se_plan *plan, int gray, int imageWidth, int which, char *func)
+{
+char st[200];
+
+if ( (plan == NULL) || (plan->gray != gray) || 
+     ((which & PLAN_EROSION) && (plan->erosion.se == NULL)) ||
+     ((which & PLAN_DILATION) && (plan->dilation.se == NULL)) )
+	{
+	snprintf(st, 200, "ERROR(%s): the plan does not match the operation.", func);
+	perror(st);
+	return MORPHO_ERROR;
+	}
+if (plan->imageWidth != imageWidth)
+	{
+	snprintf(st, 200, "ERROR(%s): the plan was built for images of width %d, not %d.", func, plan->imageWidth, imageWidth);
+	perror(st);
+	return MORPHO_ERROR;
+	}
+return MORPHO_SUCCESS;
+}
+
+/*******************************************************************/
+/* Common part of morpho_se_plan_create and morpho_sf_plan_create */
+static struct morpho_se_plan *plan_create(uint8_t *se, int seWidth, int seHeight, int ox, int oy, int imageWidth, int gray)
+{
+struct	morpho_se_plan *plan;
+struct	front_store store;
+void	*memory;
+size_t	size;
+
+if ( (se == NULL) || (seWidth <= 0) || (seHeight <= 0) || (imageWidth <= 0) )
+	{
+	perror("ERROR(morpho_se_plan_create): invalid structuring element or image width");
+	return NULL;
+	}
+
+size = se_plan_size(seWidth, seHeight, PLAN_EROSION|PLAN_DILATION);
+if ( (plan = (struct morpho_se_plan *)malloc(sizeof(struct morpho_se_plan))) == NULL)
+	{ perror("Malloc"); return NULL; }
+if ( (memory = malloc(size)) == NULL)
+	{ perror("Malloc"); free(plan); return NULL; }
+store.next = (char *)memory;
+store.end = store.next+size;
+
+if ( MORPHO_SUCCESS != se_plan_init(plan, se, seWidth, seHeight, ox, oy, imageWidth, gray, 
+			PLAN_EROSION|PLAN_DILATION, &store) )
+	{
+	perror("ERROR(morpho_se_plan_create): the analysis of the structuring element failed");
+	free(memory); free(plan);
+	return NULL;
+	}
+plan->memory = memory;
+return plan;
+}
+
+/*!
+ * \fn struct morpho_se_plan *morpho_se_plan_create(uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int imageWidth)
+ * \param[in] *se Buffer containing the shape of a structuring element. 
+ * \param[in] seWidth Width of the stucturing element buffer
+ * \param[in] seHeight Height of the stucturing element buffer
+ * \param[in] seHorizontalOrigin Horizontal position of the origin in the structuring element. se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \param[in] seVerticalOrigin Vertical position of the origin in the structuring element. se[seHorizontalOrigin, seVerticalOrigin] must be !=0.
+ * \param[in] imageWidth Width of the images the plan will be applied to
+ * \return Returns a new plan, or NULL upon error.
+ *
+ * \brief Precomputes the fronts of a structuring element
+ *
+ * \ingroup libmorpho
+ *
+ * The functions by an arbitrary structuring element start by analysing 
+ * its fronts and by adapting them to the width of the image; the dilation
+ * also inverts the structuring element. A plan holds the result of these 
+ * steps for both the erosion and the dilation, so that the functions whose
+ * name ends with _plan (\ref erosion_arbitrary_SE_plan, ...) apply the 
+ * same structuring element to many images without any further analysis. 
+ * The plan keeps its own copy of se, and is only valid for images of width
+ * imageWidth. 
+ * It is not modified by the operators and can be shared by several threads.
+ */
+struct morpho_se_plan *morpho_se_plan_create(uint8_t *se, int seWidth, int seHeight, int seHorizontalOrigin, int seVerticalOrigin, int imageWidth)
+{
+return plan_create(se, seWidth, seHeight, seHorizontalOrigin, seVerticalOrigin, imageWidth, 0);
+}
+
+/*!
+ * \fn struct morpho_se_plan *morpho_sf_plan_create(uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int imageWidth)
+ * \param[in] *sf Buffer containing the shape of a structuring function. 
+ * \param[in] sfWidth Width of the stucturing function buffer
+ * \param[in] sfHeight Height of the stucturing function buffer
+ * \param[in] sfHorizontalOrigin Horizontal position of the origin in the structuring function. sf[sfHorizontalOrigin, sfVerticalOrigin] must be !=0.
+ * \param[in] sfVerticalOrigin Vertical position of the origin in the structuring function. sf[sfHorizontalOrigin, sfVerticalOrigin] must be !=0.
+ * \param[in] imageWidth Width of the images the plan will be applied to
+ * \return Returns a new plan, or NULL upon error.
+ *
+ * \brief Precomputes the fronts of a structuring function
+ *
+ * \ingroup libmorpho
+ *
+ * Same as \ref morpho_se_plan_create for the functions by a structuring 
+ * function (\ref erosion_arbitrary_SF_plan, ...).
+ */
+struct morpho_se_plan *morpho_sf_plan_create(uint8_t *sf, int sfWidth, int sfHeight, int sfHorizontalOrigin, int sfVerticalOrigin, int imageWidth)
+{
+return plan_create(sf, sfWidth, sfHeight, sfHorizontalOrigin, sfVerticalOrigin, imageWidth, 1);
+}
+
+/*!
+ * \fn void morpho_se_plan_free(struct morpho_se_plan *plan)
+ * \param[in] plan Plan created by \ref morpho_se_plan_create or \ref morpho_sf_plan_create (may be NULL)
+ * \brief Frees a plan
+ * \ingroup libmorpho
+ */
+void morpho_se_plan_free(struct morpho_se_plan *plan)
+{
+if (plan == NULL) return;
+free(plan->memory);
+free(plan);
+}
@@ -0,0 +1,214 @@
+/* LIBMORPHO
+ *
+ * threadPool.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file threadPool.c
+ */
+
+#include <pthread.h>
+#include "threadPool.h"
+
+/* The pool is shared by the whole library. Workers are created on demand
+ * and stay alive between calls; the calling thread always processes bands
+ * too, so that a pool of n-1 workers serves a request for n threads. */
+static pthread_mutex_t	poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t	submitLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	poolWake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	poolDone = PTHREAD_COND_INITIALIZER;
+
+static pthread_t	*poolThreads = NULL;
+static int		poolSize = 0;
+static int		poolShutdown = 0;
+
+/* Description of the job being processed */
+static morpho_band_task	jobTask = NULL;
+static void		*jobArg = NULL;
+static int		jobBands = 0;
+static int		jobNext = 0;
+static int		jobDone = 0;
+static int		jobStatus = MORPHO_SUCCESS;
+
+static int defaultThreads = 0;
+
+/* Takes bands of the current job until there are none left.
+ * Must be called with poolLock held; returns with poolLock held. */
+static void process_bands(void)
+{
+  morpho_band_task task;
+  void	*arg;
+  int	band, nbrBands, ret;
+
+  while (jobNext < jobBands)
+    {
+      band = jobNext++;
+      task = jobTask; arg = jobArg; nbrBands = jobBands;
+      pthread_mutex_unlock(&poolLock);
+      ret = task(arg, band, nbrBands);
+      pthread_mutex_lock(&poolLock);
+      if (MORPHO_SUCCESS != ret) { jobStatus = MORPHO_ERROR; }
+      jobDone++;
+      if (jobDone == jobBands) { pthread_cond_broadcast(&poolDone); }
+    }
+}
+
+static void *worker(void *unused)
+{
+  pthread_mutex_lock(&poolLock);
+  for (;;)
+    {
+      /* Sleep until some band is left unclaimed */
+      while ( (!poolShutdown) && (jobNext >= jobBands) )
+	{ pthread_cond_wait(&poolWake, &poolLock); }
+      if (poolShutdown) { break; }
+      process_bands();
+    }
+  pthread_mutex_unlock(&poolLock);
+  return NULL;
+}
+
+/* Grows the pool to nbrWorkers threads. Called with poolLock held. */
+static int grow_pool(int nbrWorkers)
+{
+  pthread_t *threads;
+
+  if (nbrWorkers <= poolSize) { return poolSize; }
+  if ((threads=(pthread_t *)realloc(poolThreads, nbrWorkers*sizeof(pthread_t))) == NULL)
+    { return poolSize; }
+  poolThreads = threads;
+  while (poolSize < nbrWorkers)
+    {
+      if (0 != pthread_create(&poolThreads[poolSize], NULL, worker, NULL)) { break; }
+      poolSize++;
+    }
+  return poolSize;
+}
+
+/*!
+ * \fn int morpho_set_num_threads(int nbrThreads)
+ * \param[in]  nbrThreads Number of threads used by the multithreaded functions when they are given a thread count <= 0
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ * \brief Sets the default number of threads
+ * \ingroup libmorpho
+ *
+ * The default is the number of online processors. A value <= 0 restores
+ * that default.
+ */
+int morpho_set_num_threads(int nbrThreads)
+{
+  defaultThreads = (nbrThreads > 0) ? nbrThreads : 0;
+  return MORPHO_SUCCESS;
+}
+
+/*!
+ * \fn int morpho_get_num_threads(void)
+ * \return Returns the default number of threads.
+ * \brief Default number of threads of the multithreaded functions
+ * \ingroup libmorpho
+ */
+int morpho_get_num_threads(void)
+{
+  long n;
+
+  if (defaultThreads > 0) { return defaultThreads; }
+  n = sysconf(_SC_NPROCESSORS_ONLN);
+  return (n > 0) ? (int)n : 1;
+}
+
+/*!
+ * \fn void morpho_release_threads(void)
+ * \brief Stops the worker threads of the library
+ * \ingroup libmorpho
+ *
+ * Worker threads are started the first time a multithreaded function
+ * is called and are kept alive for the next calls. This function terminates
+ * them; they will be recreated if needed. It must not be called while
+ * another thread runs a function of the library.
+ */
+void morpho_release_threads(void)
+{
+  int i, n;
+
+  pthread_mutex_lock(&submitLock);
+  pthread_mutex_lock(&poolLock);
+  poolShutdown = 1;
+  pthread_cond_broadcast(&poolWake);
+  n = poolSize;
+  pthread_mutex_unlock(&poolLock);
+
+  for (i=0; i<n; i++) { pthread_join(poolThreads[i], NULL); }
+
+  pthread_mutex_lock(&poolLock);
+  free(poolThreads);
+  poolThreads = NULL;
+  poolSize = 0;
+  poolShutdown = 0;
+  pthread_mutex_unlock(&poolLock);
+  pthread_mutex_unlock(&submitLock);
+}
+
+/* Number of threads to use for a call: nbrThreads<=0 selects the default,
+ * and there is no need for more threads than lines to process. */
+int morpho_resolve_threads(int nbrThreads, int length)
+{
+  if (nbrThreads <= 0) { nbrThreads = morpho_get_num_threads(); }
+  if (nbrThreads > length) { nbrThreads = length; }
+  if (nbrThreads < 1) { nbrThreads = 1; }
+  return nbrThreads;
+}
+
+/* First line of a band; band "nbrBands" gives the end of the last band */
+int morpho_band_first(int length, int band, int nbrBands)
+{
+  return (int)(((long)length*band)/nbrBands);
+}
+
+/* Runs task(arg, band, nbrBands) for every band, in parallel when possible.
+ * If the pool is busy (concurrent or nested call), the bands are processed
+ * by the calling thread. */
+int morpho_run_bands(morpho_band_task task, void *arg, int nbrBands)
+{
+  int band, status;
+
+  if ( (nbrBands > 1) && (0 == pthread_mutex_trylock(&submitLock)) )
+    {
+      pthread_mutex_lock(&poolLock);
+      if (grow_pool(nbrBands-1) > 0)
+	{
+	  jobTask = task; jobArg = arg; jobBands = nbrBands;
+	  jobNext = 0; jobDone = 0; jobStatus = MORPHO_SUCCESS;
+	  pthread_cond_broadcast(&poolWake);
+	  process_bands();
+	  while (jobDone < jobBands) { pthread_cond_wait(&poolDone, &poolLock); }
+	  status = jobStatus;
+	  jobTask = NULL; jobArg = NULL; jobBands = 0; jobNext = 0;
+	  pthread_mutex_unlock(&poolLock);
+	  pthread_mutex_unlock(&submitLock);
+	  return status;
+	}
+      pthread_mutex_unlock(&poolLock);
+      pthread_mutex_unlock(&submitLock);
+    }
+
+  /* Serial execution */
+  status = MORPHO_SUCCESS;
+  for (band=0; band<nbrBands; band++)
+    if (MORPHO_SUCCESS != task(arg, band, nbrBands)) { status = MORPHO_ERROR; }
+  return status;
+}
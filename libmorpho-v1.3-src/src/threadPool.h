@@ -0,0 +1,35 @@
+/* LIBMORPHO
+ *
+ * threadPool.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "libmorpho.h"
+
+#ifndef __THREADPOOL__
+#define __THREADPOOL__
+
+/* A band task processes band number "band" out of "nbrBands" and returns
+   MORPHO_SUCCESS or MORPHO_ERROR */
+typedef int (*morpho_band_task)(void *arg, int band, int nbrBands);
+
+/* threadPool.c */
+int morpho_run_bands(morpho_band_task task, void *arg, int nbrBands);
+int morpho_band_first(int length, int band, int nbrBands);
+int morpho_resolve_threads(int nbrThreads, int length);
+
+#endif
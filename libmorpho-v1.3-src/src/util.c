@@ -23,6 +23,7 @@
  */ 
 
 #include "libmorpho.h"
+#include "dispatch.h"
 
 /*! 
  * \fn int imageTranspose(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight)
@@ -40,25 +41,13 @@
  * do not use this functions as is. Remember that, after 
  * transposition, the width of the output
  * buffer is given by the height of the input buffer, and vice versa. 
+ * The image is processed by tiles of 16 x 16 pixels, which are transposed
+ * in registers when the processor has SIMD instructions.
  *
  */ 
 int imageTranspose(uint8_t *imageIn, uint8_t *imageOut, int imageWidth, int imageHeight)
 {
-  int x,y;
-  uint8_t	*in, *out;
-
-  in = imageIn;
-
-  for (y=0; y<imageHeight; y++)
-    {
-      out = imageOut+y;
-      for (x=0; x<imageWidth; x++)
- 	{
-	  *out = *in;
-	  in++;
-	  out += imageHeight;
- 	}
-    }
+  morpho_isa->transpose(imageIn, imageWidth, imageOut, imageHeight, imageWidth, imageHeight);
   return MORPHO_SUCCESS;
 }
 
@@ -106,3 +95,30 @@ int is_size_valid_1D(int size, int imageSize, char *func, int odd)
 
   return MORPHO_SUCCESS;
 }
+
+/*! 
+ * \fn int is_stride_valid(int inStride, int outStride, int imageWidth, char *func)
+ * \param[in]  inStride Distance between two rows of the input buffer
+ * \param[in]  outStride Distance between two rows of the output buffer
+ * \param[in]  imageWidth Width of the image
+ * \param[in]  *func The name of the calling function
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ * \brief Checks the strides of the input and output buffers
+ * \ingroup libmorpho
+ * 
+ * This function is used for internal purposes only. Rows may not overlap,
+ * hence both strides should be >= imageWidth.
+ *
+ */
+int is_stride_valid(int inStride, int outStride, int imageWidth, char *func)
+{
+  char st[200];
+
+  if ( (inStride<imageWidth) || (outStride<imageWidth) ) {
+	snprintf(st, 200, "ERROR(%s): strides(=%d,%d) should be >= to the image width(=%d).", func, inStride, outStride, imageWidth);
+	perror(st);
+	return MORPHO_ERROR; 
+  	}
+
+  return MORPHO_SUCCESS;
+}
@@ -0,0 +1,285 @@
+/* LIBMORPHO
+ *
+ * workspace.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*!
+ * \file workspace.c
+ */
+
+#include "workspace.h"
+#include "anchorUtil.h"
+#include "arbitraryUtil.h"
+
+/* Returns a buffer of at least size bytes. Without context, the buffer is
+ * allocated and must be given back to morpho_scratch_release. Otherwise 
+ * the slot of the context is returned, and enlarged if needed. 
+ * Returns NULL if the memory can not be allocated. */
+void *morpho_scratch(struct morpho_ctx *ctx, int slot, size_t size)
+{
+  if (size == 0) { size = 1; }
+  if (ctx == NULL) { return malloc(size); }
+
+  if (size > ctx->slotSize[slot])
+    {
+      free(ctx->slot[slot]);
+      if ((ctx->slot[slot] = malloc(size)) == NULL)
+	{
+	  ctx->slotSize[slot] = 0;
+	  return NULL;
+	}
+      ctx->slotSize[slot] = size;
+    }
+  return ctx->slot[slot];
+}
+
+/* Enlarges to size bytes a buffer obtained by morpho_scratch from slot,
+ * and keeps its content. Returns the buffer, which may have moved, or NULL
+ * if the memory can not be allocated; the buffer is then left unchanged. */
+void *morpho_scratch_grow(struct morpho_ctx *ctx, int slot, void *buffer, size_t size)
+{
+  void	*data;
+
+  if (ctx == NULL) { return realloc(buffer, size); }
+  if (size > ctx->slotSize[slot])
+    {
+      if ((data=realloc(ctx->slot[slot], size)) == NULL) { return NULL; }
+      ctx->slot[slot] = data;
+      ctx->slotSize[slot] = size;
+    }
+  return ctx->slot[slot];
+}
+
+/* Gives back a buffer obtained by morpho_scratch */
+void morpho_scratch_release(struct morpho_ctx *ctx, void *buffer)
+{
+  if (ctx == NULL) { free(buffer); }
+}
+
+/* Makes sure that ctx holds nbrChildren child contexts, with its settings
+ * and nbrThreads threads each. The children are created at the first call
+ * and kept, with their scratch memory, until the context is freed. This
+ * must be called before the bands that use them run. Does nothing without
+ * context. Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise. */
+int morpho_ctx_children(struct morpho_ctx *ctx, int nbrChildren, int nbrThreads)
+{
+  struct morpho_ctx **child;
+  int	i;
+
+  if (ctx == NULL) { return MORPHO_SUCCESS; }
+  if (nbrChildren > ctx->nbrChildren)
+    {
+      if ((child=(struct morpho_ctx **)realloc(ctx->child, nbrChildren*sizeof(struct morpho_ctx *))) == NULL) {
+	perror("Malloc");
+	return MORPHO_ERROR;
+      }
+      ctx->child = child;
+      for (; ctx->nbrChildren<nbrChildren; ctx->nbrChildren++)
+	{
+	  if ((child[ctx->nbrChildren]=morpho_ctx_create(0, 0, 0, 0)) == NULL) { return MORPHO_ERROR; }
+	}
+    }
+  for (i=0; i<nbrChildren; i++)
+    {
+      ctx->child[i]->nbrThreads = nbrThreads;
+      ctx->child[i]->histogram = ctx->histogram;
+      ctx->child[i]->engine = ctx->engine;
+    }
+  return MORPHO_SUCCESS;
+}
+
+/* Child context index of ctx (see morpho_ctx_children), NULL without context */
+struct morpho_ctx *morpho_ctx_child(struct morpho_ctx *ctx, int index)
+{
+  return (ctx == NULL) ? NULL : ctx->child[index];
+}
+
+/*!
+ * \fn struct morpho_ctx *morpho_ctx_create(int maxWidth, int maxHeight, int maxSeWidth, int maxSeHeight)
+ * \param[in]  maxWidth Largest width of the images that will be processed
+ * \param[in]  maxHeight Largest height of the images that will be processed
+ * \param[in]  maxSeWidth Largest width of the structuring elements (or segments) that will be used
+ * \param[in]  maxSeHeight Largest height of the structuring elements (or segments) that will be used
+ * \return Returns a new context, or NULL if the memory can not be allocated.
+ *
+ * \brief Creates an execution context holding reusable scratch memory
+ *
+ * \ingroup libmorpho
+ *
+ * The functions whose name ends with _ctx take a context as last argument.
+ * They take their temporary buffers from the context instead of allocating
+ * and freeing them at each call, so that once the context is large enough
+ * the processing of a frame does not allocate any memory. The buffers are
+ * allocated here for images up to maxWidth * maxHeight and structuring
+ * elements up to maxSeWidth * maxSeHeight; a call with larger arguments
+ * enlarges them once. The queues of the reconstructions are allocated at
+ * their first call. Zero sizes create an empty context that grows on
+ * demand.
+ *
+ * A context must not be used by two threads at the same time. Operators
+ * called with a context run on a single thread unless
+ * \ref morpho_ctx_set_num_threads is used.
+ */
+struct morpho_ctx *morpho_ctx_create(int maxWidth, int maxHeight, int maxSeWidth, int maxSeHeight)
+{
+  struct morpho_ctx *ctx;
+  size_t lines, ring;
+  int	 ok;
+
+  if ((ctx=(struct morpho_ctx *)calloc(1, sizeof(struct morpho_ctx))) == NULL) {
+    perror("Malloc");
+    return NULL;
+  }
+  ctx->nbrThreads = 1;
+  ctx->histogram = MORPHO_HISTOGRAM_LINEAR;
+  ctx->engine = MORPHO_ENGINE_AUTO;
+  if ( (maxWidth <= 0) || (maxHeight <= 0) ) { return ctx; }
+  if (maxSeWidth < 0) { maxSeWidth = 0; }
+  if (maxSeHeight < 0) { maxSeHeight = 0; }
+
+  lines = (size_t)2*ANCHOR_COLUMN_BLOCK*maxHeight;
+  if (lines < (size_t)3*(maxWidth+maxSeWidth)) { lines = (size_t)3*(maxWidth+maxSeWidth); }
+  /* Two rings (minima and maxima), two rows and the line kernel of 
+     gradientByAnchor.c */
+  ring = (size_t)2*(2*maxSeHeight+2)*maxWidth+(size_t)5*(maxWidth+maxSeWidth);
+  ok = (NULL != morpho_scratch(ctx, MORPHO_SLOT_HISTO, 256*sizeof(int)));
+  ok = ok && (NULL != morpho_scratch(ctx, MORPHO_SLOT_LINES, (lines > ring) ? lines : ring));
+  ok = ok && (NULL != morpho_scratch(ctx, MORPHO_SLOT_IMAGE, (size_t)maxWidth*maxHeight*sizeof(int16_t)));
+  ok = ok && (NULL != morpho_scratch(ctx, MORPHO_SLOT_BORDER, 
+				     volume_scratch_size(maxWidth, maxHeight, maxSeWidth, maxSeHeight)));
+  ok = ok && (NULL != morpho_scratch(ctx, MORPHO_SLOT_FRONTS, se_plan_size(maxSeWidth, maxSeHeight, PLAN_EROSION)));
+  if (!ok) {
+    perror("Malloc");
+    morpho_ctx_free(ctx);
+    return NULL;
+  }
+  return ctx;
+}
+
+/*!
+ * \fn void morpho_ctx_free(struct morpho_ctx *ctx)
+ * \param[in]  ctx Context created by \ref morpho_ctx_create (may be NULL)
+ * \brief Frees a context and its scratch memory
+ * \ingroup libmorpho
+ */
+void morpho_ctx_free(struct morpho_ctx *ctx)
+{
+  int i;
+
+  if (ctx == NULL) { return; }
+  for (i=0; i<MORPHO_NBR_SLOTS; i++) { free(ctx->slot[i]); }
+  for (i=0; i<ctx->nbrChildren; i++) { morpho_ctx_free(ctx->child[i]); }
+  free(ctx->child);
+  free(ctx);
+}
+
+/*!
+ * \fn int morpho_ctx_set_num_threads(struct morpho_ctx *ctx, int nbrThreads)
+ * \param[in]  ctx Context created by \ref morpho_ctx_create
+ * \param[in]  nbrThreads Number of threads used by the operators called with this context (<= 0 selects \ref morpho_get_num_threads)
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ * \brief Sets the number of threads of the operators called with a context
+ * \ingroup libmorpho
+ *
+ * The operators by an arbitrary structuring element or function split
+ * their output rows into bands processed in parallel by the worker threads
+ * of the library. The result does not depend on the number of threads.
+ */
+int morpho_ctx_set_num_threads(struct morpho_ctx *ctx, int nbrThreads)
+{
+  if (ctx == NULL) { return MORPHO_ERROR; }
+  ctx->nbrThreads = nbrThreads;
+  return MORPHO_SUCCESS;
+}
+
+/* Number of threads requested for the operators called with ctx */
+int morpho_ctx_threads(struct morpho_ctx *ctx)
+{
+  return (ctx == NULL) ? 1 : ctx->nbrThreads;
+}
+
+/*!
+ * \fn int morpho_ctx_set_histogram(struct morpho_ctx *ctx, int histogram)
+ * \param[in]  ctx Context created by \ref morpho_ctx_create
+ * \param[in]  histogram MORPHO_HISTOGRAM_LINEAR or MORPHO_HISTOGRAM_BITMAP
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ * \brief Selects the histogram used by the operators called with a context
+ * \ingroup libmorpho
+ *
+ * After each update of its histogram, an operator looks for the new 
+ * minimum (or maximum). MORPHO_HISTOGRAM_LINEAR walks the histogram from 
+ * the previous extremum, which is fast when the extremum moves little. 
+ * MORPHO_HISTOGRAM_BITMAP also maintains a bitmap of the non-empty entries 
+ * and finds the extremum with a bit scan, so that its cost does not depend 
+ * on the distance between two extrema; it helps on textured images, 
+ * especially for structuring functions whose histogram has 767 entries, 
+ * at the price of a slightly more expensive update. The engine applies to 
+ * the operators by an arbitrary structuring element or function and to the 
+ * histogram fallback of the anchor operators. The result does not depend 
+ * on it.
+ */
+int morpho_ctx_set_histogram(struct morpho_ctx *ctx, int histogram)
+{
+  if (ctx == NULL) { return MORPHO_ERROR; }
+  if ( (histogram != MORPHO_HISTOGRAM_LINEAR) && (histogram != MORPHO_HISTOGRAM_BITMAP) ) {
+    perror("ERROR(morpho_ctx_set_histogram): unknown histogram");
+    return MORPHO_ERROR;
+  }
+  ctx->histogram = histogram;
+  return MORPHO_SUCCESS;
+}
+
+/* Histogram engine requested for the operators called with ctx */
+int morpho_ctx_histogram(struct morpho_ctx *ctx)
+{
+  return (ctx == NULL) ? MORPHO_HISTOGRAM_LINEAR : ctx->histogram;
+}
+
+/*!
+ * \fn int morpho_ctx_set_engine(struct morpho_ctx *ctx, int engine)
+ * \param[in]  ctx Context created by \ref morpho_ctx_create
+ * \param[in]  engine MORPHO_ENGINE_AUTO, MORPHO_ENGINE_ANCHOR or MORPHO_ENGINE_VHGW
+ * \return Returns MORPHO_SUCCESS upon success, MORPHO_ERROR otherwise.
+ * \brief Selects the algorithm of the erosions and dilations by a segment called with a context
+ * \ingroup libmorpho
+ *
+ * The anchors are fast on smooth images but fall back to a histogram on 
+ * textured ones, where their throughput drops. The van Herk/Gil-Werman 
+ * algorithm costs three comparisons per pixel whatever the image and the
+ * size of the segment. MORPHO_ENGINE_AUTO chooses between both at each 
+ * call from the size of the segment and a sample of the input image. The
+ * engine applies to the erosions and dilations by an horizontal or vertical
+ * segment, and to those by a rectangle that are computed with them. The 
+ * result does not depend on it.
+ */
+int morpho_ctx_set_engine(struct morpho_ctx *ctx, int engine)
+{
+  if (ctx == NULL) { return MORPHO_ERROR; }
+  if ( (engine != MORPHO_ENGINE_AUTO) && (engine != MORPHO_ENGINE_ANCHOR) && (engine != MORPHO_ENGINE_VHGW) ) {
+    perror("ERROR(morpho_ctx_set_engine): unknown engine");
+    return MORPHO_ERROR;
+  }
+  ctx->engine = engine;
+  return MORPHO_SUCCESS;
+}
+
+/* Engine requested for the erosions and dilations by a segment called with ctx */
+int morpho_ctx_engine(struct morpho_ctx *ctx)
+{
+  return (ctx == NULL) ? MORPHO_ENGINE_AUTO : ctx->engine;
+}
@@ -0,0 +1,64 @@
+/* LIBMORPHO
+ *
+ * workspace.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU  General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ * You should have received a copy of the GNU  General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "libmorpho.h"
+
+#ifndef __WORKSPACE__
+#define __WORKSPACE__
+
+/* Scratch buffers of a context. A function only uses the slots of its own
+   level, so that an operator may call other operators with the same
+   context: composite operators (2D, openings, closings) use
+   MORPHO_SLOT_IMAGE only, the operators they call never use it. Operators
+   that run composite operators in parallel bands (granulometries) give 
+   each band a child context, see morpho_ctx_children. */
+enum	morpho_slot
+	{
+	MORPHO_SLOT_HISTO,	/* histograms */
+	MORPHO_SLOT_LINES,	/* column blocks, ring buffers */
+	MORPHO_SLOT_IMAGE,	/* intermediate image of a composite operator */
+	MORPHO_SLOT_BORDER,	/* border strips of an image */
+	MORPHO_SLOT_FRONTS,	/* analysis of a structuring element */
+	MORPHO_SLOT_QUEUE,	/* queues of the propagations (reconstructions) */
+	MORPHO_NBR_SLOTS
+	};
+
+struct	morpho_ctx
+	{
+	void	*slot[MORPHO_NBR_SLOTS];
+	size_t	slotSize[MORPHO_NBR_SLOTS];
+	int	nbrThreads;	/* <= 0 selects morpho_get_num_threads() */
+	int	histogram;	/* MORPHO_HISTOGRAM_LINEAR or MORPHO_HISTOGRAM_BITMAP */
+	int	engine;		/* MORPHO_ENGINE_AUTO, _ANCHOR or _VHGW */
+	struct morpho_ctx **child;	/* contexts of the bands, kept between calls */
+	int	nbrChildren;
+	};
+
+/* workspace.c */
+void *morpho_scratch(struct morpho_ctx *ctx, int slot, size_t size);
+void *morpho_scratch_grow(struct morpho_ctx *ctx, int slot, void *buffer, size_t size);
+void morpho_scratch_release(struct morpho_ctx *ctx, void *buffer);
+int morpho_ctx_children(struct morpho_ctx *ctx, int nbrChildren, int nbrThreads);
+struct morpho_ctx *morpho_ctx_child(struct morpho_ctx *ctx, int index);
+int morpho_ctx_threads(struct morpho_ctx *ctx);
+int morpho_ctx_histogram(struct morpho_ctx *ctx);
+int morpho_ctx_engine(struct morpho_ctx *ctx);
+
+#endif